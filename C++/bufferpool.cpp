@@ -0,0 +1,519 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/*
+   The committers of the libsocket project, all rights reserved
+   (c) 2012, dermesser <lbo@spheniscida.de>
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS” AND ANY
+   EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+   DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+/**
+ * @file bufferpool.cpp
+ * @brief Slab pool of fixed-size buffers.
+ *
+ * 	buffer_pool maps slabs of equally sized buffers and keeps released
+ * 	buffers in a per-thread cache first and in a shared free list beyond
+ * 	that.
+ *
+ * @addtogroup libsocketplusplus
+ * @{
+ */
+
+#include <conf.h>
+
+#include <bufferpool.hpp>
+#include <exception.hpp>
+
+namespace libsocket {
+
+// Buffers are placed at multiples of this, so they do not share cache lines.
+static const size_t buffer_alignment = 64;
+
+struct buffer_block {
+    std::atomic<size_t> refs;  ///< Handles referring to the buffer
+    size_t size;               ///< Valid bytes
+    char* data;
+    buffer_pool_state* pool;
+    buffer_block* next;  ///< In a free list
+};
+
+struct buffer_slab {
+    void* memory;
+    size_t length;
+    std::unique_ptr<buffer_block[]> blocks;
+};
+
+struct buffer_pool_state {
+    buffer_pool::settings set;
+    uint64_t id;        ///< Unique for the lifetime of the process
+    size_t stride;      ///< Distance between buffers
+    size_t per_slab;    ///< Buffers per slab
+    size_t batch;       ///< Buffers moved to/from a thread's cache at once
+    std::atomic<bool> closed;  ///< The buffer_pool has been destroyed
+
+    std::mutex lock;  ///< Protects the following
+    std::vector<buffer_slab> slabs;
+    buffer_block* free_list;
+    size_t free_count;
+    /// 1 for the buffer_pool, plus 1 for every buffer not in `free_list`
+    size_t refs;
+};
+
+/*
+ * The released buffers of one pool in a thread's cache. `pool` is only
+ * dereferenced while `count` is non-zero; the cached buffers keep it alive.
+ */
+struct thread_buffers {
+    buffer_pool_state* pool;
+    uint64_t id;
+    buffer_block* head;
+    size_t count;
+};
+
+struct thread_caches {
+    std::vector<thread_buffers> pools;
+
+    ~thread_caches(void);
+};
+
+static std::atomic<uint64_t> next_pool_id(0);
+
+// Set when the calling thread's cache has been destroyed (at thread exit).
+static thread_local bool thread_caches_gone = false;
+static thread_local thread_caches caches;
+// The entry of `caches` used last; checked before searching.
+static thread_local thread_buffers* last_cache = nullptr;
+
+static void destroy_state(buffer_pool_state* st) {
+    for (size_t i = 0; i < st->slabs.size(); i++)
+        munmap(st->slabs[i].memory, st->slabs[i].length);
+
+    delete st;
+}
+
+/*
+ * Puts the `n` buffers starting at `head` back into the shared list and
+ * frees the state if that was the last reference.
+ */
+static void return_blocks(buffer_pool_state* st, buffer_block* head,
+                          size_t n) {
+    bool last;
+
+    {
+        std::lock_guard<std::mutex> guard(st->lock);
+
+        while (head != nullptr) {
+            buffer_block* next = head->next;
+
+            head->next = st->free_list;
+            st->free_list = head;
+            head = next;
+        }
+
+        st->free_count += n;
+        st->refs -= n;
+        last = st->refs == 0;
+    }
+
+    if (last) destroy_state(st);
+}
+
+// Moves the first `n` buffers of `c` to the shared list.
+static void flush(thread_buffers& c, size_t n) {
+    buffer_block* head = c.head;
+    buffer_block* tail = head;
+
+    for (size_t i = 1; i < n; i++) tail = tail->next;
+
+    c.head = tail->next;
+    c.count -= n;
+    tail->next = nullptr;
+
+    return_blocks(c.pool, head, n);
+}
+
+thread_caches::~thread_caches(void) {
+    for (size_t i = 0; i < pools.size(); i++)
+        if (pools[i].count > 0) flush(pools[i], pools[i].count);
+
+    thread_caches_gone = true;
+    last_cache = nullptr;
+}
+
+/*
+ * Gives back the buffers the calling thread has cached for pools other than
+ * `st` that have been destroyed in the meantime.
+ */
+static void give_back_closed(const buffer_pool_state* st) {
+    std::vector<thread_buffers>& pools = caches.pools;
+
+    for (size_t i = 0; i < pools.size(); i++) {
+        thread_buffers& c = pools[i];
+
+        if (c.count > 0 && c.pool != st &&
+            c.pool->closed.load(std::memory_order_acquire))
+            flush(c, c.count);
+    }
+}
+
+/*
+ * The calling thread's cache for `st`.
+ */
+static thread_buffers& cache_for(buffer_pool_state* st) {
+    thread_buffers* last = last_cache;
+
+    if (last != nullptr && last->pool == st && last->id == st->id)
+        return *last;
+
+    give_back_closed(st);
+
+    std::vector<thread_buffers>& pools = caches.pools;
+    thread_buffers* found = nullptr;
+    thread_buffers* unused = nullptr;
+
+    for (size_t i = 0; i < pools.size(); i++) {
+        thread_buffers& c = pools[i];
+
+        if (c.pool == st && c.id == st->id)
+            found = &c;
+        else if (c.count == 0 && unused == nullptr)
+            unused = &c;
+    }
+
+    if (found != nullptr) {
+        last_cache = found;
+        return *found;
+    }
+
+    if (unused == nullptr) {
+        pools.push_back(thread_buffers());
+        unused = &pools.back();
+    }
+
+    unused->pool = st;
+    unused->id = st->id;
+    unused->head = nullptr;
+    unused->count = 0;
+    last_cache = unused;
+
+    return *unused;
+}
+
+/*
+ * Maps a new slab and puts its buffers into the shared list. Called with
+ * the lock held.
+ */
+static void add_slab(buffer_pool_state* st) {
+    if (st->set.max_slabs > 0 && st->slabs.size() >= st->set.max_slabs)
+        throw socket_exception(__FILE__, __LINE__,
+                               "buffer_pool::get() - Pool exhausted!", false);
+
+    size_t length = st->per_slab * st->stride;
+    void* memory = MAP_FAILED;
+
+#if LIBSOCKET_LINUX && defined(MAP_HUGETLB)
+    if (st->set.hugepages)
+        memory = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+    if (memory == MAP_FAILED) {
+        memory = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (memory == MAP_FAILED)
+            throw socket_exception(__FILE__, __LINE__,
+                                   "buffer_pool::get() - Could not map slab!");
+#if LIBSOCKET_LINUX && defined(MADV_HUGEPAGE)
+        if (st->set.hugepages) madvise(memory, length, MADV_HUGEPAGE);
+#endif
+    }
+
+    buffer_slab slab;
+
+    slab.memory = memory;
+    slab.length = length;
+    slab.blocks.reset(new buffer_block[st->per_slab]);
+
+    for (size_t i = st->per_slab; i-- > 0;) {
+        buffer_block& b = slab.blocks[i];
+
+        b.refs.store(0, std::memory_order_relaxed);
+        b.size = 0;
+        b.data = static_cast<char*>(memory) + i * st->stride;
+        b.pool = st;
+        b.next = st->free_list;
+        st->free_list = &b;
+    }
+
+    st->free_count += st->per_slab;
+    st->slabs.push_back(std::move(slab));
+}
+
+/*
+ * Takes up to `n` buffers from the shared list (at least one, mapping a new
+ * slab if necessary). Returns the number taken; `*head` is the first.
+ */
+static size_t take_blocks(buffer_pool_state* st, size_t n,
+                          buffer_block** head) {
+    std::lock_guard<std::mutex> guard(st->lock);
+
+    if (st->free_list == nullptr) add_slab(st);
+
+    buffer_block* tail = st->free_list;
+    size_t taken = 1;
+
+    while (taken < n && tail->next != nullptr) {
+        tail = tail->next;
+        taken++;
+    }
+
+    *head = st->free_list;
+    st->free_list = tail->next;
+    tail->next = nullptr;
+
+    st->free_count -= taken;
+    st->refs += taken;
+
+    return taken;
+}
+
+// A buffer's last handle is gone.
+static void put_back(buffer_block* b) {
+    buffer_pool_state* st = b->pool;
+
+    if (st->set.thread_cache == 0 || thread_caches_gone ||
+        st->closed.load(std::memory_order_acquire)) {
+        b->next = nullptr;
+        return_blocks(st, b, 1);
+        return;
+    }
+
+    thread_buffers& c = cache_for(st);
+
+    b->next = c.head;
+    c.head = b;
+    c.count++;
+
+    if (c.count > st->set.thread_cache) flush(c, st->batch);
+}
+
+pooled_buffer::pooled_buffer(const pooled_buffer& other) : block(other.block) {
+    if (block != nullptr) block->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+pooled_buffer& pooled_buffer::operator=(const pooled_buffer& other) {
+    if (other.block != nullptr)
+        other.block->refs.fetch_add(1, std::memory_order_relaxed);
+
+    reset();
+    block = other.block;
+
+    return *this;
+}
+
+pooled_buffer& pooled_buffer::operator=(pooled_buffer&& other) {
+    if (this != &other) {
+        reset();
+        block = other.block;
+        other.block = nullptr;
+    }
+
+    return *this;
+}
+
+/// The buffer; NULL for an empty handle.
+char* pooled_buffer::data(void) const {
+    return block != nullptr ? block->data : nullptr;
+}
+
+/// The number of valid bytes.
+size_t pooled_buffer::size(void) const {
+    return block != nullptr ? block->size : 0;
+}
+
+/// The size of the buffer; the pool's `buffer_size`.
+size_t pooled_buffer::capacity(void) const {
+    return block != nullptr ? block->pool->set.buffer_size : 0;
+}
+
+/**
+ * @brief Set the number of valid bytes.
+ *
+ * The contents are not changed.
+ *
+ * @throws socket_exception If `n` exceeds `capacity()`.
+ */
+void pooled_buffer::resize(size_t n) {
+    if (n > capacity())
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "pooled_buffer::resize() - Size exceeds capacity!", false);
+
+    if (block != nullptr) block->size = n;
+}
+
+/// The number of handles referring to the buffer; 0 for an empty handle.
+size_t pooled_buffer::use_count(void) const {
+    return block != nullptr ? block->refs.load(std::memory_order_relaxed) : 0;
+}
+
+/**
+ * @brief Drop the reference to the buffer.
+ *
+ * The buffer goes back to its pool if this was the last handle.
+ */
+void pooled_buffer::reset(void) {
+    if (block == nullptr) return;
+
+    // With a single handle, nobody else can change the count.
+    if (block->refs.load(std::memory_order_acquire) == 1 ||
+        block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        put_back(block);
+
+    block = nullptr;
+}
+
+/**
+ * @brief A pool with the default settings (2 KiB buffers, 2 MiB slabs).
+ */
+buffer_pool::buffer_pool(void) : buffer_pool(settings()) {}
+
+/**
+ * @brief A pool with the given settings.
+ *
+ * No memory is mapped until the first `get()`.
+ */
+buffer_pool::buffer_pool(const settings& s) : state(nullptr) {
+    if (s.buffer_size == 0)
+        throw socket_exception(__FILE__, __LINE__,
+                               "buffer_pool::buffer_pool() - Buffer size is 0!",
+                               false);
+
+    size_t page = sysconf(_SC_PAGESIZE);
+    std::unique_ptr<buffer_pool_state> st(new buffer_pool_state);
+
+    st->set = s;
+    st->id = next_pool_id.fetch_add(1, std::memory_order_relaxed);
+    st->stride = (s.buffer_size + buffer_alignment - 1) / buffer_alignment *
+                 buffer_alignment;
+
+    // Round the slab up to whole pages, and use the whole last page.
+    size_t length = s.slab_size < st->stride ? st->stride : s.slab_size;
+
+    length = (length + page - 1) / page * page;
+
+    st->per_slab = length / st->stride;
+    st->batch = s.thread_cache > 1 ? s.thread_cache / 2 : 1;
+    st->closed.store(false, std::memory_order_relaxed);
+    st->free_list = nullptr;
+    st->free_count = 0;
+    st->refs = 1;
+
+    state = st.release();
+}
+
+/**
+ * @brief Destroy the pool.
+ *
+ * The slabs are unmapped when the last buffer has been released.
+ */
+buffer_pool::~buffer_pool(void) {
+    state->closed.store(true, std::memory_order_release);
+
+    if (!thread_caches_gone) {
+        thread_buffers& c = cache_for(state);
+
+        if (c.count > 0) flush(c, c.count);
+    }
+
+    bool last;
+
+    {
+        std::lock_guard<std::mutex> guard(state->lock);
+
+        last = --state->refs == 0;
+    }
+
+    if (last) destroy_state(state);
+}
+
+/**
+ * @brief Get a buffer.
+ *
+ * Its size is 0.
+ *
+ * @throws socket_exception If `max_slabs` slabs are in use, or a new slab could
+ * not be mapped.
+ */
+pooled_buffer buffer_pool::get(void) {
+    buffer_block* b;
+
+    if (state->set.thread_cache == 0 || thread_caches_gone) {
+        take_blocks(state, 1, &b);
+    } else {
+        thread_buffers& c = cache_for(state);
+
+        if (c.count == 0) {
+            give_back_closed(state);
+            c.count = take_blocks(state, state->batch, &c.head);
+        }
+
+        b = c.head;
+        c.head = b->next;
+        c.count--;
+    }
+
+    b->refs.store(1, std::memory_order_relaxed);
+    b->size = 0;
+    b->next = nullptr;
+
+    return pooled_buffer(b);
+}
+
+/// The size of the buffers.
+size_t buffer_pool::buffer_size(void) const { return state->set.buffer_size; }
+
+/// The number of slabs mapped.
+size_t buffer_pool::slabs(void) const {
+    std::lock_guard<std::mutex> guard(state->lock);
+
+    return state->slabs.size();
+}
+
+/// The number of buffers in the shared free list (not in threads' caches).
+size_t buffer_pool::available(void) const {
+    std::lock_guard<std::mutex> guard(state->lock);
+
+    return state->free_count;
+}
+}  // namespace libsocket
+
+/**
+ * @}
+ */
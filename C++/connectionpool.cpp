@@ -0,0 +1,426 @@
+#include <errno.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+   The committers of the libsocket project, all rights reserved
+   (c) 2012, dermesser <lbo@spheniscida.de>
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS” AND ANY
+   EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+   DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+/**
+ * @file connectionpool.cpp
+ * @brief Reusing idle stream connections.
+ *
+ * 	connection_pool keeps idle inet_stream and unix_stream_client
+ * 	connections per endpoint, in a per-thread list first and in a
+ * 	shared list beyond that.
+ *
+ * @addtogroup libsocketplusplus
+ * @{
+ */
+
+#include <connectionpool.hpp>
+#include <exception.hpp>
+#include <inetclientstream.hpp>
+#include <timerwheel.hpp>
+#include <unixclientstream.hpp>
+
+namespace libsocket {
+using std::string;
+
+// `proto` of UNIX endpoints; the path is stored as host.
+static const int unix_endpoint = -1;
+
+struct idle_connection {
+    std::unique_ptr<stream_client_socket> sock;
+    uint64_t created;     ///< Microseconds, CLOCK_MONOTONIC
+    uint64_t idle_since;  ///< Microseconds, CLOCK_MONOTONIC
+};
+
+struct connection_pool_state {
+    connection_pool::limits lim;
+
+    std::mutex lock;  ///< Protects `idle`
+    std::unordered_map<string, std::deque<idle_connection>> idle;
+};
+
+/*
+ * A connection in a thread's own list. `owner` identifies the pool; it is
+ * only compared while `pool` has not expired.
+ */
+struct cached_connection {
+    std::weak_ptr<connection_pool_state> pool;
+    const connection_pool_state* owner;
+    string key;
+    idle_connection conn;
+};
+
+// Newest at the back. Destroyed, and the connections closed, at thread exit.
+static thread_local std::vector<cached_connection> thread_connections;
+
+// Connections made with different socket flags (e.g. SOCK_NONBLOCK) are not
+// interchangeable, so the flags are part of the key.
+static string endpoint_key(const string& host, const string& port, int proto,
+                           int flags) {
+    string key(1, static_cast<char>('0' + proto + 1));
+
+    key += std::to_string(flags);
+    key += '\0';
+    key += host;
+    key += '\0';
+    key += port;
+
+    return key;
+}
+
+/*
+ * Whether an idle connection may be handed out: within the limits, not closed
+ * by the peer and without unread data.
+ */
+static bool usable(const idle_connection& conn,
+                   const connection_pool::limits& lim, uint64_t now) {
+    if (now - conn.created >= lim.max_age_ms * 1000) return false;
+    if (now - conn.idle_since >= lim.max_idle_ms * 1000) return false;
+
+    char c;
+    ssize_t n =
+        ::recv(conn.sock->getfd(), &c, 1, MSG_PEEK | MSG_DONTWAIT);
+
+    return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
+/// Empty lease.
+connection_pool::lease::lease(void)
+    : proto(0), flags(0), created(0), was_reused(false) {}
+
+connection_pool::lease::lease(lease&& other)
+    : pool(std::move(other.pool)),
+      host(std::move(other.host)),
+      port(std::move(other.port)),
+      proto(other.proto),
+      flags(other.flags),
+      sock(std::move(other.sock)),
+      created(other.created),
+      was_reused(other.was_reused) {}
+
+/**
+ * @brief Return the current connection (if any) to its pool and take over
+ * `other`'s.
+ */
+connection_pool::lease& connection_pool::lease::operator=(lease&& other) {
+    if (this != &other) {
+        connection_pool::put_back(*this);
+
+        pool = std::move(other.pool);
+        host = std::move(other.host);
+        port = std::move(other.port);
+        proto = other.proto;
+        flags = other.flags;
+        sock = std::move(other.sock);
+        created = other.created;
+        was_reused = other.was_reused;
+    }
+
+    return *this;
+}
+
+/**
+ * @brief Return the connection to the pool.
+ */
+connection_pool::lease::~lease(void) { connection_pool::put_back(*this); }
+
+/**
+ * @brief Close the connection instead of returning it to the pool.
+ */
+void connection_pool::lease::discard(void) { sock.reset(); }
+
+/**
+ * @brief Take the connection out of the pool's management; it is not returned
+ * when the lease is destroyed.
+ */
+std::unique_ptr<stream_client_socket> connection_pool::lease::release(void) {
+    return std::move(sock);
+}
+
+/// Pool with the default limits.
+connection_pool::connection_pool(void)
+    : state(std::make_shared<connection_pool_state>()) {}
+
+/// Pool with the given limits.
+connection_pool::connection_pool(const limits& lim)
+    : state(std::make_shared<connection_pool_state>()) {
+    state->lim = lim;
+}
+
+/**
+ * @brief Close all idle connections in the shared list.
+ *
+ * Leases still out close their connections when they are destroyed.
+ */
+connection_pool::~connection_pool(void) {}
+
+/**
+ * @brief Get a TCP connection to `host`:`port`.
+ *
+ * New connections are made with `inet_stream(host, port, proto_osi3,
+ * flags)`, which throws if the connection fails.
+ *
+ * @param host Remote host
+ * @param port Remote port
+ * @param proto_osi3 `LIBSOCKET_IPv4` or `LIBSOCKET_IPv6` or `LIBSOCKET_BOTH`
+ * @param flags Flags for `socket(2)` for new connections
+ */
+connection_pool::lease connection_pool::get_inet(const string& host,
+                                                 const string& port,
+                                                 int proto_osi3, int flags) {
+    if (proto_osi3 != LIBSOCKET_IPv4 && proto_osi3 != LIBSOCKET_IPv6 &&
+        proto_osi3 != LIBSOCKET_BOTH)
+        throw socket_exception(__FILE__, __LINE__,
+                               "connection_pool::get_inet() - Unknown "
+                               "protocol!",
+                               false);
+
+    return get(host, port, proto_osi3, flags);
+}
+
+/**
+ * @brief Get a connection to the UNIX stream socket at `path`.
+ *
+ * @param path Path of the server socket
+ * @param flags Flags for `socket(2)` for new connections
+ */
+connection_pool::lease connection_pool::get_unix(const string& path,
+                                                 int flags) {
+    return get(path, string(), unix_endpoint, flags);
+}
+
+/**
+ * @brief Number of idle connections in the shared list and in the calling
+ * thread's list.
+ */
+size_t connection_pool::idle(void) const {
+    size_t n = 0;
+
+    for (const cached_connection& c : thread_connections)
+        if (c.owner == state.get() && !c.pool.expired()) n++;
+
+    std::lock_guard<std::mutex> guard(state->lock);
+
+    for (const auto& endpoint : state->idle) n += endpoint.second.size();
+
+    return n;
+}
+
+/**
+ * @brief Close idle connections that have exceeded `max_idle_ms` or
+ * `max_age_ms`.
+ *
+ * Affects the shared list and the calling thread's list. Not necessary for
+ * correctness -- such connections are never handed out -- but frees their
+ * file descriptors early; call it from time to time if the pool is idle.
+ */
+void connection_pool::prune(void) {
+    uint64_t now = timer_wheel::now();
+    std::vector<idle_connection> expired;
+    const limits& lim = state->lim;
+
+    auto too_old = [&lim, now](const idle_connection& conn) {
+        return now - conn.created >= lim.max_age_ms * 1000 ||
+               now - conn.idle_since >= lim.max_idle_ms * 1000;
+    };
+
+    for (size_t i = thread_connections.size(); i-- > 0;) {
+        cached_connection& c = thread_connections[i];
+
+        if (c.pool.expired() ||
+            (c.owner == state.get() && too_old(c.conn)))
+            thread_connections.erase(thread_connections.begin() + i);
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(state->lock);
+
+        for (auto it = state->idle.begin(); it != state->idle.end();) {
+            std::deque<idle_connection>& q = it->second;
+
+            // Oldest at the front.
+            while (!q.empty() && too_old(q.front())) {
+                expired.push_back(std::move(q.front()));
+                q.pop_front();
+            }
+
+            if (q.empty())
+                it = state->idle.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    // `expired` closes the connections here, outside the lock.
+}
+
+connection_pool::lease connection_pool::get(const string& host,
+                                            const string& port, int proto,
+                                            int flags) {
+    const string key = endpoint_key(host, port, proto, flags);
+    const limits& lim = state->lim;
+    uint64_t now = timer_wheel::now();
+
+    lease l;
+
+    l.pool = state;
+    l.host = host;
+    l.port = port;
+    l.proto = proto;
+    l.flags = flags;
+
+    // The thread's own list, newest first, without locking.
+    for (size_t i = thread_connections.size(); i-- > 0;) {
+        cached_connection& c = thread_connections[i];
+
+        if (c.pool.expired()) {
+            thread_connections.erase(thread_connections.begin() + i);
+            continue;
+        }
+        if (c.owner != state.get() || c.key != key) continue;
+
+        idle_connection conn = std::move(c.conn);
+
+        thread_connections.erase(thread_connections.begin() + i);
+
+        if (usable(conn, lim, now)) {
+            l.sock = std::move(conn.sock);
+            l.created = conn.created;
+            l.was_reused = true;
+
+            return l;
+        }
+    }
+
+    // The shared list, newest first. The check is done outside the lock.
+    while (true) {
+        idle_connection conn;
+
+        {
+            std::lock_guard<std::mutex> guard(state->lock);
+            auto it = state->idle.find(key);
+
+            if (it == state->idle.end() || it->second.empty()) break;
+
+            conn = std::move(it->second.back());
+            it->second.pop_back();
+        }
+
+        if (usable(conn, lim, now)) {
+            l.sock = std::move(conn.sock);
+            l.created = conn.created;
+            l.was_reused = true;
+
+            return l;
+        }
+    }
+
+    if (proto == unix_endpoint)
+        l.sock.reset(new unix_stream_client(host, flags));
+    else
+        l.sock.reset(new inet_stream(host, port, proto, flags));
+
+    l.created = timer_wheel::now();
+
+    return l;
+}
+
+/*
+ * Puts the connection of `l` into the thread's list, or the shared list if
+ * that is full, or closes it.
+ */
+void connection_pool::put_back(lease& l) {
+    std::unique_ptr<stream_client_socket> sock = std::move(l.sock);
+    std::shared_ptr<connection_pool_state> st = l.pool.lock();
+
+    l.pool.reset();
+
+    if (!sock || !st) return;
+    if (sock->getfd() == -1 || sock->shut_rd || sock->shut_wr) return;
+
+    uint64_t now = timer_wheel::now();
+
+    if (now - l.created >= st->lim.max_age_ms * 1000) return;
+
+    idle_connection conn;
+
+    conn.sock = std::move(sock);
+    conn.created = l.created;
+    conn.idle_since = now;
+
+    string key = endpoint_key(l.host, l.port, l.proto, l.flags);
+
+    size_t mine = 0;
+
+    for (const cached_connection& c : thread_connections)
+        if (c.owner == st.get() && !c.pool.expired()) mine++;
+
+    if (mine < st->lim.thread_cache) {
+        cached_connection c;
+
+        c.pool = st;
+        c.owner = st.get();
+        c.key = std::move(key);
+        c.conn = std::move(conn);
+
+        thread_connections.push_back(std::move(c));
+
+        return;
+    }
+
+    if (st->lim.max_idle == 0) return;
+
+    idle_connection evicted;
+
+    {
+        std::lock_guard<std::mutex> guard(st->lock);
+        std::deque<idle_connection>& q = st->idle[key];
+
+        if (q.size() >= st->lim.max_idle) {
+            evicted = std::move(q.front());
+            q.pop_front();
+        }
+
+        q.push_back(std::move(conn));
+    }
+
+    // `evicted` is closed here, outside the lock.
+}
+}  // namespace libsocket
+
+/**
+ * @}
+ */
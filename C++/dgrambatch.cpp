@@ -0,0 +1,371 @@
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <string>
+
+/*
+   The committers of the libsocket project, all rights reserved
+   (c) 2012, dermesser <lbo@spheniscida.de>
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS” AND ANY
+   EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+   DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+/**
+ * @file dgrambatch.cpp
+ * @brief Preallocated headers and buffers for batched datagram I/O.
+ *
+ * @addtogroup libsocketplusplus
+ * @{
+ */
+
+#include <dgrambatch.hpp>
+#include <exception.hpp>
+#include <socket.hpp>
+
+namespace libsocket {
+using std::string;
+
+/**
+ * @brief Constructor.
+ *
+ * @param n Number of entries, i.e. the maximum number of datagrams per call.
+ * @param dgram_size Size of the buffer the batch allocates for each entry. May
+ * be 0 if all entries get their buffers with `set_buffer()`.
+ * @param control Size of the control data buffer of each entry (see
+ * `cmsg(3)`); 0 if no control messages are expected.
+ */
+dgram_batch::dgram_batch(size_t n, size_t dgram_size, size_t control)
+    : count(n),
+      filled(0),
+      control_size(control),
+      hdrs(new struct mmsghdr[n]),
+      iovs(new struct iovec[n]),
+      capacities(new size_t[n]),
+      addrs(new struct sockaddr_storage[n]) {
+    if (n == 0)
+        throw socket_exception(__FILE__, __LINE__,
+                               "dgram_batch::dgram_batch() - Batch is empty!",
+                               false);
+
+    if (dgram_size > 0) buffers.reset(new char[n * dgram_size]);
+    if (control_size > 0) controls.reset(new char[n * control_size]);
+
+    memset(hdrs.get(), 0, n * sizeof(struct mmsghdr));
+
+    for (size_t i = 0; i < n; i++) {
+        iovs[i].iov_base = dgram_size > 0 ? buffers.get() + i * dgram_size
+                                          : NULL;
+        iovs[i].iov_len = 0;
+        capacities[i] = dgram_size;
+
+        hdrs[i].msg_hdr.msg_iov = &iovs[i];
+        hdrs[i].msg_hdr.msg_iovlen = 1;
+    }
+}
+
+void dgram_batch::check_index(size_t i, const char* function) const {
+    if (i >= count)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            string("dgram_batch::") + function + "() - Index out of range!",
+            false);
+}
+
+/**
+ * @brief Set the number of entries to be sent.
+ */
+void dgram_batch::resize(size_t n) {
+    if (n > count)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "dgram_batch::resize() - Size exceeds the capacity!", false);
+
+    filled = n;
+}
+
+/**
+ * @brief Copy a datagram into the next free entry and add it to the batch.
+ *
+ * @returns false if the batch is full; send it and `clear()` it then.
+ */
+bool dgram_batch::append(const void* buf, size_t len) {
+    if (filled == count) return false;
+
+    if (len > capacities[filled])
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "dgram_batch::append() - Length exceeds the buffer!", false);
+
+    memcpy(iovs[filled].iov_base, buf, len);
+    iovs[filled].iov_len = len;
+    hdrs[filled].msg_len = len;
+    filled++;
+
+    return true;
+}
+
+/**
+ * @brief Copy a datagram for `addr` into the next free entry and add it to
+ * the batch.
+ *
+ * @returns false if the batch is full.
+ */
+bool dgram_batch::append(const void* buf, size_t len,
+                         const struct sockaddr* addr, socklen_t addrlen) {
+    if (filled == count) return false;
+
+    set_address(filled, addr, addrlen);
+
+    return append(buf, len);
+}
+
+/**
+ * @brief The buffer of entry `i`.
+ */
+char* dgram_batch::data(size_t i) {
+    check_index(i, "data");
+
+    return static_cast<char*>(iovs[i].iov_base);
+}
+
+/**
+ * @brief The buffer of entry `i`.
+ */
+const char* dgram_batch::data(size_t i) const {
+    check_index(i, "data");
+
+    return static_cast<const char*>(iovs[i].iov_base);
+}
+
+/**
+ * @brief Length of datagram `i` (received, or to be sent).
+ */
+size_t dgram_batch::length(size_t i) const {
+    check_index(i, "length");
+
+    return hdrs[i].msg_len;
+}
+
+/**
+ * @brief If datagram `i` was longer than its buffer and has been cut off.
+ */
+bool dgram_batch::truncated(size_t i) const {
+    check_index(i, "truncated");
+
+    return hdrs[i].msg_hdr.msg_flags & MSG_TRUNC;
+}
+
+/**
+ * @brief Set the length of datagram `i` to be sent. Its data is expected in
+ * `data(i)`.
+ */
+void dgram_batch::set_length(size_t i, size_t len) {
+    check_index(i, "set_length");
+
+    if (len > capacities[i])
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "dgram_batch::set_length() - Length exceeds the buffer!", false);
+
+    iovs[i].iov_len = len;
+    hdrs[i].msg_len = len;
+}
+
+/**
+ * @brief Use memory owned by the caller as buffer of entry `i`.
+ *
+ * For receiving, `len` is the size of the buffer; for sending, it is the
+ * length of the datagram. The memory must stay valid as long as the batch uses
+ * it.
+ */
+void dgram_batch::set_buffer(size_t i, void* buf, size_t len) {
+    check_index(i, "set_buffer");
+
+    iovs[i].iov_base = buf;
+    iovs[i].iov_len = len;
+    capacities[i] = len;
+    hdrs[i].msg_len = len;
+}
+
+/**
+ * @brief The sender of received datagram `i`, or the destination set with
+ * `set_address()`.
+ */
+const struct sockaddr* dgram_batch::address(size_t i) const {
+    check_index(i, "address");
+
+    return reinterpret_cast<const struct sockaddr*>(&addrs[i]);
+}
+
+/**
+ * @brief Length of `address(i)`.
+ */
+socklen_t dgram_batch::address_length(size_t i) const {
+    check_index(i, "address_length");
+
+    return hdrs[i].msg_hdr.msg_namelen;
+}
+
+/**
+ * @brief Set the destination of datagram `i`.
+ */
+void dgram_batch::set_address(size_t i, const struct sockaddr* addr,
+                              socklen_t len) {
+    check_index(i, "set_address");
+
+    if (len > sizeof(struct sockaddr_storage))
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "dgram_batch::set_address() - Address is too long!", false);
+
+    memcpy(&addrs[i], addr, len);
+    hdrs[i].msg_hdr.msg_namelen = len;
+}
+
+/**
+ * @brief The message header of entry `i`, e.g. to iterate over its control
+ * messages with `CMSG_FIRSTHDR()`.
+ */
+const struct msghdr* dgram_batch::header(size_t i) const {
+    check_index(i, "header");
+
+    return &hdrs[i].msg_hdr;
+}
+
+/**
+ * @brief The kernel receive timestamp of datagram `i`.
+ *
+ * @returns false if there is none (timestamps not enabled, or no room for
+ * control data).
+ */
+bool dgram_batch::timestamp(size_t i, struct timespec* stamp) const {
+    check_index(i, "timestamp");
+
+    return receive_timestamp(&hdrs[i].msg_hdr, stamp);
+}
+
+/**
+ * @brief The destination address of datagram `i`, e.g. the multicast group it
+ * was sent to.
+ *
+ * `dst` is set to a `sockaddr_in` or `sockaddr_in6` with port 0.
+ *
+ * @returns false if there is none (`IP_PKTINFO`/`IPV6_RECVPKTINFO` not
+ * enabled, or no room for control data).
+ */
+bool dgram_batch::destination(size_t i, struct sockaddr_storage* dst) const {
+    check_index(i, "destination");
+
+    const struct msghdr* msg = &hdrs[i].msg_hdr;
+
+    if (msg->msg_control == NULL) return false;
+
+    for (struct cmsghdr* cm = CMSG_FIRSTHDR(msg); cm != NULL;
+         cm = CMSG_NXTHDR(const_cast<struct msghdr*>(msg), cm)) {
+        if (cm->cmsg_level == IPPROTO_IP && cm->cmsg_type == IP_PKTINFO) {
+            struct in_pktinfo info;
+            struct sockaddr_in* sin = reinterpret_cast<struct sockaddr_in*>(dst);
+
+            memcpy(&info, CMSG_DATA(cm), sizeof(info));
+            memset(dst, 0, sizeof(*dst));
+            sin->sin_family = AF_INET;
+            sin->sin_addr = info.ipi_addr;
+
+            return true;
+        }
+        if (cm->cmsg_level == IPPROTO_IPV6 && cm->cmsg_type == IPV6_PKTINFO) {
+            struct in6_pktinfo info;
+            struct sockaddr_in6* sin6 =
+                reinterpret_cast<struct sockaddr_in6*>(dst);
+
+            memcpy(&info, CMSG_DATA(cm), sizeof(info));
+            memset(dst, 0, sizeof(*dst));
+            sin6->sin6_family = AF_INET6;
+            sin6->sin6_addr = info.ipi6_addr;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Reset all entries before receiving into them.
+ *
+ * Called by the receive functions; only needed when calling `recvmmsg(2)` on
+ * `headers()` directly. Call `finish_receive()` afterwards.
+ */
+void dgram_batch::prepare_receive(void) {
+    for (size_t i = 0; i < count; i++) {
+        struct msghdr& hdr = hdrs[i].msg_hdr;
+
+        iovs[i].iov_len = capacities[i];
+
+        hdr.msg_name = &addrs[i];
+        hdr.msg_namelen = sizeof(struct sockaddr_storage);
+        hdr.msg_control =
+            control_size > 0 ? controls.get() + i * control_size : NULL;
+        hdr.msg_controllen = control_size;
+        hdr.msg_flags = 0;
+
+        hdrs[i].msg_len = 0;
+    }
+
+    filled = 0;
+}
+
+/**
+ * @brief Record that `n` datagrams have been received.
+ */
+void dgram_batch::finish_receive(size_t n) { filled = n < count ? n : count; }
+
+/**
+ * @brief Prepare the first `size()` entries for sending.
+ *
+ * The entries are sent with the lengths given by `set_length()` or
+ * `set_buffer()`, or as received.
+ *
+ * @param with_addresses Whether to send to the addresses given by
+ * `set_address()` (or the senders of received datagrams); must be false on
+ * connected sockets.
+ */
+void dgram_batch::prepare_send(bool with_addresses) {
+    for (size_t i = 0; i < filled; i++) {
+        struct msghdr& hdr = hdrs[i].msg_hdr;
+
+        iovs[i].iov_len = hdrs[i].msg_len;
+
+        // After a receive, the addresses are those of the senders, so a batch
+        // can be sent back as it is.
+        hdr.msg_name = with_addresses ? &addrs[i] : NULL;
+        hdr.msg_control = NULL;
+        hdr.msg_controllen = 0;
+        hdr.msg_flags = 0;
+    }
+}
+}  // namespace libsocket
+
+/**
+ * @}
+ */
@@ -48,9 +48,17 @@
  * @{
  */
 
+#include <conf.h>
+
+#include <bufferpool.hpp>
 #include <dgramclient.hpp>
 #include <exception.hpp>
 
+#if LIBSOCKET_LINUX
+#include <sys/socket.h>
+#include <dgrambatch.hpp>
+#endif
+
 namespace libsocket {
 using std::string;
 
@@ -68,16 +76,22 @@ dgram_client_socket::dgram_client_socket(void) : connected(false) {}
  *
  * @retval >0 n bytes were received.
  * @retval 0 0 bytes were received. (EOF?)
- * @retval -1 Something went wrong.
+ * @retval -1 Socket is non-blocking (or `MSG_DONTWAIT` was given) and there
+ * was no datagram.
  */
 ssize_t dgram_client_socket::rcv(void* buf, size_t len, int flags) {
     ssize_t bytes;
 
     memset(buf, 0, len);
 
-    if (-1 == (bytes = recv(sfd, buf, len, flags)))
-        throw socket_exception(__FILE__, __LINE__,
-                               "dgram_client_socket::rcv() - recv() failed!");
+    if (-1 == (bytes = recv(sfd, buf, len, flags))) {
+        if ((is_nonblocking || (flags & MSG_DONTWAIT)) && errno == EWOULDBLOCK)
+            return -1;
+        else
+            throw socket_exception(
+                __FILE__, __LINE__,
+                "dgram_client_socket::rcv() - recv() failed!");
+    }
 
     return bytes;
 }
@@ -130,7 +144,8 @@ dgram_client_socket& operator>>(dgram_client_socket& sock, string& dest) {
  * @param flags Flags for `send(2)`
  *
  * @retval n *n* bytes were sent
- * @retval <0 An error occurred.
+ * @retval -1 Socket is non-blocking (or `MSG_DONTWAIT` was given) and its
+ * send buffer is full.
  */
 ssize_t dgram_client_socket::snd(const void* buf, size_t len, int flags) {
     ssize_t bytes;
@@ -140,13 +155,99 @@ ssize_t dgram_client_socket::snd(const void* buf, size_t len, int flags) {
             __FILE__, __LINE__,
             "dgram_client_socket::snd() - Socket is not connected!", false);
 
+    if (-1 == (bytes = send(sfd, buf, len, flags))) {
+        if ((is_nonblocking || (flags & MSG_DONTWAIT)) && errno == EWOULDBLOCK)
+            return -1;
+        else
+            throw socket_exception(
+                __FILE__, __LINE__,
+                "dgram_client_socket::snd() - send() failed!");
+    }
+
+    return bytes;
+}
+
+/**
+ * @brief Receive data from a connected datagram socket, without throwing
+ *
+ * Works like `rcv()`, but reports errors in `ec` instead of throwing. Unlike
+ * `rcv()`, the buffer is not zeroed first.
+ *
+ * @param buf Receive buffer
+ * @param len Length of `buf`
+ * @param ec Set to the error, or cleared.
+ * @param flags Flags for `recv(2)`
+ *
+ * @returns The length of the datagram, or -1 on error (also if the socket is
+ * non-blocking and there was no datagram).
+ */
+ssize_t dgram_client_socket::rcv(void* buf, size_t len, std::error_code& ec,
+                                 int flags) {
+    ssize_t bytes;
+
+    if (sfd == -1) {
+        ec.assign(EBADF, std::system_category());
+        return -1;
+    }
+
+    if (-1 == (bytes = recv(sfd, buf, len, flags)))
+        ec.assign(errno, std::system_category());
+    else
+        ec.clear();
+
+    return bytes;
+}
+
+/**
+ * @brief Send data to connected socket, without throwing
+ *
+ * Works like `snd()`, but reports errors in `ec` instead of throwing.
+ *
+ * @param buf Pointer to the data
+ * @param len The length of the buffer
+ * @param ec Set to the error, or cleared.
+ * @param flags Flags for `send(2)`
+ *
+ * @returns The number of bytes sent, or -1 on error (also if the socket is
+ * non-blocking and its send buffer is full).
+ */
+ssize_t dgram_client_socket::snd(const void* buf, size_t len,
+                                 std::error_code& ec, int flags) {
+    ssize_t bytes;
+
+    if (connected != true) {
+        ec.assign(ENOTCONN, std::system_category());
+        return -1;
+    }
+
     if (-1 == (bytes = send(sfd, buf, len, flags)))
-        throw socket_exception(__FILE__, __LINE__,
-                               "dgram_client_socket::snd() - send() failed!");
+        ec.assign(errno, std::system_category());
+    else
+        ec.clear();
 
     return bytes;
 }
 
+/**
+ * @brief Send data to connected socket
+ *
+ * Works like `snd(const void*, size_t, int)`; `data` may be any contiguous
+ * container of bytes (see `byte_span`).
+ */
+ssize_t dgram_client_socket::snd(byte_span data, int flags) {
+    return snd(data.data(), data.size(), flags);
+}
+
+/**
+ * @brief Send data to connected socket, without throwing
+ *
+ * See above.
+ */
+ssize_t dgram_client_socket::snd(byte_span data, std::error_code& ec,
+                                 int flags) {
+    return snd(data.data(), data.size(), ec, flags);
+}
+
 /**
  * @brief Send data to connected peer
  *
@@ -190,6 +291,136 @@ dgram_client_socket& operator<<(dgram_client_socket& sock, const string& str) {
     return sock;
 }
 
+#if LIBSOCKET_HAVE_STRING_VIEW
+/**
+ * @brief Send data to connected peer
+ *
+ * Usage: `socket << std::string_view(buf, len);`
+ */
+dgram_client_socket& operator<<(dgram_client_socket& sock,
+                                std::string_view str) {
+    if (sock.connected == false)
+        throw socket_exception(__FILE__, __LINE__,
+                               "dgram_client_socket <<(string_view) output: "
+                               "DGRAM socket not connected!");
+    if (-1 == write(sock.sfd, str.data(), str.size()))
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "dgram_client_socket <<(string_view) output: Write failed!");
+
+    return sock;
+}
+#endif
+
+/**
+ * @brief Send the first `batch.size()` datagrams of `batch` to the connected
+ * peer with one system call (`sendmmsg(2)`). Linux only.
+ *
+ * The batch's message headers are reused from call to call, so sending many
+ * small datagrams this way costs one system call per batch and no
+ * allocations. Fill the batch with `dgram_batch::append()`:
+ *
+ *     dgram_batch batch(64, 64);
+ *
+ *     while (...) {
+ *         if (!batch.append(msg, msglen)) {
+ *             sock.snd_batch(batch);
+ *             batch.clear();
+ *             batch.append(msg, msglen);
+ *         }
+ *     }
+ *
+ * Addresses set in the batch are ignored.
+ *
+ * @param batch The datagrams.
+ * @param flags Flags for `sendmmsg(2)`, e.g. `MSG_DONTWAIT`.
+ *
+ * @retval >0 The first n datagrams were sent; if n is less than `batch.size()`,
+ * the others were not.
+ * @retval -1 The socket's send buffer is full (`EAGAIN`) and no datagram was
+ * sent. This is never an exception, whether the socket is non-blocking or
+ * `MSG_DONTWAIT` was given.
+ */
+int dgram_client_socket::snd_batch(dgram_batch& batch, int flags) {
+    if (connected != true)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "dgram_client_socket::snd_batch() - Socket is not connected!",
+            false);
+
+#if LIBSOCKET_LINUX
+    int n;
+
+    if (batch.size() == 0) return 0;
+
+    batch.prepare_send(false);
+
+    if (-1 == (n = sendmmsg(sfd, batch.headers(), batch.size(), flags))) {
+        if (errno == EWOULDBLOCK || errno == EAGAIN)
+            return -1;
+        else
+            throw socket_exception(
+                __FILE__, __LINE__,
+                "dgram_client_socket::snd_batch() - Error at sendmmsg");
+    }
+
+    return n;
+#else
+    (void)batch;
+    (void)flags;
+    errno = ENOSYS;
+    throw socket_exception(
+        __FILE__, __LINE__,
+        "dgram_client_socket::snd_batch() - Not supported on this platform");
+#endif
+}
+
+/**
+ * @brief Receive up to `batch.capacity()` datagrams from the connected peer
+ * with one system call (`recvmmsg(2)`). Linux only.
+ *
+ * Waits for the first datagram only (`MSG_WAITFORONE`), unless the socket is
+ * non-blocking or `MSG_DONTWAIT` is given.
+ *
+ * @retval >0 Number of datagrams received; see `dgram_batch::data()` and
+ * `dgram_batch::length()`.
+ * @retval -1 There was no datagram (`EAGAIN`). This is never an exception.
+ */
+int dgram_client_socket::rcv_batch(dgram_batch& batch, int flags) {
+    if (connected != true)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "dgram_client_socket::rcv_batch() - Socket is not connected!",
+            false);
+
+#if LIBSOCKET_LINUX
+    int n;
+
+    batch.prepare_receive();
+
+    if (-1 == (n = recvmmsg(sfd, batch.headers(), batch.capacity(),
+                            flags | MSG_WAITFORONE, NULL))) {
+        if (errno == EWOULDBLOCK || errno == EAGAIN)
+            return -1;
+        else
+            throw socket_exception(
+                __FILE__, __LINE__,
+                "dgram_client_socket::rcv_batch() - Error at recvmmsg");
+    }
+
+    batch.finish_receive(n);
+
+    return n;
+#else
+    (void)batch;
+    (void)flags;
+    errno = ENOSYS;
+    throw socket_exception(
+        __FILE__, __LINE__,
+        "dgram_client_socket::rcv_batch() - Not supported on this platform");
+#endif
+}
+
 /**
  * @deprecated (use is_connected())
  *
@@ -201,6 +432,20 @@ bool dgram_client_socket::getconn(void) const { return is_connected(); }
  * Returns true if the socket is in a connected state.
  */
 bool dgram_client_socket::is_connected(void) const { return connected; }
+
+/**
+ * @brief Receive a datagram into a buffer from a `buffer_pool`
+ *
+ * Like `rcv(void*, size_t, int)`; sets the size of `buf` to the number of
+ * bytes received. Longer datagrams are truncated to `buf.capacity()`.
+ */
+ssize_t dgram_client_socket::rcv(pooled_buffer& buf, int flags) {
+    ssize_t bytes = rcv(buf.data(), buf.capacity(), flags);
+
+    buf.resize(bytes > 0 ? bytes : 0);
+
+    return bytes;
+}
 }  // namespace libsocket
 
 /**
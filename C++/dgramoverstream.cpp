@@ -35,6 +35,7 @@
  * @{
  */
 
+#include <bufferpool.hpp>
 #include <dgramoverstream.hpp>
 #include <exception.hpp>
 
@@ -118,6 +119,19 @@ ssize_t dgram_over_stream::sndmsg(const std::vector<uint8_t>& msg) {
     return sndmsg(static_cast<const void*>(msg.data()), msg.size());
 }
 
+/**
+ * @brief Send the message `msg` as one frame.
+ *
+ * `msg` may be any contiguous container of bytes, e.g. a `std::string_view` or
+ * a `std::vector<char>` (see `byte_span`).
+ *
+ * @returns How many bytes were sent; should be `msg.size()`.
+ * @throws socket_exception
+ */
+ssize_t dgram_over_stream::sndmsg(byte_span msg) {
+    return sndmsg(static_cast<const void*>(msg.data()), msg.size());
+}
+
 /**
  * @brief Receive up to `dst.size()` bytes and store them in `dst`.
  * @returns Number of bytes actually received.
@@ -255,6 +269,23 @@ uint32_t dgram_over_stream::receive_header(void) {
 
     return decode_uint32(prefix_buffer);
 }
+
+/**
+ * @brief Receive a message into a buffer from a `buffer_pool`.
+ *
+ * Bytes in the message beyond `dst->capacity()` are discarded; the size of
+ * `dst` is set to the number of bytes stored.
+ *
+ * @returns The number of bytes received.
+ * @throws socket_exception
+ */
+ssize_t dgram_over_stream::rcvmsg(pooled_buffer* dst) {
+    ssize_t received = rcvmsg(dst->data(), dst->capacity());
+
+    dst->resize(received);
+
+    return received;
+}
 }  // namespace libsocket
 
 /**
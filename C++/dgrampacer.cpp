@@ -0,0 +1,526 @@
+#include <errno.h>
+#include <linux/net_tstamp.h>
+#include <netdb.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <time.h>
+#include <string>
+
+/*
+   The committers of the libsocket project, all rights reserved
+   (c) 2012, dermesser <lbo@spheniscida.de>
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS” AND ANY
+   EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+   DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+/**
+ * @file dgrampacer.cpp
+ * @brief Token-bucket pacing of datagrams.
+ *
+ * 	Tokens are bytes; a destination's bucket is refilled lazily from
+ * 	the time elapsed since it was last looked at. Queued datagrams are
+ * 	only looked at when the timer wheel says the destination has
+ * 	collected enough tokens for the first of them.
+ *
+ * @addtogroup libsocketplusplus
+ * @{
+ */
+
+#include <dgrampacer.hpp>
+#include <exception.hpp>
+
+namespace libsocket {
+using std::string;
+
+// Bucket size if none is given: 10 ms worth of data, but at least one
+// maximum-sized datagram.
+static double default_burst(uint64_t rate) {
+    return rate / 100 > 65536 ? rate / 100 : 65536;
+}
+
+/**
+ * @brief Constructor.
+ *
+ * @param s The socket to send on. It is not owned by the pacer.
+ * @param m How datagrams are delayed (see class description).
+ * @param queue_limit With `pace_user`: maximum number of datagrams queued per
+ * destination.
+ * @param txtime_clock With `pace_txtime`: the clock of departure times, which
+ * must match the qdisc's (`CLOCK_MONOTONIC` for `fq`, usually `CLOCK_TAI` for
+ * `etf`).
+ */
+dgram_pacer::dgram_pacer(socket& s, mode m, size_t queue_limit,
+                         clockid_t txtime_clock)
+    : sock(s),
+      how(m),
+      limit(queue_limit > 0 ? queue_limit : 1),
+      clock(txtime_clock),
+      wheel() {
+    if (how == pace_txtime) {
+        struct sock_txtime txtime;
+
+        txtime.clockid = clock;
+        txtime.flags = 0;
+
+        if (0 > setsockopt(sock.getfd(), SOL_SOCKET, SO_TXTIME, &txtime,
+                           sizeof(txtime)))
+            throw socket_exception(
+                __FILE__, __LINE__,
+                "dgram_pacer::dgram_pacer() - Could not set SO_TXTIME!");
+    }
+}
+
+/**
+ * @brief Add a destination given by host and port.
+ *
+ * @param rate Bytes per second; 0 for no limit.
+ * @param burst Maximum number of bytes sent at once; 0 for 10 ms worth of
+ * data (at least 64 KiB).
+ *
+ * @returns The number of the destination, to be passed to `send()`.
+ */
+size_t dgram_pacer::add_destination(const string& host, const string& port,
+                                    uint64_t rate, size_t burst) {
+    struct sockaddr_storage local;
+    socklen_t locallen = sizeof(local);
+    struct addrinfo hints, *result;
+
+    if (0 > getsockname(sock.getfd(), reinterpret_cast<struct sockaddr*>(&local),
+                        &locallen))
+        throw socket_exception(__FILE__, __LINE__,
+                               "dgram_pacer::add_destination() - Could not "
+                               "get socket address!");
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = local.ss_family;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    int ret = getaddrinfo(host.c_str(), port.c_str(), &hints, &result);
+
+    if (ret != 0)
+        throw socket_exception(__FILE__, __LINE__,
+                               string("dgram_pacer::add_destination() - Could "
+                                      "not resolve destination: ") +
+                                   gai_strerror(ret),
+                               false);
+
+    size_t index;
+
+    try {
+        index = add_destination(result->ai_addr, result->ai_addrlen, rate,
+                                burst);
+    } catch (...) {
+        freeaddrinfo(result);
+        throw;
+    }
+
+    freeaddrinfo(result);
+
+    return index;
+}
+
+/**
+ * @brief Add a destination given by its address.
+ *
+ * See `add_destination(const string&, const string&, uint64_t, size_t)`.
+ */
+size_t dgram_pacer::add_destination(const struct sockaddr* addr,
+                                    socklen_t len, uint64_t rate,
+                                    size_t burst) {
+    if (len > sizeof(struct sockaddr_storage))
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "dgram_pacer::add_destination() - Address too long!", false);
+
+    destination d;
+
+    memset(&d.addr, 0, sizeof(d.addr));
+    if (len > 0) memcpy(&d.addr, addr, len);
+    d.addrlen = len;
+
+    d.rate = rate;
+    d.burst = burst > 0 ? burst : default_burst(rate);
+    d.tokens = d.burst;
+    d.updated = timer_wheel::now();
+
+    d.head = d.queued = d.queued_bytes = 0;
+    d.scheduled = false;
+
+    d.datagrams = d.bytes = 0;
+    d.first = 0;
+
+    dests.push_back(d);
+
+    if (how == pace_socket) set_socket_rate();
+
+    return dests.size() - 1;
+}
+
+/**
+ * @brief Add the peer of a connected socket as destination.
+ *
+ * See `add_destination(const string&, const string&, uint64_t, size_t)`.
+ */
+size_t dgram_pacer::add_destination(uint64_t rate, size_t burst) {
+    return add_destination(NULL, 0, rate, burst);
+}
+
+/**
+ * @brief Change the rate (and bucket size) of a destination.
+ */
+void dgram_pacer::set_rate(size_t dest, uint64_t rate, size_t burst) {
+    destination& d = get(dest, "set_rate");
+
+    refill(d, timer_wheel::now());
+
+    d.rate = rate;
+    d.burst = burst > 0 ? burst : default_burst(rate);
+    if (d.tokens > d.burst) d.tokens = d.burst;
+
+    if (how == pace_socket) set_socket_rate();
+}
+
+/**
+ * @brief Send a datagram to a destination, now or later.
+ *
+ * @retval >=0 The datagram has been sent or queued (with `pace_user`) and
+ * will be sent by `flush()`; returns its length.
+ * @retval -1 The socket is non-blocking and its buffer is full, or (with
+ * `pace_user`) the destination's queue is full (`errno` is `ENOBUFS` then).
+ *
+ * Other errors make the function throw.
+ */
+ssize_t dgram_pacer::send(size_t dest, const void* buf, size_t len) {
+    destination& d = get(dest, "send");
+    uint64_t now = timer_wheel::now();
+    ssize_t ret;
+
+    if (buf == NULL && len > 0)
+        throw socket_exception(__FILE__, __LINE__,
+                               "dgram_pacer::send() - Buffer is null!", false);
+
+    switch (how) {
+        case pace_socket:
+            ret = transmit(d, buf, len, 0, 0);
+            break;
+
+        case pace_txtime: {
+            uint64_t departure = now;
+
+            refill(d, now);
+
+            if (d.rate > 0 && d.tokens < len)
+                departure += uint64_t((len - d.tokens) * 1e6 / d.rate);
+
+            ret = transmit(d, buf, len, departure, 0);
+
+            if (ret >= 0) d.tokens -= len;
+            break;
+        }
+
+        default:
+            refill(d, now);
+
+            if (d.queued == 0 && may_send(d, len)) {
+                ret = transmit(d, buf, len, 0, MSG_DONTWAIT);
+
+                if (ret >= 0) {
+                    d.tokens -= len;
+                    break;
+                }
+                if (errno != EWOULDBLOCK && errno != EAGAIN)
+                    throw socket_exception(
+                        __FILE__, __LINE__,
+                        "dgram_pacer::send() - Error while sending!");
+            }
+
+            if (d.queued == limit) {
+                errno = ENOBUFS;
+                return -1;
+            }
+            if (d.queue.empty()) d.queue.resize(limit);
+
+            d.queue[(d.head + d.queued) % limit].assign(
+                static_cast<const char*>(buf), len);
+            d.queued++;
+            d.queued_bytes += len;
+
+            wake(d, dest, now);
+
+            return len;
+    }
+
+    if (ret < 0) {
+        if (errno == EWOULDBLOCK || errno == EAGAIN) return -1;
+
+        throw socket_exception(__FILE__, __LINE__,
+                               "dgram_pacer::send() - Error while sending!");
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Send all queued datagrams whose time has come (`pace_user`).
+ *
+ * @returns The number of datagrams sent.
+ */
+size_t dgram_pacer::flush(void) {
+    uint64_t now = timer_wheel::now();
+    size_t sent = 0;
+
+    wheel.expire(now, [this, now, &sent](uint64_t key) {
+        destination& d = dests[key];
+
+        d.scheduled = false;
+        drain(d, key, now, &sent);
+    });
+
+    return sent;
+}
+
+/**
+ * @brief Milliseconds until `flush()` has something to do; -1 if nothing is
+ * queued. Use it as timeout for `epollset::wait()`.
+ */
+int dgram_pacer::next_timeout(void) const {
+    return wheel.timeout_ms(timer_wheel::now());
+}
+
+/**
+ * @brief Counters of one destination.
+ */
+pacer_stats dgram_pacer::stats(size_t dest) const {
+    if (dest >= dests.size())
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "dgram_pacer::stats() - No such destination!", false);
+
+    const destination& d = dests[dest];
+    uint64_t now = timer_wheel::now();
+    pacer_stats st;
+
+    st.datagrams = d.datagrams;
+    st.bytes = d.bytes;
+    st.rate = d.datagrams > 0 && now > d.first
+                  ? d.bytes * 1e6 / (now - d.first)
+                  : 0;
+    st.queued = d.queued;
+    st.queued_bytes = d.queued_bytes;
+
+    if (how == pace_txtime && d.rate > 0) {
+        // The debt not paid off yet is what the kernel still holds back.
+        double debt = -(d.tokens + (now - d.updated) * d.rate / 1e6);
+
+        st.queued_bytes = debt > 0 ? size_t(debt) : 0;
+    }
+
+    return st;
+}
+
+/**
+ * @brief Counters of all destinations together.
+ */
+pacer_stats dgram_pacer::stats(void) const {
+    pacer_stats total = {0, 0, 0, 0, 0};
+
+    for (size_t i = 0; i < dests.size(); i++) {
+        pacer_stats st = stats(i);
+
+        total.datagrams += st.datagrams;
+        total.bytes += st.bytes;
+        total.rate += st.rate;
+        total.queued += st.queued;
+        total.queued_bytes += st.queued_bytes;
+    }
+
+    return total;
+}
+
+dgram_pacer::destination& dgram_pacer::get(size_t dest,
+                                           const char* function) {
+    if (dest >= dests.size())
+        throw socket_exception(
+            __FILE__, __LINE__,
+            string("dgram_pacer::") + function + "() - No such destination!",
+            false);
+
+    return dests[dest];
+}
+
+void dgram_pacer::refill(destination& d, uint64_t now) {
+    if (now > d.updated) {
+        d.tokens += (now - d.updated) * d.rate / 1e6;
+        if (d.tokens > d.burst) d.tokens = d.burst;
+    }
+
+    d.updated = now;
+}
+
+// A datagram larger than the bucket may be sent when the bucket is full.
+bool dgram_pacer::may_send(const destination& d, size_t len) const {
+    return d.rate == 0 || d.tokens >= len || d.tokens >= d.burst;
+}
+
+// Sends one datagram and counts it; `departure` is in microseconds of
+// CLOCK_MONOTONIC (see timer_wheel::now()), 0 for no SO_TXTIME control
+// message.
+ssize_t dgram_pacer::transmit(destination& d, const void* buf, size_t len,
+                              uint64_t departure, int flags) {
+    struct msghdr msg;
+    struct iovec iov;
+    char control[CMSG_SPACE(sizeof(uint64_t))];
+
+    memset(&msg, 0, sizeof(msg));
+
+    iov.iov_base = const_cast<void*>(buf);
+    iov.iov_len = len;
+
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+
+    if (d.addrlen > 0) {
+        msg.msg_name = &d.addr;
+        msg.msg_namelen = d.addrlen;
+    }
+
+    if (departure > 0) {
+        uint64_t nanoseconds = departure * 1000;
+
+        // Move the departure time to the socket's clock. The offset is taken
+        // anew for every datagram, as CLOCK_TAI and CLOCK_REALTIME may be
+        // stepped.
+        if (clock != CLOCK_MONOTONIC) {
+            struct timespec mono, other;
+
+            clock_gettime(CLOCK_MONOTONIC, &mono);
+            clock_gettime(clock, &other);
+
+            nanoseconds += (other.tv_sec - mono.tv_sec) * 1000000000ULL +
+                           (other.tv_nsec - mono.tv_nsec);
+        }
+
+        memset(control, 0, sizeof(control));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        struct cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+
+        cm->cmsg_level = SOL_SOCKET;
+        cm->cmsg_type = SCM_TXTIME;
+        cm->cmsg_len = CMSG_LEN(sizeof(nanoseconds));
+        memcpy(CMSG_DATA(cm), &nanoseconds, sizeof(nanoseconds));
+    }
+
+    ssize_t ret = ::sendmsg(sock.getfd(), &msg, flags);
+
+    if (ret >= 0) {
+        if (d.datagrams == 0) d.first = timer_wheel::now();
+
+        d.datagrams++;
+        d.bytes += ret;
+    }
+
+    return ret;
+}
+
+// Sends queued datagrams while there are tokens for them.
+void dgram_pacer::drain(destination& d, size_t index, uint64_t now,
+                        size_t* sent) {
+    refill(d, now);
+
+    while (d.queued > 0) {
+        const string& dgram = d.queue[d.head];
+
+        if (!may_send(d, dgram.size())) break;
+
+        if (0 > transmit(d, dgram.data(), dgram.size(), 0, MSG_DONTWAIT)) {
+            if (errno != EWOULDBLOCK && errno != EAGAIN)
+                throw socket_exception(
+                    __FILE__, __LINE__,
+                    "dgram_pacer::flush() - Error while sending!");
+
+            // Socket buffer full; try again on the next tick.
+            wheel.schedule(index, now + wheel.resolution());
+            d.scheduled = true;
+            return;
+        }
+
+        d.tokens -= dgram.size();
+        d.queued_bytes -= dgram.size();
+        d.head = (d.head + 1) % limit;
+        d.queued--;
+        (*sent)++;
+    }
+
+    if (d.queued > 0) wake(d, index, now);
+}
+
+// Schedules a destination for when it has enough tokens for its first
+// queued datagram.
+void dgram_pacer::wake(destination& d, size_t index, uint64_t now) {
+    if (d.scheduled) return;
+
+    double size = d.queue[d.head].size();
+    double need = (size < d.burst ? size : d.burst) - d.tokens;
+    uint64_t deadline = now;
+
+    if (need > 0 && d.rate > 0) deadline += uint64_t(need * 1e6 / d.rate) + 1;
+
+    wheel.schedule(index, deadline);
+    d.scheduled = true;
+}
+
+// SO_MAX_PACING_RATE for the sum of all destination rates.
+void dgram_pacer::set_socket_rate(void) {
+    uint64_t total = 0;
+
+    for (size_t i = 0; i < dests.size(); i++) {
+        if (dests[i].rate == 0) {
+            total = ~uint64_t(0);
+            break;
+        }
+        total += dests[i].rate;
+    }
+
+    int ret;
+
+    // Older kernels only accept 32 bit values.
+    if (total < 0xffffffffU) {
+        uint32_t rate = total;
+        ret = setsockopt(sock.getfd(), SOL_SOCKET, SO_MAX_PACING_RATE, &rate,
+                         sizeof(rate));
+    } else
+        ret = setsockopt(sock.getfd(), SOL_SOCKET, SO_MAX_PACING_RATE, &total,
+                         sizeof(total));
+
+    if (ret < 0)
+        throw socket_exception(__FILE__, __LINE__,
+                               "dgram_pacer::set_rate() - Could not set "
+                               "SO_MAX_PACING_RATE!");
+}
+}  // namespace libsocket
+
+/**
+ * @}
+ */
@@ -1,4 +1,5 @@
 #include <errno.h>
+#include <netdb.h>
 #include <stdio.h>
 #include <cstring>
 #include <sstream>
@@ -79,6 +80,33 @@ socket_exception::socket_exception(const string& file, int line,
 
     mesg = message_stream.str();
 }
+
+class addrinfo_error_category : public std::error_category {
+   public:
+    const char* name(void) const noexcept { return "addrinfo"; }
+    string message(int ev) const { return gai_strerror(ev); }
+};
+
+/**
+ * @brief The category of `getaddrinfo(3)` error codes.
+ */
+const std::error_category& addrinfo_category(void) {
+    static const addrinfo_error_category category;
+
+    return category;
+}
+
+/**
+ * @brief The error code for a `getaddrinfo(3)` return value.
+ *
+ * `EAI_SYSTEM` is translated to the current `errno`.
+ */
+std::error_code addrinfo_error(int gai_error) {
+    if (gai_error == EAI_SYSTEM)
+        return std::error_code(errno, std::system_category());
+
+    return std::error_code(gai_error, addrinfo_category());
+}
 }  // namespace libsocket
 
 /**
@@ -45,12 +45,15 @@
  * 	server application to get the paramters of the remote peer.
  */
 
+#include <netdb.h>
+#include <sys/socket.h>
+
 #include <inetbase.hpp>
 
 namespace libsocket {
 using std::string;
 
-inet_socket::inet_socket() : host(""), port("") {}
+inet_socket::inet_socket() : host(""), port(""), clientKnown(false) {}
 
 /**
  * For sockets behaving as client: Returns the remote host.
@@ -64,7 +67,64 @@ const string& inet_socket::gethost(void) const { return host; }
  */
 const string& inet_socket::getport(void) const { return port; }
 
-const string &inet_socket::gethostClient(void) const {return hostClient;}
-const string &inet_socket::getportClient(void) const {return portClient;}
+/*
+ * Fills host/port with the local address of sfd, numerically and for both
+ * address families. Empty if the socket is not bound yet.
+ */
+static void local_name(int sfd, string& host, string& port) {
+    char hostbuf[NI_MAXHOST], portbuf[NI_MAXSERV];
+    struct sockaddr_storage addr;
+    socklen_t len = sizeof(addr);
+
+    host.clear();
+    port.clear();
+
+    if (sfd < 0 ||
+        0 > getsockname(sfd, reinterpret_cast<struct sockaddr*>(&addr), &len))
+        return;
+
+    if (0 == getnameinfo(reinterpret_cast<struct sockaddr*>(&addr), len,
+                         hostbuf, sizeof(hostbuf), portbuf, sizeof(portbuf),
+                         NI_NUMERICHOST | NI_NUMERICSERV)) {
+        host = hostbuf;
+        port = portbuf;
+    }
+}
+
+/**
+ * For connected sockets: Returns the local address of the connection.
+ *
+ * Looked up on the first call after each connect; empty if the socket is not
+ * connected or bound.
+ */
+const string& inet_socket::gethostClient(void) const {
+    if (!clientKnown) {
+        local_name(sfd, hostClient, portClient);
+        // Not bound yet (e.g. an unconnected dgram socket): look again later
+        clientKnown = !portClient.empty() && portClient != "0";
+    }
+
+    return hostClient;
+}
+
+/**
+ * For connected sockets: Returns the local port of the connection.
+ *
+ * See gethostClient().
+ */
+const string& inet_socket::getportClient(void) const {
+    gethostClient();
+
+    return portClient;
+}
+
+/**
+ * @brief Invalidate hostClient/portClient, e.g. after a (re)connect.
+ */
+void inet_socket::forget_client(void) {
+    hostClient.clear();
+    portClient.clear();
+    clientKnown = false;
+}
 
 }  // namespace libsocket
@@ -62,9 +62,16 @@
  * 	bound to somewhere.
  */
 
+#include <conf.h>
+
 #include <libinetsocket.h>
 #include <exception.hpp>
 #include <inetclientdgram.hpp>
+#include <resolver.hpp>
+
+#if LIBSOCKET_LINUX
+#include <linux/errqueue.h>
+#endif
 
 #include <fcntl.h>
 #ifndef SOCK_NONBLOCK
@@ -132,6 +139,28 @@ void inet_dgram_client::setup(int proto_osi3, int flags) {
     is_nonblocking = flags & SOCK_NONBLOCK;
 }
 
+/*
+ * Like get_address_family(), but through the resolver cache: the following
+ * connect() looks up the same name and port.
+ */
+static int address_family(const char* host, const char* port) {
+    if (host == NULL || port == NULL) return -1;
+
+    std::shared_ptr<const resolved_addresses> result =
+        resolver::lookup(host, port, AF_UNSPEC, SOCK_DGRAM);
+
+    if (result->error() != 0) return -1;
+
+    switch (result->list()->ai_family) {
+        case AF_INET:
+            return LIBSOCKET_IPv4;
+        case AF_INET6:
+            return LIBSOCKET_IPv6;
+        default:
+            return -1;
+    }
+}
+
 /**
  * @brief Set up datagram socket and connect it immediately to the given host
  * and port. [NOT FOR EXTERNAL USE]
@@ -144,7 +173,8 @@ void inet_dgram_client::setup(int proto_osi3, int flags) {
 void inet_dgram_client::setup(const char* dsthost, const char* dstport,
                               int proto_osi3, int flags) {
     // Retrieve address family
-    if (proto_osi3 == LIBSOCKET_BOTH) proto_osi3 = get_address_family(dsthost);
+    if (proto_osi3 == LIBSOCKET_BOTH)
+        proto_osi3 = address_family(dsthost, dstport);
 
     if (-1 == (sfd = create_inet_dgram_socket(proto_osi3, flags)))
         throw socket_exception(__FILE__, __LINE__,
@@ -187,8 +217,14 @@ static inline signed int check_error(int return_value) {
     return 0;
 }
 
-int _connect_inet_dgram_socket_(int sfd, const char *host, const char *service, std::string& bufferHost, std::string& bufferPort) {
-        struct addrinfo *result, *result_check, hint;
+/*
+ * Connects sfd to the first address of host/service of the socket's family.
+ * Returns -1 with errno set, or with `*gai_error` set if there is no such
+ * address.
+ */
+int _connect_inet_dgram_socket_(int sfd, const char *host, const char *service,
+                                int* gai_error) {
+        const struct addrinfo *result_check;
         struct sockaddr_storage oldsockaddr;
         socklen_t oldsockaddrlen = sizeof(struct sockaddr_storage);
         int return_value;
@@ -196,7 +232,12 @@ int _connect_inet_dgram_socket_(int sfd, const char *host, const char *service,
         const char *errstring;
 #endif
 
-        if (sfd < 0) return -1;
+        *gai_error = 0;
+
+        if (sfd < 0) {
+            errno = EBADF;
+            return -1;
+        }
 
         if (host == NULL) {
             // This does not work on FreeBSD systems. We pretend to disconnect the
@@ -213,44 +254,37 @@ int _connect_inet_dgram_socket_(int sfd, const char *host, const char *service,
             sizeof(struct sockaddr_storage))  // If getsockname truncated the struct
             return -1;
 
-        memset(&hint, 0, sizeof(struct addrinfo));
+        // Resolve both families so the lookup in address_family() can be
+        // answered from the cache, and skip those not matching the socket.
+        std::shared_ptr<const resolved_addresses> result =
+            resolver::lookup(host, service, AF_UNSPEC, SOCK_DGRAM);
 
-        hint.ai_family = ((struct sockaddr_in *)&oldsockaddr)
-                ->sin_family;  // AF_INET or AF_INET6 - offset is same
-        // at sockaddr_in and sockaddr_in6
-        hint.ai_socktype = SOCK_DGRAM;
-
-        if (0 != (return_value = getaddrinfo(host, service, &hint, &result))) {
+        if (0 != result->error()) {
 #ifdef VERBOSE
-            errstring = gai_strerror(return_value);
+            errstring = gai_strerror(result->error());
         debug_write(errstring);
 #endif
+            *gai_error = result->error();
             return -1;
         }
 
+        *gai_error = EAI_NONAME;  // until an address of our family shows up
+
         // As described in "The Linux Programming Interface", Michael Kerrisk 2010,
         // chapter 59.11 (p. 1220ff)
 
-        for (result_check = result; result_check != NULL;
+        for (result_check = result->list(); result_check != NULL;
              result_check = result_check->ai_next)  // go through the linked list of
             // struct addrinfo elements
         {
+            if (result_check->ai_family != oldsockaddr.ss_family) continue;
+
+            *gai_error = 0;
+
             if (-1 != (return_value = connect(
                     sfd, result_check->ai_addr,
                     result_check->ai_addrlen)))  // connected without error
             {
-
-                struct sockaddr_in server_addr, my_addr;
-                // Get my ip address and port
-                bzero(&my_addr, sizeof(my_addr));
-                socklen_t len = sizeof(my_addr);
-                getsockname(sfd, (struct sockaddr *) &my_addr, &len);
-
-                char tmpIP[16]{0};
-                inet_ntop(AF_INET, &my_addr.sin_addr, tmpIP, 16);
-                bufferHost = tmpIP;
-                bufferPort = std::to_string(ntohs(my_addr.sin_port));
-
                 break;
             } else {
                 check_error(return_value);
@@ -265,12 +299,9 @@ int _connect_inet_dgram_socket_(int sfd, const char *host, const char *service,
             debug_write(
             "connect_inet_dgram_socket: Could not connect to any address!\n");
 #endif
-            freeaddrinfo(result);
             return -1;
         }
 
-        freeaddrinfo(result);
-
         return 0;
     }
 
@@ -286,12 +317,14 @@ int _connect_inet_dgram_socket_(int sfd, const char *host, const char *service,
  * @param dstport Destination port
  */
 void inet_dgram_client::connect(const char* dsthost, const char* dstport) {
+    int gai_error;
+
     if (sfd == -1)
         throw socket_exception(
             __FILE__, __LINE__,
             "inet_dgram_client::connect() - Socket has already been closed!",
             false);
-    if (-1 == (_connect_inet_dgram_socket_(sfd, dsthost, dstport, hostClient, portClient)))
+    if (-1 == (_connect_inet_dgram_socket_(sfd, dsthost, dstport, &gai_error)))
         throw socket_exception(
             __FILE__, __LINE__,
             "inet_dgram_client::connect() - Could not connect dgram socket! "
@@ -300,6 +333,7 @@ void inet_dgram_client::connect(const char* dsthost, const char* dstport) {
     host = dsthost;
     port = dstport;
     connected = true;
+    forget_client();
 }
 
 /**
@@ -312,13 +346,16 @@ void inet_dgram_client::connect(const char* dsthost, const char* dstport) {
  * @param dstport Destination port
  */
 void inet_dgram_client::connect(const string& dsthost, const string& dstport) {
+    int gai_error;
+
     if (sfd == -1)
         throw socket_exception(
             __FILE__, __LINE__,
             "inet_dgram_client::connect() - Socket has already been closed!",
             false);
     if (-1 ==
-        (_connect_inet_dgram_socket_(sfd, dsthost.c_str(), dstport.c_str(), hostClient, portClient)))
+        (_connect_inet_dgram_socket_(sfd, dsthost.c_str(), dstport.c_str(),
+                                     &gai_error)))
         throw socket_exception(
             __FILE__, __LINE__,
             "inet_dgram_client::connect() - Could not connect dgram socket! "
@@ -327,6 +364,53 @@ void inet_dgram_client::connect(const string& dsthost, const string& dstport) {
     host = dsthost;
     port = dstport;
     connected = true;
+    forget_client();
+}
+
+/**
+ * @brief Connect datagram socket, without throwing.
+ *
+ * Works like `connect()`, but reports errors in `ec` instead of throwing. If
+ * `dsthost` has no address of the socket's family, `ec` is `EAI_NONAME` in
+ * `addrinfo_category()`.
+ *
+ * @param dsthost Destination host
+ * @param dstport Destination port
+ * @param ec Set to the error, or cleared.
+ */
+void inet_dgram_client::connect(const char* dsthost, const char* dstport,
+                                std::error_code& ec) {
+    int gai_error;
+
+    if (dsthost == NULL || dstport == NULL) {
+        ec.assign(EINVAL, std::system_category());
+        return;
+    }
+
+    if (-1 == _connect_inet_dgram_socket_(sfd, dsthost, dstport, &gai_error)) {
+        if (gai_error != 0)
+            ec = addrinfo_error(gai_error);
+        else
+            ec.assign(errno, std::system_category());
+        return;
+    }
+
+    host = dsthost;
+    port = dstport;
+    connected = true;
+    forget_client();
+
+    ec.clear();
+}
+
+/**
+ * @brief Connect datagram socket, without throwing.
+ *
+ * See above.
+ */
+void inet_dgram_client::connect(const string& dsthost, const string& dstport,
+                                std::error_code& ec) {
+    connect(dsthost.c_str(), dstport.c_str(), ec);
 }
 
 /*
@@ -336,7 +420,9 @@ void inet_dgram_client::connect(const string& dsthost, const string& dstport) {
  *
  */
 void inet_dgram_client::deconnect(void) {
-    if (-1 == (_connect_inet_dgram_socket_(sfd, NULL, NULL, hostClient, portClient)))
+    int gai_error;
+
+    if (-1 == (_connect_inet_dgram_socket_(sfd, NULL, NULL, &gai_error)))
         throw socket_exception(
             __FILE__, __LINE__,
             "inet_dgram_client::deconnect() - Could not disconnect!");
@@ -344,5 +430,216 @@ void inet_dgram_client::deconnect(void) {
     connected = false;
     host.clear();
     port.clear();
+    forget_client();
+}
+
+#if LIBSOCKET_LINUX
+// AF_INET or AF_INET6, from the socket's local address.
+static int socket_family(int sfd) {
+    struct sockaddr_storage local;
+    socklen_t len = sizeof(local);
+
+    if (0 > getsockname(sfd, reinterpret_cast<struct sockaddr*>(&local), &len))
+        return -1;
+
+    return local.ss_family;
+}
+#endif
+
+/**
+ * @brief Configure path MTU discovery (`IP_MTU_DISCOVER`/`IPV6_MTU_DISCOVER`).
+ * Linux only.
+ *
+ * With `pmtu_do`, datagrams are sent with the Don't Fragment bit, so the
+ * kernel learns the path MTU from ICMP "fragmentation needed" (IPv6: "packet
+ * too big") messages; `path_mtu()` and `max_payload()` then return the
+ * current values. Sending a datagram larger than the path MTU fails with
+ * `EMSGSIZE` (`snd()` throws a `socket_exception` with `err == EMSGSIZE`).
+ * `pmtu_probe` sets the DF bit but ignores the path MTU known to the kernel,
+ * for probing larger sizes; `pmtu_dont` lets the datagrams be fragmented.
+ *
+ * Also enables `IP_RECVERR`/`IPV6_RECVERR`, so every MTU change is reported
+ * by `reap_pmtu()`.
+ */
+void inet_dgram_client::set_pmtu_discovery(pmtu_mode mode) {
+#if LIBSOCKET_LINUX
+    static const int modes4[] = {IP_PMTUDISC_DONT, IP_PMTUDISC_DO,
+                                 IP_PMTUDISC_PROBE};
+    static const int modes6[] = {IPV6_PMTUDISC_DONT, IPV6_PMTUDISC_DO,
+                                 IPV6_PMTUDISC_PROBE};
+    int family = socket_family(sfd);
+    int on = 1;
+    int ret;
+
+    if (family == AF_INET6) {
+        ret = setsockopt(sfd, IPPROTO_IPV6, IPV6_MTU_DISCOVER, &modes6[mode],
+                         sizeof(int));
+        if (ret == 0)
+            ret = setsockopt(sfd, IPPROTO_IPV6, IPV6_RECVERR, &on, sizeof(on));
+    } else {
+        ret = setsockopt(sfd, IPPROTO_IP, IP_MTU_DISCOVER, &modes4[mode],
+                         sizeof(int));
+        if (ret == 0)
+            ret = setsockopt(sfd, IPPROTO_IP, IP_RECVERR, &on, sizeof(on));
+    }
+
+    if (ret < 0)
+        throw socket_exception(__FILE__, __LINE__,
+                               "inet_dgram_client::set_pmtu_discovery() - "
+                               "Could not set socket option!");
+#else
+    (void)mode;
+    errno = ENOSYS;
+    throw socket_exception(__FILE__, __LINE__,
+                           "inet_dgram_client::set_pmtu_discovery() - Not "
+                           "supported on this platform");
+#endif
 }
+
+/**
+ * @brief The path MTU to the connected peer, as currently known to the kernel
+ * (`IP_MTU`/`IPV6_MTU`). Linux only.
+ *
+ * Only available while the socket is connected.
+ */
+int inet_dgram_client::path_mtu(void) const {
+#if LIBSOCKET_LINUX
+    int mtu;
+    socklen_t len = sizeof(mtu);
+    int ret;
+
+    if (socket_family(sfd) == AF_INET6)
+        ret = getsockopt(sfd, IPPROTO_IPV6, IPV6_MTU, &mtu, &len);
+    else
+        ret = getsockopt(sfd, IPPROTO_IP, IP_MTU, &mtu, &len);
+
+    if (ret < 0)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "inet_dgram_client::path_mtu() - Could not get path MTU!");
+
+    return mtu;
+#else
+    errno = ENOSYS;
+    throw socket_exception(
+        __FILE__, __LINE__,
+        "inet_dgram_client::path_mtu() - Not supported on this platform");
+#endif
+}
+
+/**
+ * @brief The largest datagram that can be sent to the connected peer without
+ * fragmentation: the path MTU minus the IP and UDP headers. Linux only.
+ *
+ * Use it to size datagrams, or as segment size for `snd_segmented()`.
+ */
+size_t inet_dgram_client::max_payload(void) const {
+    int mtu = path_mtu();
+    int headers = (socket_family(sfd) == AF_INET6 ? 40 : 20) + 8;
+
+    return mtu > headers ? mtu - headers : 0;
+}
+
+/**
+ * @brief Process the "message too long" events in the socket's error queue.
+ * Linux only.
+ *
+ * After `set_pmtu_discovery()`, the kernel queues an event whenever it learns
+ * a smaller path MTU from an ICMP message, and whenever a datagram could not
+ * be sent because it exceeded the known MTU. A socket with pending events is
+ * reported by `poll(2)` with `POLLERR`. This function never blocks.
+ *
+ * Other messages in the error queue (e.g. ICMP "port unreachable") are
+ * discarded, so do not mix it with `reap_zerocopy()` on the same socket.
+ *
+ * @param callback Called with the new path MTU for every event.
+ *
+ * @returns The number of events processed.
+ */
+size_t inet_dgram_client::reap_pmtu(
+    const std::function<void(uint32_t)>& callback) {
+#if LIBSOCKET_LINUX
+    size_t reaped = 0;
+
+    while (true) {
+        char control[256];
+        struct msghdr msg;
+
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        if (0 > recvmsg(sfd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT)) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            if (errno == EINTR) continue;
+
+            throw socket_exception(
+                __FILE__, __LINE__,
+                "inet_dgram_client::reap_pmtu() - Could not read error queue!");
+        }
+
+        for (struct cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != NULL;
+             cm = CMSG_NXTHDR(&msg, cm)) {
+            if (!(cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) &&
+                !(cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))
+                continue;
+
+            const struct sock_extended_err* err =
+                reinterpret_cast<const struct sock_extended_err*>(
+                    CMSG_DATA(cm));
+
+            if (err->ee_errno != EMSGSIZE) continue;
+
+            // For local errors as well as ICMP(v6) messages, ee_info is the
+            // MTU.
+            callback(err->ee_info);
+            reaped++;
+        }
+    }
+
+    return reaped;
+#else
+    (void)callback;
+    errno = ENOSYS;
+    throw socket_exception(
+        __FILE__, __LINE__,
+        "inet_dgram_client::reap_pmtu() - Not supported on this platform");
+#endif
+}
+
+#if LIBSOCKET_HAVE_STRING_VIEW
+/**
+ * @brief Create and connect a UDP socket
+ *
+ * Like the `const char*` constructor; `dsthost` and `dstport` need not be
+ * null-terminated.
+ */
+inet_dgram_client::inet_dgram_client(std::string_view dsthost,
+                                     std::string_view dstport, int proto_osi3,
+                                     int flags) {
+    setup(c_string<>(dsthost).c_str(), c_string<NI_MAXSERV>(dstport).c_str(),
+          proto_osi3, flags);
+}
+
+/**
+ * @brief Connect datagram socket
+ *
+ * Like `connect(const char*, const char*)`.
+ */
+void inet_dgram_client::connect(std::string_view dsthost,
+                                std::string_view dstport) {
+    connect(c_string<>(dsthost).c_str(), c_string<NI_MAXSERV>(dstport).c_str());
+}
+
+/**
+ * @brief Connect datagram socket, without throwing
+ *
+ * See above.
+ */
+void inet_dgram_client::connect(std::string_view dsthost,
+                                std::string_view dstport, std::error_code& ec) {
+    connect(c_string<>(dsthost).c_str(), c_string<NI_MAXSERV>(dstport).c_str(),
+            ec);
+}
+#endif
 }  // namespace libsocket
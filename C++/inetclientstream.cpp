@@ -60,9 +60,22 @@
  * 	The I/O abilities are inherited from stream_client_socket.
  */
 
+#include <conf.h>
+
+#if LIBSOCKET_LINUX
+#include <netinet/tcp.h>
+#endif
+
 #include <libinetsocket.h>
 #include <exception.hpp>
 #include <inetclientstream.hpp>
+#include <inetstreamconnector.hpp>
+#include <resolver.hpp>
+
+#include <fcntl.h>
+#ifndef SOCK_NONBLOCK
+#define SOCK_NONBLOCK O_NONBLOCK
+#endif
 
 namespace libsocket {
 using std::string;
@@ -100,49 +113,60 @@ inet_stream::inet_stream(const string& dsthost, const string& dstport,
     connect(dsthost.c_str(), dstport.c_str(), proto_osi3, flags);
 }
 
+/*
+ * Returns the connected socket, or -1 with errno set or with `*gai_error` set
+ * if host/service could not be resolved.
+ */
 static int _create_inet_stream_socket_(const char *host, const char *service,
-                                     char proto_osi3, int flags, std::string& bufferHost, std::string& bufferPort) {
+                                     char proto_osi3, int flags,
+                                     int* gai_error) {
 
-    int sfd, return_value;
-    struct addrinfo hint, *result, *result_check;
+    int sfd = -1, family;
+    const struct addrinfo* result_check;
 #ifdef VERBOSE
     const char *errstring;
 #endif
 
-    if (host == NULL || service == NULL) return -1;
+    *gai_error = 0;
 
-    memset(&hint, 0, sizeof hint);
+    if (host == NULL || service == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
 
     // set address family
     switch (proto_osi3) {
         case LIBSOCKET_IPv4:
-            hint.ai_family = AF_INET;
+            family = AF_INET;
             break;
         case LIBSOCKET_IPv6:
-            hint.ai_family = AF_INET6;
+            family = AF_INET6;
             break;
         case LIBSOCKET_BOTH:
-            hint.ai_family = AF_UNSPEC;
+            family = AF_UNSPEC;
             break;
         default:
+            *gai_error = EAI_FAMILY;
             return -1;
     }
 
     // Transport protocol is TCP
-    hint.ai_socktype = SOCK_STREAM;
+    std::shared_ptr<const resolved_addresses> result =
+        resolver::lookup(host, service, family, SOCK_STREAM);
 
-    if (0 != (return_value = getaddrinfo(host, service, &hint, &result))) {
+    if (0 != result->error()) {
 #ifdef VERBOSE
-        errstring = gai_strerror(return_value);
+        errstring = gai_strerror(result->error());
         debug_write(errstring);
 #endif
+        *gai_error = result->error();
         return -1;
     }
 
     // As described in "The Linux Programming Interface", Michael Kerrisk 2010,
     // chapter 59.11 (p. 1220ff)
 
-    for (result_check = result; result_check != NULL;
+    for (result_check = result->list(); result_check != NULL;
          result_check = result_check->ai_next)  // go through the linked list of
         // struct addrinfo elements
     {
@@ -155,17 +179,6 @@ static int _create_inet_stream_socket_(const char *host, const char *service,
         int CON_RES = connect(sfd, result_check->ai_addr,
                               result_check->ai_addrlen);
 
-        struct sockaddr_in server_addr, my_addr;
-        // Get my ip address and port
-        bzero(&my_addr, sizeof(my_addr));
-        socklen_t len = sizeof(my_addr);
-        getsockname(sfd, (struct sockaddr *) &my_addr, &len);
-
-        char tmpIP[16]{0};
-        inet_ntop(AF_INET, &my_addr.sin_addr, tmpIP, 16);
-        bufferHost = tmpIP;
-        bufferPort = std::to_string(ntohs(my_addr.sin_port));
-
 
         if ((CON_RES != -1) || (CON_RES == -1 && (flags |= SOCK_NONBLOCK) && ((errno == EINPROGRESS) || (errno == EALREADY) || (errno == EINTR))))     // connected without error, or, connected with errno being one of these important states
             break;
@@ -181,16 +194,10 @@ static int _create_inet_stream_socket_(const char *host, const char *service,
         debug_write(
             "create_inet_stream_socket: Could not connect to any address!\n");
 #endif
-        int errno_saved = errno;
-        close(sfd);
-        errno = errno_saved;
-        freeaddrinfo(result);
         return -1;
     }
     // Yes :)
 
-    freeaddrinfo(result);
-
     return sfd;
 }
 
@@ -201,30 +208,61 @@ static int _create_inet_stream_socket_(const char *host, const char *service,
  * Creates TCP/IP client socket and connects. Fails if the socket is already set
  * up.
  *
+ * A blocking connect tries all addresses of `dsthost` the way
+ * `inet_stream_connector` does: if the first address has not answered after
+ * `attempt_delay` milliseconds, the next one is tried in parallel, alternating
+ * between IPv6 and IPv4. With `SOCK_NONBLOCK`, the socket is connected to the
+ * first address that does not fail immediately, as before; use an
+ * `inet_stream_connector` to try all addresses without blocking.
+ *
  * @param dsthost Remote host
  * @param dstport Remote port
  * @param proto_osi3 `LIBSOCKET_IPv4` or `LIBSOCKET_IPv6` or `LIBSOCKET_BOTH`
  * @param flags Flags for `socket(2)`
+ * @param attempt_delay Milliseconds between connection attempts
  */
 void inet_stream::connect(const char* dsthost, const char* dstport,
-                          int proto_osi3, int flags) {
+                          int proto_osi3, int flags, int attempt_delay) {
     if (sfd != -1)
         throw socket_exception(__FILE__, __LINE__,
                                "inet_stream::connect() - Already connected!",
                                false);
 
+    if (flags & SOCK_NONBLOCK) {
+        int gai_error;
 
-    sfd = _create_inet_stream_socket_(dsthost, dstport, proto_osi3, flags, hostClient, portClient);
+        sfd = _create_inet_stream_socket_(dsthost, dstport, proto_osi3, flags,
+                                          &gai_error);
 
-    if (sfd < 0)
-        throw socket_exception(
-            __FILE__, __LINE__,
-            "inet_stream::connect() - Could not create socket");
+        if (sfd < 0)
+            throw socket_exception(
+                __FILE__, __LINE__,
+                "inet_stream::connect() - Could not create socket");
+    } else {
+        if (dsthost == NULL || dstport == NULL)
+            throw socket_exception(
+                __FILE__, __LINE__,
+                "inet_stream::connect() - Host or port is null!", false);
+
+        inet_stream_connector connector(dsthost, dstport, proto_osi3, flags,
+                                         attempt_delay);
+
+        while (!connector.step(-1))
+            ;
+
+        std::unique_ptr<inet_stream> connected = connector.result();
+
+        sfd = connected->sfd;
+        connected->sfd = -1;
+    }
+
+    forget_client();
 
     host = dsthost;
     port = dstport;
 
     proto = proto_osi3;
+    is_nonblocking = flags & SOCK_NONBLOCK;
 
     // New file descriptor, therefore reset shutdown flags
     shut_rd = false;
@@ -241,9 +279,339 @@ void inet_stream::connect(const char* dsthost, const char* dstport,
  * @param dstport Remote port
  * @param proto_osi3 `LIBSOCKET_IPv4` or `LIBSOCKET_IPv6` or `LIBSOCKET_BOTH`
  * @param flags Flags for `socket(2)`
+ * @param attempt_delay Milliseconds between connection attempts
  */
 void inet_stream::connect(const string& dsthost, const string& dstport,
-                          int proto_osi3, int flags) {
-    connect(dsthost.c_str(), dstport.c_str(), proto_osi3, flags);
+                          int proto_osi3, int flags, int attempt_delay) {
+    connect(dsthost.c_str(), dstport.c_str(), proto_osi3, flags,
+            attempt_delay);
 }
+
+/**
+ * @brief Connect, without throwing.
+ *
+ * Works like `connect()`, but reports errors in `ec` instead of throwing. If
+ * `dsthost` can not be resolved, `ec` is in `addrinfo_category()`.
+ *
+ * @param dsthost Remote host
+ * @param dstport Remote port
+ * @param proto_osi3 `LIBSOCKET_IPv4` or `LIBSOCKET_IPv6` or `LIBSOCKET_BOTH`
+ * @param ec Set to the error, or cleared.
+ * @param flags Flags for `socket(2)`
+ * @param attempt_delay Milliseconds between connection attempts
+ */
+void inet_stream::connect(const char* dsthost, const char* dstport,
+                          int proto_osi3, std::error_code& ec, int flags,
+                          int attempt_delay) {
+    int gai_error;
+
+    if (sfd != -1) {
+        ec.assign(EISCONN, std::system_category());
+        return;
+    }
+    if (dsthost == NULL || dstport == NULL) {
+        ec.assign(EINVAL, std::system_category());
+        return;
+    }
+
+    if (flags & SOCK_NONBLOCK) {
+        if (0 > (sfd = _create_inet_stream_socket_(dsthost, dstport, proto_osi3,
+                                                   flags, &gai_error))) {
+            sfd = -1;
+            ec = gai_error != 0 ? addrinfo_error(gai_error)
+                                : std::error_code(errno, std::system_category());
+            return;
+        }
+    } else {
+        int family;
+
+        switch (proto_osi3) {
+            case LIBSOCKET_IPv4:
+                family = AF_INET;
+                break;
+            case LIBSOCKET_IPv6:
+                family = AF_INET6;
+                break;
+            case LIBSOCKET_BOTH:
+                family = AF_UNSPEC;
+                break;
+            default:
+                ec = addrinfo_error(EAI_FAMILY);
+                return;
+        }
+
+        std::shared_ptr<const resolved_addresses> resolved =
+            resolver::lookup(dsthost, dstport, family, SOCK_STREAM);
+
+        if (0 != (gai_error = resolved->error())) {
+            ec = addrinfo_error(gai_error);
+            return;
+        }
+
+        std::unique_ptr<inet_stream> connected;
+
+        try {
+            // Throws only if poll() or fcntl() fail, or without addresses.
+            inet_stream_connector connector(resolved->list(), flags,
+                                            attempt_delay);
+
+            while (!connector.step(-1))
+                ;
+
+            connected = connector.result(ec);
+        } catch (const socket_exception& exc) {
+            ec.assign(exc.err != 0 ? exc.err : EADDRNOTAVAIL,
+                      std::system_category());
+        }
+
+        if (!connected) return;
+
+        sfd = connected->sfd;
+        connected->sfd = -1;
+    }
+
+    forget_client();
+
+    host = dsthost;
+    port = dstport;
+
+    proto = proto_osi3;
+    is_nonblocking = flags & SOCK_NONBLOCK;
+
+    shut_rd = false;
+    shut_wr = false;
+
+    ec.clear();
+}
+
+/**
+ * @brief Connect, without throwing.
+ *
+ * See above.
+ */
+void inet_stream::connect(const string& dsthost, const string& dstport,
+                          int proto_osi3, std::error_code& ec, int flags,
+                          int attempt_delay) {
+    connect(dsthost.c_str(), dstport.c_str(), proto_osi3, ec, flags,
+            attempt_delay);
+}
+
+/**
+ * @brief Connect and send the first data with the SYN (TCP Fast Open).
+ *
+ * If the server has handed out a Fast Open cookie to this host before, the
+ * data travels in the SYN and the server may answer it without waiting for the
+ * handshake to finish, saving one round trip. Otherwise the kernel requests a
+ * cookie and sends the data after the handshake; the next connection to the
+ * server can then use it. Whether the server took the data from the SYN is
+ * reported by `fastopen_accepted()`.
+ *
+ * The addresses of `dsthost` are tried one after another. Fast Open requires
+ * Linux with bit 1 of `net.ipv4.tcp_fastopen` set (the default) and a server
+ * that enables it (see `OptionalStream::fastOpenQueue`); elsewhere this is a
+ * plain `connect()` followed by `snd()`.
+ *
+ * @param dsthost Remote host
+ * @param dstport Remote port
+ * @param proto_osi3 `LIBSOCKET_IPv4` or `LIBSOCKET_IPv6` or `LIBSOCKET_BOTH`
+ * @param buf The first data to send, e.g. a request
+ * @param len Its length; may be 0
+ * @param flags Flags for `socket(2)`
+ *
+ * @returns The number of bytes sent. With `SOCK_NONBLOCK`, this is what went
+ * out with the SYN and may be 0; send the rest with `snd()` once the socket is
+ * writable.
+ */
+ssize_t inet_stream::connect_fastopen(const char* dsthost, const char* dstport,
+                                      int proto_osi3, const void* buf,
+                                      size_t len, int flags) {
+    if (sfd != -1)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "inet_stream::connect_fastopen() - Already connected!", false);
+    if (dsthost == NULL || dstport == NULL || (buf == NULL && len > 0))
+        throw socket_exception(__FILE__, __LINE__,
+                               "inet_stream::connect_fastopen() - Host, port "
+                               "or buffer is null!",
+                               false);
+
+    int family;
+
+    switch (proto_osi3) {
+        case LIBSOCKET_IPv4:
+            family = AF_INET;
+            break;
+        case LIBSOCKET_IPv6:
+            family = AF_INET6;
+            break;
+        case LIBSOCKET_BOTH:
+            family = AF_UNSPEC;
+            break;
+        default:
+            throw socket_exception(
+                __FILE__, __LINE__,
+                "inet_stream::connect_fastopen() - Unknown protocol!", false);
+    }
+
+    std::shared_ptr<const resolved_addresses> result =
+        resolver::lookup(dsthost, dstport, family, SOCK_STREAM);
+
+    if (result->error() != 0)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            string("inet_stream::connect_fastopen() - Could not resolve "
+                   "host: ") +
+                gai_strerror(result->error()),
+            false);
+
+    int fd = -1;
+    ssize_t sent = -1;
+
+    for (const struct addrinfo* ai = result->list(); ai != NULL;
+         ai = ai->ai_next) {
+        fd = ::socket(ai->ai_family, SOCK_STREAM | flags, ai->ai_protocol);
+
+        if (fd < 0) continue;
+
+#if LIBSOCKET_LINUX && defined(MSG_FASTOPEN)
+        sent = ::sendto(fd, buf, len, MSG_FASTOPEN, ai->ai_addr,
+                        ai->ai_addrlen);
+
+        if (sent >= 0) break;
+
+        // Non-blocking, and nothing went out with the SYN.
+        if (errno == EINPROGRESS) {
+            sent = 0;
+            break;
+        }
+
+        // Fast Open is disabled on this host; fall back to connect().
+        if (errno != EOPNOTSUPP) {
+            ::close(fd);
+            fd = -1;
+            continue;
+        }
+#endif
+
+        if (0 > ::connect(fd, ai->ai_addr, ai->ai_addrlen)) {
+            if (errno == EINPROGRESS) {
+                sent = 0;
+                break;
+            }
+
+            ::close(fd);
+            fd = -1;
+            continue;
+        }
+
+        sent = len > 0 ? ::send(fd, buf, len, 0) : 0;
+
+        if (sent < 0 && errno == EWOULDBLOCK) sent = 0;
+
+        if (sent >= 0) break;
+
+        ::close(fd);
+        fd = -1;
+    }
+
+    if (fd < 0)
+        throw socket_exception(__FILE__, __LINE__,
+                               "inet_stream::connect_fastopen() - Could not "
+                               "connect to any address!");
+
+    sfd = fd;
+    forget_client();
+
+    host = dsthost;
+    port = dstport;
+
+    proto = proto_osi3;
+    is_nonblocking = flags & SOCK_NONBLOCK;
+
+    shut_rd = false;
+    shut_wr = false;
+
+    return sent;
+}
+
+/**
+ * @brief Connect and send the first data with the SYN (TCP Fast Open).
+ *
+ * See `connect_fastopen(const char*, const char*, int, const void*, size_t,
+ * int)`.
+ */
+ssize_t inet_stream::connect_fastopen(const string& dsthost,
+                                      const string& dstport, int proto_osi3,
+                                      const void* buf, size_t len,
+                                      int flags) {
+    return connect_fastopen(dsthost.c_str(), dstport.c_str(), proto_osi3, buf,
+                            len, flags);
+}
+
+/**
+ * @brief Whether the server accepted the data sent with the SYN by
+ * `connect_fastopen()`.
+ *
+ * Only meaningful once the handshake is complete, i.e. after a blocking
+ * `connect_fastopen()` or once a non-blocking socket has become writable.
+ * `false` on the first connection to a server (which only fetches a cookie),
+ * if the server does not support Fast Open, and on non-Linux systems.
+ */
+bool inet_stream::fastopen_accepted(void) const {
+    if (sfd == -1)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "inet_stream::fastopen_accepted() - Socket not connected!", false);
+
+#if LIBSOCKET_LINUX && defined(TCPI_OPT_SYN_DATA)
+    struct tcp_info info;
+    socklen_t infolen = sizeof(info);
+
+    if (0 > getsockopt(sfd, IPPROTO_TCP, TCP_INFO, &info, &infolen))
+        throw socket_exception(__FILE__, __LINE__,
+                               "inet_stream::fastopen_accepted() - Could not "
+                               "get TCP_INFO!");
+
+    return info.tcpi_options & TCPI_OPT_SYN_DATA;
+#else
+    return false;
+#endif
+}
+
+#if LIBSOCKET_HAVE_STRING_VIEW
+/**
+ * @brief Connecting constructor
+ *
+ * Like `inet_stream(const char*, const char*, int, int)`; `dsthost` and
+ * `dstport` need not be null-terminated.
+ */
+inet_stream::inet_stream(std::string_view dsthost, std::string_view dstport,
+                         int proto_osi3, int flags) {
+    connect(dsthost, dstport, proto_osi3, flags);
+}
+
+/**
+ * @brief Connect
+ *
+ * Like `connect(const char*, const char*, int, int, int)`; `dsthost` and
+ * `dstport` need not be null-terminated.
+ */
+void inet_stream::connect(std::string_view dsthost, std::string_view dstport,
+                          int proto_osi3, int flags, int attempt_delay) {
+    connect(c_string<>(dsthost).c_str(), c_string<NI_MAXSERV>(dstport).c_str(),
+            proto_osi3, flags, attempt_delay);
+}
+
+/**
+ * @brief Connect, without throwing.
+ *
+ * See above.
+ */
+void inet_stream::connect(std::string_view dsthost, std::string_view dstport,
+                          int proto_osi3, std::error_code& ec, int flags,
+                          int attempt_delay) {
+    connect(c_string<>(dsthost).c_str(), c_string<NI_MAXSERV>(dstport).c_str(),
+            proto_osi3, ec, flags, attempt_delay);
+}
+#endif
 }  // namespace libsocket
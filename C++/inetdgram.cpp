@@ -44,13 +44,138 @@
  * 	may be used for both client and server UDP sockets.
  */
 
+#include <conf.h>
+
+#include <netdb.h>
+#if LIBSOCKET_LINUX
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <dgrambatch.hpp>
+#endif
+
 #include <libinetsocket.h>
 #include <exception.hpp>
+#include <bufferpool.hpp>
 #include <inetdgram.hpp>
+#include <resolver.hpp>
 
 namespace libsocket {
 using std::string;
 
+/*
+ * Resolves host/port through the resolver cache. Returns NULL, with `*error`
+ * set to the getaddrinfo() error code, if there is no address of `family`.
+ */
+static std::shared_ptr<const resolved_addresses> resolve_peers(
+    int family, const char* host, const char* port, int* error) {
+    // Both families, so all sockets share one cache entry per peer.
+    std::shared_ptr<const resolved_addresses> result =
+        resolver::lookup(host, port, AF_UNSPEC, SOCK_DGRAM);
+
+    if (0 != (*error = result->error())) return nullptr;
+
+    for (const struct addrinfo* ai = result->list(); ai != NULL;
+         ai = ai->ai_next)
+        if (ai->ai_family == family) return result;
+
+    *error = EAI_NONAME;
+
+    return nullptr;
+}
+
+/*
+ * Resolves host/port to the first address of the same family as `sfd`, like
+ * sendto_inet_dgram_socket() does. Returns 0 on success; -1 with errno set or
+ * the getaddrinfo() error code otherwise.
+ */
+static int resolve_peer(int sfd, const char* host, const char* port,
+                        struct sockaddr_storage* addr, socklen_t* addrlen) {
+    struct sockaddr_storage local;
+    socklen_t locallen = sizeof(local);
+    int ret;
+
+    if (0 > getsockname(sfd, (struct sockaddr*)&local, &locallen)) return -1;
+
+    std::shared_ptr<const resolved_addresses> result =
+        resolve_peers(local.ss_family, host, port, &ret);
+
+    if (!result) return ret;
+
+    for (const struct addrinfo* ai = result->list(); ai != NULL;
+         ai = ai->ai_next) {
+        if (ai->ai_family != local.ss_family) continue;
+
+        memcpy(addr, ai->ai_addr, ai->ai_addrlen);
+        *addrlen = ai->ai_addrlen;
+        break;
+    }
+
+    return 0;
+}
+
+/*
+ * What sendto_inet_dgram_socket() does, with the destination resolved through
+ * the resolver cache: tries the addresses of host/port until one send works.
+ * Returns -1 with errno set, or with `*gai_error` set if host/port could not be
+ * resolved.
+ */
+static ssize_t sendto_host(int sfd, const void* buf, size_t len,
+                           const char* host, const char* port, int flags,
+                           int* gai_error) {
+    struct sockaddr_storage local;
+    socklen_t locallen = sizeof(local);
+    ssize_t bytes = -1;
+
+    *gai_error = 0;
+
+    if (buf == NULL || host == NULL || port == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (len == 0) return 0;
+
+    if (0 > getsockname(sfd, (struct sockaddr*)&local, &locallen)) return -1;
+
+    std::shared_ptr<const resolved_addresses> result =
+        resolve_peers(local.ss_family, host, port, gai_error);
+
+    if (!result) return -1;
+
+    for (const struct addrinfo* ai = result->list(); ai != NULL;
+         ai = ai->ai_next) {
+        if (ai->ai_family != local.ss_family) continue;
+
+        if (-1 != (bytes = ::sendto(sfd, buf, len, flags, ai->ai_addr,
+                                    ai->ai_addrlen)))
+            break;
+    }
+
+    return bytes;
+}
+
+/*
+ * Converts a sender address to host and port strings like
+ * recvfrom_inet_dgram_socket() does.
+ */
+static void peer_name(const struct sockaddr_storage* addr, socklen_t addrlen,
+                      string& host, string& port, bool numeric) {
+    char hostbuf[NI_MAXHOST], portbuf[NI_MAXSERV];
+    int ret;
+
+    if (0 != (ret = getnameinfo((const struct sockaddr*)addr, addrlen, hostbuf,
+                                sizeof(hostbuf), portbuf, sizeof(portbuf),
+                                numeric ? NI_NUMERICHOST | NI_NUMERICSERV
+                                        : 0)))
+        throw socket_exception(
+            __FILE__, __LINE__,
+            string("inet_dgram - getnameinfo() failed: ") + gai_strerror(ret),
+            false);
+
+    host = hostbuf;
+    port = portbuf;
+}
+
 // I/O
 
 // I
@@ -187,6 +312,48 @@ ssize_t inet_dgram::rcvfrom(string& buf, string& srchost, string& srcport,
 
 // O
 
+/**
+ * @brief Receive data from peer, along with the kernel receive timestamp
+ *
+ * Works like `rcvfrom()`, but also returns when the kernel received the
+ * datagram. Requires `set_timestamps()`.
+ *
+ * @param buf Target memory
+ * @param len The size of the target memory
+ * @param srchost String to place the remote host's name to
+ * @param srcport Like `srchost` but for the remote port
+ * @param stamp Set to the time (`CLOCK_REALTIME`) at which the kernel received
+ * the datagram; zero if no timestamp is available.
+ * @param rcvfrom_flags Flags for `recvmsg(2)`
+ * @param numeric If remote host and port should be saved numerically
+ *
+ * @retval >0 n bytes of data were read into `buf`.
+ * @retval -1 Socket is non-blocking and returned without any data.
+ */
+ssize_t inet_dgram::rcvfrom(void* buf, size_t len, string& srchost,
+                            string& srcport, struct timespec* stamp,
+                            int rcvfrom_flags, bool numeric) {
+    struct sockaddr_storage src;
+    socklen_t srclen = sizeof(src);
+    ssize_t bytes;
+
+    if (-1 == sfd)
+        throw socket_exception(__FILE__, __LINE__,
+                               "inet_dgram::rcvfrom() - Socket is closed!",
+                               false);
+    if (stamp == NULL)
+        throw socket_exception(__FILE__, __LINE__,
+                               "inet_dgram::rcvfrom() - Stamp is null!", false);
+
+    bytes = recv_message(buf, len, &src, &srclen, rcvfrom_flags, NULL, stamp);
+
+    if (bytes < 0) return bytes;
+
+    peer_name(&src, srclen, srchost, srcport, numeric);
+
+    return bytes;
+}
+
 /**
  * @brief Send data to UDP peer
  *
@@ -207,14 +374,15 @@ ssize_t inet_dgram::rcvfrom(string& buf, string& srchost, string& srcport,
 ssize_t inet_dgram::sndto(const void* buf, size_t len, const char* dsthost,
                           const char* dstport, int sndto_flags) {
     ssize_t bytes;
+    int gai_error;
 
     if (-1 == sfd)
         throw socket_exception(__FILE__, __LINE__,
                                "inet_dgram::sendto() - Socket already closed!",
                                false);
 
-    if (-1 == (bytes = sendto_inet_dgram_socket(sfd, buf, len, dsthost, dstport,
-                                                sndto_flags))) {
+    if (-1 == (bytes = sendto_host(sfd, buf, len, dsthost, dstport,
+                                   sndto_flags, &gai_error))) {
         if (is_nonblocking && errno == EWOULDBLOCK)
             return -1;
         else
@@ -272,4 +440,636 @@ ssize_t inet_dgram::sndto(const string& buf, const string& dsthost,
 
     return bytes;
 }
+
+/**
+ * @brief Receive data from peer, without throwing
+ *
+ * Works like `rcvfrom()`, but reports errors in `ec` instead of throwing.
+ *
+ * @param buf Target memory
+ * @param len The size of the target memory
+ * @param hostbuf Buffer to write the peer's hostname to
+ * @param hostbuflen Its length
+ * @param portbuf Like `hostbuf`, but for the remote port
+ * @param portbuflen `portbuf`'s length
+ * @param ec Set to the error, or cleared.
+ * @param rcvfrom_flags Flags to be passed to `recvfrom(2)`
+ * @param numeric If host and port should be saved numerically. Looking up
+ * names may take long; hot paths should set this.
+ *
+ * @returns The length of the datagram, or -1 on error (also if the socket is
+ * non-blocking and there was no datagram).
+ */
+ssize_t inet_dgram::rcvfrom(void* buf, size_t len, char* hostbuf,
+                            size_t hostbuflen, char* portbuf, size_t portbuflen,
+                            std::error_code& ec, int rcvfrom_flags,
+                            bool numeric) {
+    ssize_t bytes;
+
+    if (-1 == sfd) {
+        ec.assign(EBADF, std::system_category());
+        return -1;
+    }
+
+    if (-1 == (bytes = recvfrom_inet_dgram_socket(
+                   sfd, buf, len, hostbuf, hostbuflen, portbuf, portbuflen,
+                   rcvfrom_flags, numeric ? LIBSOCKET_NUMERIC : 0)))
+        ec.assign(errno, std::system_category());
+    else
+        ec.clear();
+
+    return bytes;
+}
+
+/**
+ * @brief Receive data from peer, without throwing; C++ string host and port
+ *
+ * See above.
+ */
+ssize_t inet_dgram::rcvfrom(void* buf, size_t len, string& srchost,
+                            string& srcport, std::error_code& ec,
+                            int rcvfrom_flags, bool numeric) {
+    char hostbuf[NI_MAXHOST], portbuf[NI_MAXSERV];
+    ssize_t bytes;
+
+    bytes = rcvfrom(buf, len, hostbuf, sizeof(hostbuf), portbuf,
+                    sizeof(portbuf), ec, rcvfrom_flags, numeric);
+
+    if (bytes >= 0) {
+        srchost.assign(hostbuf);
+        srcport.assign(portbuf);
+    }
+
+    return bytes;
+}
+
+/**
+ * @brief Send data to UDP peer, without throwing
+ *
+ * Works like `sndto()`, but reports errors in `ec` instead of throwing. If the
+ * destination can not be resolved, `ec` is in `addrinfo_category()`.
+ *
+ * @param buf The data to be sent
+ * @param len Length of transmission
+ * @param dsthost Target host
+ * @param dstport Target port
+ * @param ec Set to the error, or cleared.
+ * @param sndto_flags Flags for `sendto(2)`
+ *
+ * @returns The number of bytes sent, or -1 on error (also if the socket is
+ * non-blocking and didn't send any data).
+ */
+ssize_t inet_dgram::sndto(const void* buf, size_t len, const char* dsthost,
+                          const char* dstport, std::error_code& ec,
+                          int sndto_flags) {
+    ssize_t bytes;
+    int gai_error;
+
+    if (-1 == sfd) {
+        ec.assign(EBADF, std::system_category());
+        return -1;
+    }
+
+    if (-1 == (bytes = sendto_host(sfd, buf, len, dsthost, dstport,
+                                   sndto_flags, &gai_error))) {
+        if (gai_error != 0)
+            ec = addrinfo_error(gai_error);
+        else
+            ec.assign(errno, std::system_category());
+    } else
+        ec.clear();
+
+    return bytes;
+}
+
+/**
+ * @brief Send data to UDP peer, without throwing; C++ string host and port
+ *
+ * See above.
+ */
+ssize_t inet_dgram::sndto(const void* buf, size_t len, const string& dsthost,
+                          const string& dstport, std::error_code& ec,
+                          int sndto_flags) {
+    return sndto(buf, len, dsthost.c_str(), dstport.c_str(), ec, sndto_flags);
+}
+
+/**
+ * @brief Send a datagram without copying it into the kernel (`MSG_ZEROCOPY`)
+ *
+ * Zero-copy mode has to be enabled with `set_zerocopy()` first. `buf` must not
+ * be changed until `reap_zerocopy()` reports a completion covering `*id`. Only
+ * worthwhile for large datagrams, e.g. when using UDP segmentation offload.
+ *
+ * @param buf The data to be sent
+ * @param len Length of transmission
+ * @param dsthost Target host
+ * @param dstport Target port
+ * @param id Set to the id of this send (may be NULL)
+ * @param sndto_flags Additional flags for `sendto(2)`
+ *
+ * @retval >0 n bytes of data were sent.
+ * @retval -1 Socket is non-blocking and didn't send any data, or the kernel
+ * does not allow more memory to be pinned (`errno` is `ENOBUFS`).
+ */
+ssize_t inet_dgram::sndto_zerocopy(const void* buf, size_t len,
+                                   const string& dsthost,
+                                   const string& dstport, uint32_t* id,
+                                   int sndto_flags) {
+    ssize_t bytes;
+
+    if (-1 == sfd)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "inet_dgram::sndto_zerocopy() - Socket already closed!", false);
+    if (!zerocopy)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "inet_dgram::sndto_zerocopy() - Zero-copy mode is not enabled!",
+            false);
+
+#if LIBSOCKET_LINUX
+    int gai_error;
+
+    if (-1 == (bytes = sendto_host(sfd, buf, len, dsthost.c_str(),
+                                   dstport.c_str(), sndto_flags | MSG_ZEROCOPY,
+                                   &gai_error))) {
+        if ((is_nonblocking && errno == EWOULDBLOCK) || errno == ENOBUFS)
+            return -1;
+        else
+            throw socket_exception(
+                __FILE__, __LINE__,
+                "inet_dgram::sndto_zerocopy() - Error at sendto");
+    }
+
+    // Empty datagrams are not sent by sendto_host() and do not
+    // get an id.
+    if (bytes > 0) {
+        if (id != NULL) *id = zerocopy_next;
+        zerocopy_next++;
+    }
+
+    return bytes;
+#else
+    (void)buf;
+    (void)len;
+    (void)dsthost;
+    (void)dstport;
+    (void)id;
+    (void)sndto_flags;
+    (void)bytes;
+    errno = ENOSYS;
+    throw socket_exception(
+        __FILE__, __LINE__,
+        "inet_dgram::sndto_zerocopy() - Not supported on this platform");
+#endif
+}
+
+/**
+ * @brief Send a burst of equally-sized datagrams with one system call (UDP
+ * GSO). Linux only.
+ *
+ * `buf` is split into datagrams of `segment_size` bytes each (the last one
+ * may be shorter), which are sent to `dsthost`. The kernel (or the NIC)
+ * segments the buffer as late as possible, which is much cheaper than sending
+ * every datagram with its own `sndto()`.
+ *
+ * The kernel accepts at most 64 segments and 64 KiB per call, and the segment
+ * size plus headers must fit into the path MTU.
+ *
+ * @param buf The data to be sent
+ * @param len Length of `buf`
+ * @param segment_size Payload size of each datagram, at most 65535
+ * @param dsthost Target host
+ * @param dstport Target port
+ * @param sndto_flags Flags for `sendmsg(2)`
+ *
+ * @retval >0 n bytes were sent (always `len`; datagrams are not split).
+ * @retval -1 Socket is non-blocking and didn't send any data.
+ */
+ssize_t inet_dgram::sndto_segmented(const void* buf, size_t len,
+                                    size_t segment_size, const string& dsthost,
+                                    const string& dstport, int sndto_flags) {
+    struct sockaddr_storage dst;
+    socklen_t dstlen = sizeof(dst);
+    int ret;
+
+    if (-1 == sfd)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "inet_dgram::sndto_segmented() - Socket already closed!", false);
+
+    if (0 != (ret = resolve_peer(sfd, dsthost.c_str(), dstport.c_str(), &dst,
+                                 &dstlen)))
+        throw socket_exception(
+            __FILE__, __LINE__,
+            string("inet_dgram::sndto_segmented() - Could not resolve "
+                   "destination: ") +
+                (ret == -1 ? strerror(errno) : gai_strerror(ret)),
+            false);
+
+    return send_segmented(buf, len, segment_size, (struct sockaddr*)&dst,
+                          dstlen, sndto_flags);
+}
+
+/**
+ * @brief Like `sndto_segmented()`, but for connected sockets
+ * (`inet_dgram_client`).
+ */
+ssize_t inet_dgram::snd_segmented(const void* buf, size_t len,
+                                  size_t segment_size, int snd_flags) {
+    if (-1 == sfd)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "inet_dgram::snd_segmented() - Socket already closed!", false);
+
+    return send_segmented(buf, len, segment_size, NULL, 0, snd_flags);
+}
+
+ssize_t inet_dgram::send_segmented(const void* buf, size_t len,
+                                   size_t segment_size,
+                                   const struct sockaddr* dst,
+                                   socklen_t dstlen, int flags) {
+    if (buf == NULL || len == 0 || segment_size == 0)
+        throw socket_exception(__FILE__, __LINE__,
+                               "inet_dgram::send_segmented() - Buffer, length "
+                               "or segment size is null!",
+                               false);
+
+    // UDP_SEGMENT takes a 16-bit size.
+    if (segment_size > UINT16_MAX)
+        throw socket_exception(__FILE__, __LINE__,
+                               "inet_dgram::send_segmented() - Segment size "
+                               "is too large!",
+                               false);
+
+#if LIBSOCKET_LINUX
+    union {
+        char buf[CMSG_SPACE(sizeof(uint16_t))];
+        struct cmsghdr align;
+    } control;
+    struct msghdr msg;
+    struct iovec iov;
+    ssize_t bytes;
+
+    memset(&msg, 0, sizeof(msg));
+    memset(&control, 0, sizeof(control));
+
+    iov.iov_base = const_cast<void*>(buf);
+    iov.iov_len = len;
+
+    msg.msg_name = const_cast<struct sockaddr*>(dst);
+    msg.msg_namelen = dstlen;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+
+    // A single datagram needs no segmentation (and the kernel refuses
+    // UDP_SEGMENT for it if it exceeds the MTU).
+    if (len > segment_size) {
+        uint16_t gso_size = segment_size;
+        struct cmsghdr* cm;
+
+        msg.msg_control = control.buf;
+        msg.msg_controllen = sizeof(control.buf);
+
+        cm = CMSG_FIRSTHDR(&msg);
+        cm->cmsg_level = SOL_UDP;
+        cm->cmsg_type = UDP_SEGMENT;
+        cm->cmsg_len = CMSG_LEN(sizeof(gso_size));
+        memcpy(CMSG_DATA(cm), &gso_size, sizeof(gso_size));
+    }
+
+    if (-1 == (bytes = sendmsg(sfd, &msg, flags))) {
+        if (is_nonblocking && errno == EWOULDBLOCK)
+            return -1;
+        else
+            throw socket_exception(
+                __FILE__, __LINE__,
+                "inet_dgram::send_segmented() - Error at sendmsg");
+    }
+
+    return bytes;
+#else
+    (void)dst;
+    (void)dstlen;
+    (void)flags;
+    errno = ENOSYS;
+    throw socket_exception(
+        __FILE__, __LINE__,
+        "inet_dgram::send_segmented() - Not supported on this platform");
+#endif
+}
+
+/**
+ * @brief Enable or disable coalescing of received datagrams (UDP GRO). Linux
+ * only.
+ *
+ * With GRO, the kernel may hand several consecutive datagrams from the same
+ * sender with the same size to a single `rcvfrom_coalesced()`/
+ * `rcv_coalesced()` call. Use those (and not `rcvfrom()`) on sockets with GRO
+ * enabled, or the datagram boundaries are lost.
+ */
+void inet_dgram::set_gro(bool enable) {
+#if LIBSOCKET_LINUX
+    int val = enable ? 1 : 0;
+
+    if (0 > setsockopt(sfd, SOL_UDP, UDP_GRO, &val, sizeof(val)))
+        throw socket_exception(__FILE__, __LINE__,
+                               "inet_dgram::set_gro() - Could not set UDP_GRO!");
+#else
+    (void)enable;
+    errno = ENOSYS;
+    throw socket_exception(
+        __FILE__, __LINE__,
+        "inet_dgram::set_gro() - Not supported on this platform");
+#endif
+}
+
+/**
+ * @brief Receive one datagram or several coalesced ones (see `set_gro()`).
+ *
+ * The received buffer consists of datagrams of `*segment_size` bytes each,
+ * except for the last one, which may be shorter.
+ *
+ * @param buf Target memory; should be 64 KiB large to hold the largest
+ * coalesced buffer. Otherwise, the rest is truncated.
+ * @param len The size of the target memory
+ * @param segment_size Set to the size of the coalesced datagrams, or to the
+ * return value if a single datagram was received.
+ * @param srchost String to place the remote host's name to
+ * @param srcport Like `srchost` but for the remote port
+ * @param rcvfrom_flags Flags for `recvmsg(2)`
+ * @param numeric If remote host and port should be saved numerically
+ *
+ * @retval >0 n bytes of data were read into `buf`.
+ * @retval -1 Socket is non-blocking and returned without any data.
+ */
+ssize_t inet_dgram::rcvfrom_coalesced(void* buf, size_t len,
+                                      size_t* segment_size, string& srchost,
+                                      string& srcport, int rcvfrom_flags,
+                                      bool numeric) {
+    struct sockaddr_storage src;
+    socklen_t srclen = sizeof(src);
+    ssize_t bytes;
+
+    if (-1 == sfd)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "inet_dgram::rcvfrom_coalesced() - Socket is closed!", false);
+    if (segment_size == NULL)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "inet_dgram::rcvfrom_coalesced() - Segment size is null!", false);
+
+    bytes = recv_message(buf, len, &src, &srclen, rcvfrom_flags, segment_size,
+                         NULL);
+
+    if (bytes < 0) return bytes;
+
+    peer_name(&src, srclen, srchost, srcport, numeric);
+
+    return bytes;
+}
+
+/**
+ * @brief Like `rcvfrom_coalesced()`, but without returning the sender's
+ * address (e.g. for connected sockets).
+ */
+ssize_t inet_dgram::rcv_coalesced(void* buf, size_t len, size_t* segment_size,
+                                  int rcv_flags) {
+    if (-1 == sfd)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "inet_dgram::rcv_coalesced() - Socket is closed!", false);
+    if (segment_size == NULL)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "inet_dgram::rcv_coalesced() - Segment size is null!", false);
+
+    return recv_message(buf, len, NULL, NULL, rcv_flags, segment_size, NULL);
+}
+
+/*
+ * recvmsg() for the special receive functions. `src`, `segment_size` and
+ * `stamp` may be NULL if the caller is not interested in them.
+ */
+ssize_t inet_dgram::recv_message(void* buf, size_t len,
+                                 struct sockaddr_storage* src,
+                                 socklen_t* srclen, int flags,
+                                 size_t* segment_size, struct timespec* stamp) {
+    if (buf == NULL || len == 0)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "inet_dgram::recv_message() - Buffer or length is null!", false);
+
+    union {
+        char buf[CMSG_SPACE(sizeof(int)) +
+                 CMSG_SPACE(3 * sizeof(struct timespec))];
+        struct cmsghdr align;
+    } control;
+    struct msghdr msg;
+    struct iovec iov;
+    ssize_t bytes;
+
+    memset(&msg, 0, sizeof(msg));
+
+    iov.iov_base = buf;
+    iov.iov_len = len;
+
+    msg.msg_name = src;
+    msg.msg_namelen = srclen ? *srclen : 0;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    if (-1 == (bytes = recvmsg(sfd, &msg, flags))) {
+        if (is_nonblocking && errno == EWOULDBLOCK)
+            return -1;
+        else
+            throw socket_exception(
+                __FILE__, __LINE__,
+                "inet_dgram::recv_message() - Error at recvmsg");
+    }
+
+    if (srclen) *srclen = msg.msg_namelen;
+
+    if (stamp && !receive_timestamp(&msg, stamp))
+        stamp->tv_sec = stamp->tv_nsec = 0;
+
+    if (segment_size) {
+        *segment_size = bytes;
+
+#if LIBSOCKET_LINUX
+        for (struct cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != NULL;
+             cm = CMSG_NXTHDR(&msg, cm)) {
+            if (cm->cmsg_level == SOL_UDP && cm->cmsg_type == UDP_GRO) {
+                int gso_size;
+
+                memcpy(&gso_size, CMSG_DATA(cm), sizeof(gso_size));
+                *segment_size = gso_size;
+            }
+        }
+#endif
+    }
+
+    return bytes;
+}
+
+/**
+ * @brief Receive up to `batch.capacity()` datagrams with one system call
+ * (`recvmmsg(2)`). Linux only.
+ *
+ * Blocks (on blocking sockets) until at least one datagram is available and
+ * then returns all datagrams that are queued, up to the capacity of `batch`.
+ *
+ * @param batch Receives the datagrams and their senders; see `dgram_batch`.
+ * @param flags Flags for `recvmmsg(2)`; `MSG_WAITFORONE` is always added.
+ *
+ * @retval >0 n datagrams were received; `batch.size()` is n.
+ * @retval -1 Socket is non-blocking and there was no datagram.
+ */
+int inet_dgram::rcvmmsg(dgram_batch& batch, int flags) {
+    if (-1 == sfd)
+        throw socket_exception(__FILE__, __LINE__,
+                               "inet_dgram::rcvmmsg() - Socket is closed!",
+                               false);
+
+#if LIBSOCKET_LINUX
+    int n;
+
+    batch.prepare_receive();
+
+    if (-1 == (n = recvmmsg(sfd, batch.headers(), batch.capacity(),
+                            flags | MSG_WAITFORONE, NULL))) {
+        if (is_nonblocking && errno == EWOULDBLOCK)
+            return -1;
+        else
+            throw socket_exception(
+                __FILE__, __LINE__,
+                "inet_dgram::rcvmmsg() - Error at recvmmsg");
+    }
+
+    batch.finish_receive(n);
+
+    return n;
+#else
+    (void)batch;
+    (void)flags;
+    errno = ENOSYS;
+    throw socket_exception(
+        __FILE__, __LINE__,
+        "inet_dgram::rcvmmsg() - Not supported on this platform");
+#endif
+}
+
+/**
+ * @brief Send the first `batch.size()` datagrams of `batch` with one system
+ * call (`sendmmsg(2)`). Linux only.
+ *
+ * Each datagram goes to the address set with `dgram_batch::set_address()`; a
+ * received batch can be sent back to its senders unchanged.
+ *
+ * @param batch The datagrams.
+ * @param flags Flags for `sendmmsg(2)`.
+ *
+ * @retval >0 The first n datagrams were sent; if n is less than `batch.size()`,
+ * the others were not.
+ * @retval -1 Socket is non-blocking and no datagram was sent.
+ */
+int inet_dgram::sndmmsg(dgram_batch& batch, int flags) {
+    if (-1 == sfd)
+        throw socket_exception(__FILE__, __LINE__,
+                               "inet_dgram::sndmmsg() - Socket is closed!",
+                               false);
+
+#if LIBSOCKET_LINUX
+    int n;
+
+    if (batch.size() == 0) return 0;
+
+    batch.prepare_send(true);
+
+    if (-1 == (n = sendmmsg(sfd, batch.headers(), batch.size(), flags))) {
+        if (is_nonblocking && errno == EWOULDBLOCK)
+            return -1;
+        else
+            throw socket_exception(
+                __FILE__, __LINE__,
+                "inet_dgram::sndmmsg() - Error at sendmmsg");
+    }
+
+    return n;
+#else
+    (void)batch;
+    (void)flags;
+    errno = ENOSYS;
+    throw socket_exception(
+        __FILE__, __LINE__,
+        "inet_dgram::sndmmsg() - Not supported on this platform");
+#endif
+}
+
+#if LIBSOCKET_HAVE_STRING_VIEW
+/**
+ * @brief Send data to a host
+ *
+ * Like `sndto(const void*, size_t, const char*, const char*, int)`; `dsthost`
+ * and `dstport` need not be null-terminated. Names shorter than 256 bytes are
+ * terminated on the stack.
+ */
+ssize_t inet_dgram::sndto(const void* buf, size_t len,
+                          std::string_view dsthost, std::string_view dstport,
+                          int sndto_flags) {
+    return sndto(buf, len, c_string<>(dsthost).c_str(),
+                 c_string<NI_MAXSERV>(dstport).c_str(), sndto_flags);
+}
+
+/**
+ * @brief Send data to a host
+ *
+ * `buf` may be any contiguous container of bytes (see `byte_span`).
+ */
+ssize_t inet_dgram::sndto(byte_span buf, std::string_view dsthost,
+                          std::string_view dstport, int sndto_flags) {
+    return sndto(buf.data(), buf.size(), dsthost, dstport, sndto_flags);
+}
+
+/**
+ * @brief Send data to a host, without throwing
+ *
+ * See above.
+ */
+ssize_t inet_dgram::sndto(const void* buf, size_t len,
+                          std::string_view dsthost, std::string_view dstport,
+                          std::error_code& ec, int sndto_flags) {
+    return sndto(buf, len, c_string<>(dsthost).c_str(),
+                 c_string<NI_MAXSERV>(dstport).c_str(), ec, sndto_flags);
+}
+#endif
+
+/**
+ * @brief Receive a datagram into a buffer from a `buffer_pool`
+ *
+ * Like `rcvfrom(void*, size_t, string&, string&, int, bool)`; sets the size of
+ * `buf` to the number of bytes received. Longer datagrams are truncated to
+ * `buf.capacity()`. Nothing is allocated on the heap except for the address
+ * strings, if they are too short.
+ */
+ssize_t inet_dgram::rcvfrom(pooled_buffer& buf, string& srchost,
+                            string& srcport, int rcvfrom_flags, bool numeric) {
+    char host[NI_MAXHOST];
+    char port[NI_MAXSERV];
+
+    ssize_t bytes = rcvfrom(buf.data(), buf.capacity(), host, sizeof(host),
+                            port, sizeof(port), rcvfrom_flags, numeric);
+
+    buf.resize(bytes > 0 ? bytes : 0);
+
+    if (bytes >= 0) {
+        srchost.assign(host);
+        srcport.assign(port);
+    }
+
+    return bytes;
+}
 }  // namespace libsocket
@@ -0,0 +1,383 @@
+#include <errno.h>
+#include <net/if.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <string>
+
+/*
+   The committers of the libsocket project, all rights reserved
+   (c) 2012, dermesser <lbo@spheniscida.de>
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS” AND ANY
+   EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+   DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+/**
+ * @file inetmulticast.cpp
+ * @brief UDP socket joining many multicast groups.
+ *
+ * 	inet_multicast binds to the wildcard address and joins groups
+ * 	using the protocol-independent MCAST_* socket options (RFC 3678),
+ * 	so the same code works for IPv4 and IPv6 and for any-source and
+ * 	source-specific membership.
+ *
+ * @addtogroup libsocketplusplus
+ * @{
+ */
+
+#include <exception.hpp>
+#include <inetmulticast.hpp>
+
+namespace libsocket {
+using std::string;
+
+static OptionalDgram multicast_options(int flags) {
+    OptionalDgram options;
+
+    options.flags = flags;
+    options.sockOptFlags.push_back(SO_REUSEADDR);
+
+    return options;
+}
+
+/**
+ * @brief Create a socket and bind it to the wildcard address.
+ *
+ * No group is joined yet; call `join()` or `join_source()`.
+ *
+ * @param port Port the groups' datagrams are sent to.
+ * @param proto_osi3 `LIBSOCKET_IPv4` or `LIBSOCKET_IPv6`
+ * @param flags Flags for `socket(2)`, e.g. `SOCK_NONBLOCK`.
+ */
+inet_multicast::inet_multicast(const string& port, int proto_osi3, int flags)
+    : inet_dgram_server(proto_osi3 == LIBSOCKET_IPv6 ? "::" : "0.0.0.0", port,
+                        proto_osi3, multicast_options(flags)) {
+    struct sockaddr_storage local;
+    socklen_t len = sizeof(local);
+
+    if (0 > getsockname(sfd, reinterpret_cast<struct sockaddr*>(&local), &len))
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "inet_multicast::inet_multicast() - Could not get local address!");
+
+    family = local.ss_family;
+
+    // Older kernels do not know IPV6_MULTICAST_ALL; such sockets simply
+    // receive all groups, as before.
+    try {
+        set_multicast_all(false);
+    } catch (const socket_exception& exc) {
+        if (exc.err != ENOPROTOOPT) throw;
+    }
+}
+
+/**
+ * @brief Join a multicast group (any-source membership).
+ *
+ * Joining a group again is a no-op.
+ *
+ * @param group Group address, e.g. "239.1.2.3" or "ff15::1".
+ * @param interface Name of the interface to receive on (e.g. "eth0"); empty
+ * for the kernel's choice.
+ */
+void inet_multicast::join(const string& group, const string& interface) {
+    membership m;
+
+    memset(&m, 0, sizeof(m));
+    resolve(group, &m.group);
+    m.interface = interface_index(interface);
+
+    if (find(m) != members.end()) return;
+
+    change(m, MCAST_JOIN_GROUP, "join");
+    members.push_back(m);
+}
+
+/**
+ * @brief Leave a group joined with `join()`.
+ */
+void inet_multicast::leave(const string& group, const string& interface) {
+    membership m;
+
+    memset(&m, 0, sizeof(m));
+    resolve(group, &m.group);
+    m.interface = interface_index(interface);
+
+    std::vector<membership>::iterator it = find(m);
+
+    if (it == members.end())
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "inet_multicast::leave() - Not a member of this group!", false);
+
+    change(m, MCAST_LEAVE_GROUP, "leave");
+    members.erase(it);
+}
+
+/**
+ * @brief Join a multicast group, receiving only datagrams from `source`
+ * (source-specific multicast).
+ *
+ * May be called several times with different sources for the same group.
+ * A group can not be joined with `join()` and `join_source()` at the same
+ * time.
+ *
+ * @param group Group address, e.g. "232.1.2.3".
+ * @param source Address of the sender.
+ * @param interface Name of the interface to receive on; empty for the
+ * kernel's choice.
+ */
+void inet_multicast::join_source(const string& group, const string& source,
+                                 const string& interface) {
+    membership m;
+
+    memset(&m, 0, sizeof(m));
+    resolve(group, &m.group);
+    resolve(source, &m.source);
+    m.interface = interface_index(interface);
+
+    if (find(m) != members.end()) return;
+
+    change(m, MCAST_JOIN_SOURCE_GROUP, "join_source");
+    members.push_back(m);
+}
+
+/**
+ * @brief Stop receiving datagrams from `source` sent to `group`.
+ */
+void inet_multicast::leave_source(const string& group, const string& source,
+                                  const string& interface) {
+    membership m;
+
+    memset(&m, 0, sizeof(m));
+    resolve(group, &m.group);
+    resolve(source, &m.source);
+    m.interface = interface_index(interface);
+
+    std::vector<membership>::iterator it = find(m);
+
+    if (it == members.end())
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "inet_multicast::leave_source() - Not a member of this group!",
+            false);
+
+    change(m, MCAST_LEAVE_SOURCE_GROUP, "leave_source");
+    members.erase(it);
+}
+
+/**
+ * @brief Whether to receive datagrams of groups joined by other sockets on the
+ * host (`IP_MULTICAST_ALL`/`IPV6_MULTICAST_ALL`).
+ *
+ * Off after construction.
+ */
+void inet_multicast::set_multicast_all(bool enable) {
+    int val = enable ? 1 : 0;
+    int ret;
+
+    if (family == AF_INET)
+        ret = setsockopt(sfd, IPPROTO_IP, IP_MULTICAST_ALL, &val, sizeof(val));
+    else {
+#ifdef IPV6_MULTICAST_ALL
+        ret = setsockopt(sfd, IPPROTO_IPV6, IPV6_MULTICAST_ALL, &val,
+                         sizeof(val));
+#else
+        errno = ENOPROTOOPT;
+        ret = -1;
+#endif
+    }
+
+    if (ret < 0)
+        throw socket_exception(__FILE__, __LINE__,
+                               "inet_multicast::set_multicast_all() - Could "
+                               "not set socket option!");
+}
+
+/**
+ * @brief Enable `IP_PKTINFO` (`IPV6_RECVPKTINFO`), so the group each datagram
+ * was sent to can be obtained with `dgram_batch::destination()`.
+ */
+void inet_multicast::set_destination_info(bool enable) {
+    int val = enable ? 1 : 0;
+    int ret;
+
+    if (family == AF_INET)
+        ret = setsockopt(sfd, IPPROTO_IP, IP_PKTINFO, &val, sizeof(val));
+    else
+        ret = setsockopt(sfd, IPPROTO_IPV6, IPV6_RECVPKTINFO, &val,
+                         sizeof(val));
+
+    if (ret < 0)
+        throw socket_exception(__FILE__, __LINE__,
+                               "inet_multicast::set_destination_info() - "
+                               "Could not set socket option!");
+}
+
+/**
+ * @brief Send multicast datagrams through this interface.
+ *
+ * @param interface Interface name; empty for the kernel's choice.
+ */
+void inet_multicast::set_interface(const string& interface) {
+    int index = interface_index(interface);
+    int ret;
+
+    if (family == AF_INET) {
+        struct ip_mreqn req;
+
+        memset(&req, 0, sizeof(req));
+        req.imr_ifindex = index;
+
+        ret = setsockopt(sfd, IPPROTO_IP, IP_MULTICAST_IF, &req, sizeof(req));
+    } else
+        ret = setsockopt(sfd, IPPROTO_IPV6, IPV6_MULTICAST_IF, &index,
+                         sizeof(index));
+
+    if (ret < 0)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "inet_multicast::set_interface() - Could not set socket option!");
+}
+
+/**
+ * @brief Set the TTL (hop limit) of sent multicast datagrams. The default is
+ * 1, i.e. they do not leave the local network.
+ */
+void inet_multicast::set_hops(int hops) {
+    int ret;
+
+    if (family == AF_INET)
+        ret =
+            setsockopt(sfd, IPPROTO_IP, IP_MULTICAST_TTL, &hops, sizeof(hops));
+    else
+        ret = setsockopt(sfd, IPPROTO_IPV6, IPV6_MULTICAST_HOPS, &hops,
+                         sizeof(hops));
+
+    if (ret < 0)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "inet_multicast::set_hops() - Could not set socket option!");
+}
+
+/**
+ * @brief Whether sent multicast datagrams are also delivered to members on
+ * this host. On by default.
+ */
+void inet_multicast::set_loop(bool enable) {
+    int val = enable ? 1 : 0;
+    int ret;
+
+    if (family == AF_INET)
+        ret =
+            setsockopt(sfd, IPPROTO_IP, IP_MULTICAST_LOOP, &val, sizeof(val));
+    else
+        ret = setsockopt(sfd, IPPROTO_IPV6, IPV6_MULTICAST_LOOP, &val,
+                         sizeof(val));
+
+    if (ret < 0)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "inet_multicast::set_loop() - Could not set socket option!");
+}
+
+void inet_multicast::resolve(const string& addr,
+                             struct sockaddr_storage* ss) const {
+    struct addrinfo hints, *result;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = family;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    int ret = getaddrinfo(addr.c_str(), NULL, &hints, &result);
+
+    if (ret != 0)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            string("inet_multicast - Could not resolve ") + addr + ": " +
+                gai_strerror(ret),
+            false);
+
+    memcpy(ss, result->ai_addr, result->ai_addrlen);
+    freeaddrinfo(result);
+}
+
+unsigned int inet_multicast::interface_index(const string& interface) const {
+    if (interface.empty()) return 0;
+
+    unsigned int index = if_nametoindex(interface.c_str());
+
+    if (index == 0)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            string("inet_multicast - Unknown interface ") + interface);
+
+    return index;
+}
+
+std::vector<inet_multicast::membership>::iterator inet_multicast::find(
+    const membership& m) {
+    for (std::vector<membership>::iterator it = members.begin();
+         it != members.end(); ++it)
+        if (0 == memcmp(&*it, &m, sizeof(m))) return it;
+
+    return members.end();
+}
+
+// Join or leave a group; `m.source` decides between group_req and
+// group_source_req.
+void inet_multicast::change(const membership& m, int option,
+                            const char* function) {
+    int level = family == AF_INET ? IPPROTO_IP : IPPROTO_IPV6;
+    int ret;
+
+    if (m.source.ss_family == 0) {
+        struct group_req req;
+
+        memset(&req, 0, sizeof(req));
+        req.gr_interface = m.interface;
+        memcpy(&req.gr_group, &m.group, sizeof(m.group));
+
+        ret = setsockopt(sfd, level, option, &req, sizeof(req));
+    } else {
+        struct group_source_req req;
+
+        memset(&req, 0, sizeof(req));
+        req.gsr_interface = m.interface;
+        memcpy(&req.gsr_group, &m.group, sizeof(m.group));
+        memcpy(&req.gsr_source, &m.source, sizeof(m.source));
+
+        ret = setsockopt(sfd, level, option, &req, sizeof(req));
+    }
+
+    if (ret < 0)
+        throw socket_exception(__FILE__, __LINE__,
+                               string("inet_multicast::") + function +
+                                   "() - Could not change group membership!");
+}
+}  // namespace libsocket
+
+/**
+ * @}
+ */
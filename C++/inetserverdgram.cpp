@@ -237,4 +237,19 @@ void inet_dgram_server::setup(const string& bhost, const string& bport,
                               int proto_osi3, const OptionalDgram& anOptional) {
     setup(bhost.c_str(), bport.c_str(), proto_osi3, anOptional);
 }
+
+#if LIBSOCKET_HAVE_STRING_VIEW
+/**
+ * @brief Create a UDP socket
+ *
+ * Like the `const char*` constructor; `host` and `port` need not be
+ * null-terminated.
+ */
+inet_dgram_server::inet_dgram_server(std::string_view host,
+                                     std::string_view port, int proto_osi3,
+                                     const OptionalDgram& anOptional) {
+    setup(c_string<>(host).c_str(), c_string<NI_MAXSERV>(port).c_str(),
+          proto_osi3, anOptional);
+}
+#endif
 }  // namespace libsocket
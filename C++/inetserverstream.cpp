@@ -41,6 +41,10 @@
 
 #include <conf.h>
 
+#if LIBSOCKET_LINUX
+#include <netinet/tcp.h>
+#endif
+
 #include <libinetsocket.h>
 #include <exception.hpp>
 #include <inetclientstream.hpp>
@@ -136,16 +140,10 @@ void inet_stream_server::setup(const char* bindhost, const char* bindport,
                                "inet_stream_server::inet_stream_server() - at "
                                "least one bind argument invalid!",
                                false);
-    if (-1 == (sfd = create_inet_server_socket(
-                   bindhost, bindport, LIBSOCKET_TCP, proto_osi3, anOptional.flags)))
-        throw socket_exception(__FILE__, __LINE__,
-                               "inet_stream_server::inet_stream_server() - "
-                               "could not create server socket!");
-
-    host = string(bindhost);
-    port = string(bindport);
 
-    is_nonblocking = anOptional.flags & SOCK_NONBLOCK;
+    // The string version honours all of anOptional (sockOptFlags,
+    // fastOpenQueue), not only the flags.
+    setup(string(bindhost), string(bindport), proto_osi3, anOptional);
 }
 
 int __create_inet_server_socket__(const char *bind_addr, const char *bind_port,
@@ -226,6 +224,14 @@ debug_write(errstr);
             continue;
         }
 
+#if LIBSOCKET_LINUX && defined(TCP_FASTOPEN)
+        // Best effort, like sockOptFlags: without it, clients simply do a
+        // normal handshake.
+        if (type == LIBSOCKET_TCP && anOptional.fastOpenQueue > 0)
+            setsockopt(sfd, IPPROTO_TCP, TCP_FASTOPEN,
+                       &anOptional.fastOpenQueue, sizeof(int));
+#endif
+
         if (type == LIBSOCKET_TCP) retval = listen(sfd, LIBSOCKET_BACKLOG);
 
         if (retval == 0)  // If we came until here, there wasn't an error
@@ -355,6 +361,68 @@ unique_ptr<inet_stream> inet_stream_server::accept2(int numeric,
                                  // (http://stackoverflow.com/a/6256543)
     client->port = string(src_port.get());  //
     client->proto = proto;
+    client->is_nonblocking = accept_flags & SOCK_NONBLOCK;
+
+    return client;
+}
+
+/**
+ * @brief Accept a connection, without throwing
+ *
+ * Works like `accept()`, but reports errors in `ec` instead of throwing.
+ *
+ * @param ec Set to the error, or cleared.
+ * @param numeric Specifies if the client's parameter (IP address, port) should
+ * be delivered numerically. Looking up names may take long; servers accepting
+ * many connections should set this.
+ * @param accept_flags Flags specified in `accept(2)`
+ *
+ * @returns A pointer to a connected TCP/IP client socket object, or NULL on
+ * error (also if the socket is non-blocking and no client is waiting).
+ */
+inet_stream* inet_stream_server::accept(std::error_code& ec, int numeric,
+                                        int accept_flags) {
+    return accept2(ec, numeric, accept_flags).release();
+}
+
+/**
+ * @brief Accept a connection, without throwing
+ *
+ * Works like `accept2()`, but reports errors in `ec` instead of throwing.
+ *
+ * @returns An owned pointer to a connected TCP/IP client socket object, or
+ * `nullptr` on error.
+ */
+unique_ptr<inet_stream> inet_stream_server::accept2(std::error_code& ec,
+                                                    int numeric,
+                                                    int accept_flags) {
+    char src_host[NI_MAXHOST], src_port[NI_MAXSERV];
+    int client_sfd;
+
+    if (sfd < 0) {
+        ec.assign(EINVAL, std::system_category());
+        return nullptr;
+    }
+
+    memset(src_host, 0, sizeof(src_host));
+    memset(src_port, 0, sizeof(src_port));
+
+    if (-1 == (client_sfd = accept_inet_stream_socket(
+                   sfd, src_host, sizeof(src_host) - 1, src_port,
+                   sizeof(src_port) - 1, numeric, accept_flags))) {
+        ec.assign(errno, std::system_category());
+        return nullptr;
+    }
+
+    unique_ptr<inet_stream> client(new inet_stream);
+
+    client->sfd = client_sfd;
+    client->host = src_host;
+    client->port = src_port;
+    client->proto = proto;
+    client->is_nonblocking = accept_flags & SOCK_NONBLOCK;
+
+    ec.clear();
 
     return client;
 }
@@ -362,4 +430,31 @@ unique_ptr<inet_stream> inet_stream_server::accept2(int numeric,
 const string& inet_stream_server::getbindhost(void) { return gethost(); }
 
 const string& inet_stream_server::getbindport(void) { return getport(); }
+
+#if LIBSOCKET_HAVE_STRING_VIEW
+/**
+ * @brief Create a TCP server socket
+ *
+ * Like the `const char*` constructor; `bindhost` and `bindport` need not be
+ * null-terminated.
+ */
+inet_stream_server::inet_stream_server(std::string_view bindhost,
+                                       std::string_view bindport,
+                                       int proto_osi3,
+                                       const OptionalStream& anOptional) {
+    setup(bindhost, bindport, proto_osi3, anOptional);
+}
+
+/**
+ * @brief Set up a TCP server socket
+ *
+ * Like `setup(const char*, const char*, int, const OptionalStream&)`.
+ */
+void inet_stream_server::setup(std::string_view bindhost,
+                               std::string_view bindport, int proto_osi3,
+                               const OptionalStream& anOptional) {
+    setup(c_string<>(bindhost).c_str(), c_string<NI_MAXSERV>(bindport).c_str(),
+          proto_osi3, anOptional);
+}
+#endif
 }  // namespace libsocket
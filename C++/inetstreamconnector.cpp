@@ -0,0 +1,446 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+/*
+   The committers of the libsocket project, all rights reserved
+   (c) 2012, dermesser <lbo@spheniscida.de>
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS” AND ANY
+   EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+   DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+/**
+ * @file inetstreamconnector.cpp
+ * @brief Happy Eyeballs connection establishment.
+ *
+ * 	inet_stream_connector runs several non-blocking connect attempts
+ * 	to the addresses of one host, staggered by a fixed delay, and
+ * 	keeps the first one that succeeds.
+ *
+ * @addtogroup libsocketplusplus
+ * @{
+ */
+
+#include <exception.hpp>
+#include <inetstreamconnector.hpp>
+#include <resolver.hpp>
+
+#ifndef SOCK_NONBLOCK
+#define SOCK_NONBLOCK O_NONBLOCK
+#endif
+#ifndef SOCK_CLOEXEC
+#define SOCK_CLOEXEC 0
+#endif
+
+namespace libsocket {
+using std::string;
+
+static uint64_t monotonic_ms(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return static_cast<uint64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Resolve `host` and start connecting to its first address.
+ *
+ * The host is resolved with `resolver::lookup()`, i.e. answers are cached.
+ *
+ * @param host Remote host
+ * @param port Remote port
+ * @param proto_osi3 `LIBSOCKET_IPv4` or `LIBSOCKET_IPv6` or `LIBSOCKET_BOTH`
+ * @param flags `SOCK_NONBLOCK` and/or `SOCK_CLOEXEC`; applied to the resulting
+ * socket. The attempts themselves are always non-blocking.
+ * @param attempt_delay Milliseconds to wait for an attempt before starting the
+ * next one. RFC 8305 recommends 250.
+ */
+inet_stream_connector::inet_stream_connector(const string& host,
+                                             const string& port,
+                                             int proto_osi3, int flags,
+                                             int attempt_delay)
+    : next(0),
+      winner_watched(false),
+      succeeded(false),
+      failed(false),
+      error(0),
+      flags(flags),
+      delay(attempt_delay < 0 ? 0 : attempt_delay),
+      last_start(0),
+      start_now(false),
+      host(host),
+      port(port),
+      proto(proto_osi3) {
+    int family;
+
+    switch (proto_osi3) {
+        case LIBSOCKET_IPv4:
+            family = AF_INET;
+            break;
+        case LIBSOCKET_IPv6:
+            family = AF_INET6;
+            break;
+        case LIBSOCKET_BOTH:
+            family = AF_UNSPEC;
+            break;
+        default:
+            throw socket_exception(__FILE__, __LINE__,
+                                   "inet_stream_connector::inet_stream_"
+                                   "connector() - Unknown protocol!",
+                                   false);
+    }
+
+    std::shared_ptr<const resolved_addresses> resolved =
+        resolver::lookup(host.c_str(), port.c_str(), family, SOCK_STREAM);
+
+    if (resolved->error() != 0)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            string("inet_stream_connector::inet_stream_connector() - Could "
+                   "not resolve host: ") +
+                gai_strerror(resolved->error()),
+            false);
+
+    set_addresses(resolved->list());
+
+    start(monotonic_ms());
+}
+
+/**
+ * @brief Start connecting to the first of `addresses`.
+ *
+ * Use this if you have resolved the host yourself. The list is copied; the
+ * remote host and port of the resulting socket are taken from the addresses.
+ *
+ * @param addresses Result of `getaddrinfo(3)`; entries other than IPv4/IPv6
+ * are skipped.
+ * @param flags See above.
+ * @param attempt_delay See above.
+ */
+inet_stream_connector::inet_stream_connector(const struct addrinfo* addresses,
+                                             int flags, int attempt_delay)
+    : next(0),
+      winner_watched(false),
+      succeeded(false),
+      failed(false),
+      error(0),
+      flags(flags),
+      delay(attempt_delay < 0 ? 0 : attempt_delay),
+      last_start(0),
+      start_now(false),
+      proto(LIBSOCKET_BOTH) {
+    set_addresses(addresses);
+
+    if (this->addresses.empty())
+        throw socket_exception(__FILE__, __LINE__,
+                               "inet_stream_connector::inet_stream_connector() "
+                               "- No usable address!",
+                               false);
+
+    start(monotonic_ms());
+}
+
+/**
+ * @brief Wait up to `wait` milliseconds for an attempt to finish and start new
+ * attempts when they are due.
+ *
+ * @param wait Milliseconds; 0 only checks, -1 waits until something happens.
+ * The call returns earlier when the next attempt is due.
+ *
+ * @returns `done()`
+ */
+bool inet_stream_connector::step(int wait) {
+    if (done()) return true;
+
+    std::vector<struct pollfd> fds(running.size());
+
+    for (size_t i = 0; i < running.size(); i++) {
+        fds[i].fd = running[i].sock->sfd;
+        fds[i].events = POLLOUT;
+        fds[i].revents = 0;
+    }
+
+    int due = timeout();
+
+    if (wait < 0 || (due >= 0 && due < wait)) wait = due;
+
+    if (fds.empty() && wait < 0) wait = 0;
+
+    int ready = ::poll(fds.data(), fds.size(), wait);
+
+    if (ready < 0 && errno != EINTR)
+        throw socket_exception(__FILE__, __LINE__,
+                               "inet_stream_connector::step() - poll failed!");
+
+    // Backwards, so that fail() may remove entries.
+    for (size_t i = fds.size(); ready > 0 && i-- > 0;) {
+        if (fds[i].revents == 0) continue;
+
+        int err = 0;
+        socklen_t len = sizeof err;
+
+        if (0 > getsockopt(fds[i].fd, SOL_SOCKET, SO_ERROR, &err, &len))
+            err = errno;
+
+        if (err == 0) {
+            complete(i);
+            return true;
+        }
+
+        fail(i, err);
+    }
+
+    uint64_t now = monotonic_ms();
+
+    if (next < addresses.size() &&
+        (running.empty() || start_now || now >= last_start + delay))
+        start(now);
+    else if (running.empty() && next >= addresses.size())
+        failed = true;
+
+    return done();
+}
+
+/**
+ * @brief Milliseconds until `step()` has to be called again to start the next
+ * attempt.
+ *
+ * @returns -1 if no further attempt is pending; the connector then only waits
+ * for its sockets to become writable.
+ */
+int inet_stream_connector::timeout(void) const {
+    if (done() || next >= addresses.size()) return -1;
+    if (running.empty() || start_now) return 0;
+
+    uint64_t now = monotonic_ms();
+
+    if (now >= last_start + delay) return 0;
+
+    return static_cast<int>(last_start + delay - now);
+}
+
+/**
+ * @brief Take the connected socket.
+ *
+ * Throws if all attempts failed (with `errno` of the last one), if the
+ * connector is not done yet, or if the socket has already been taken.
+ */
+std::unique_ptr<inet_stream> inet_stream_connector::result(void) {
+    if (failed) {
+        errno = error;
+        throw socket_exception(__FILE__, __LINE__,
+                               "inet_stream_connector::result() - Could not "
+                               "connect to any address!");
+    }
+    if (!succeeded)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "inet_stream_connector::result() - Not connected yet!", false);
+    if (!winner)
+        throw socket_exception(__FILE__, __LINE__,
+                               "inet_stream_connector::result() - Socket has "
+                               "already been taken!",
+                               false);
+
+    return std::move(winner);
+}
+
+/**
+ * @brief Take the connected socket, without throwing.
+ *
+ * Like `result()`, but returns `nullptr` and sets `ec` instead of throwing:
+ * to the error of the last attempt if all failed, to `EINPROGRESS` if the
+ * connector is not done yet, and to `EINVAL` if the socket has already been
+ * taken.
+ */
+std::unique_ptr<inet_stream> inet_stream_connector::result(
+    std::error_code& ec) {
+    if (failed)
+        ec.assign(error != 0 ? error : ENETUNREACH, std::system_category());
+    else if (!succeeded)
+        ec.assign(EINPROGRESS, std::system_category());
+    else if (!winner)
+        ec.assign(EINVAL, std::system_category());
+    else
+        ec.clear();
+
+    return std::move(winner);
+}
+
+/*
+ * Copies the IPv4 and IPv6 entries of `list`, alternating between the two
+ * families and starting with the family of the first entry (RFC 8305,
+ * section 4).
+ */
+void inet_stream_connector::set_addresses(const struct addrinfo* list) {
+    std::vector<address> v4, v6;
+    int first = 0;
+
+    for (; list != NULL; list = list->ai_next) {
+        if (list->ai_family != AF_INET && list->ai_family != AF_INET6)
+            continue;
+        if (list->ai_addrlen > sizeof(struct sockaddr_storage)) continue;
+
+        address a;
+
+        memset(&a.addr, 0, sizeof a.addr);
+        memcpy(&a.addr, list->ai_addr, list->ai_addrlen);
+        a.len = list->ai_addrlen;
+
+        if (first == 0) first = list->ai_family;
+
+        (list->ai_family == AF_INET ? v4 : v6).push_back(a);
+    }
+
+    std::vector<address>& a = first == AF_INET ? v4 : v6;
+    std::vector<address>& b = first == AF_INET ? v6 : v4;
+
+    addresses.clear();
+    addresses.reserve(a.size() + b.size());
+
+    for (size_t i = 0; i < a.size() || i < b.size(); i++) {
+        if (i < a.size()) addresses.push_back(a[i]);
+        if (i < b.size()) addresses.push_back(b[i]);
+    }
+}
+
+/*
+ * Starts an attempt to the next address. Addresses that fail immediately are
+ * skipped; an immediate success completes the connector.
+ */
+void inet_stream_connector::start(uint64_t now) {
+    start_now = false;
+
+    while (next < addresses.size()) {
+        const address& a = addresses[next++];
+
+        int fd = ::socket(a.addr.ss_family,
+                          SOCK_STREAM | SOCK_NONBLOCK | (flags & SOCK_CLOEXEC),
+                          0);
+
+        if (fd < 0) {
+            error = errno;
+            continue;
+        }
+
+        attempt att;
+
+        att.sock.reset(new inet_stream);
+        att.sock->sfd = fd;
+        att.sock->proto =
+            a.addr.ss_family == AF_INET ? LIBSOCKET_IPv4 : LIBSOCKET_IPv6;
+        att.watched = false;
+
+        int ret =
+            ::connect(fd, reinterpret_cast<const struct sockaddr*>(&a.addr),
+                      a.len);
+
+        if (ret < 0 && errno != EINPROGRESS) {
+            error = errno;
+            continue;  // att closes the socket
+        }
+
+        running.push_back(std::move(att));
+        last_start = now;
+
+        if (ret == 0) complete(running.size() - 1);
+
+        return;
+    }
+
+    if (running.empty() && !succeeded) failed = true;
+}
+
+/*
+ * Makes running[i] the winner and closes all other attempts.
+ */
+void inet_stream_connector::complete(size_t i) {
+    winner = std::move(running[i].sock);
+    winner_watched = running[i].watched;
+    succeeded = true;
+
+    for (size_t j = 0; j < running.size(); j++)
+        if (running[j].sock && running[j].watched)
+            finished.push_back(std::move(running[j].sock));
+
+    running.clear();
+
+    if (!(flags & SOCK_NONBLOCK)) {
+        int fl = fcntl(winner->sfd, F_GETFL);
+
+        if (fl < 0 || 0 > fcntl(winner->sfd, F_SETFL, fl & ~O_NONBLOCK))
+            throw socket_exception(__FILE__, __LINE__,
+                                   "inet_stream_connector::complete() - Could "
+                                   "not clear O_NONBLOCK!");
+    }
+
+    winner->is_nonblocking = flags & SOCK_NONBLOCK;
+    winner->shut_rd = false;
+    winner->shut_wr = false;
+
+    char hostbuf[NI_MAXHOST], portbuf[NI_MAXSERV];
+    struct sockaddr_storage addr;
+    socklen_t len = sizeof addr;
+
+    if (0 == getpeername(winner->sfd, reinterpret_cast<struct sockaddr*>(&addr),
+                         &len) &&
+        0 == getnameinfo(reinterpret_cast<struct sockaddr*>(&addr), len,
+                         hostbuf, sizeof hostbuf, portbuf, sizeof portbuf,
+                         NI_NUMERICHOST | NI_NUMERICSERV)) {
+        winner->host = host.empty() ? string(hostbuf) : host;
+        winner->port = port.empty() ? string(portbuf) : port;
+    } else {
+        winner->host = host;
+        winner->port = port;
+    }
+
+    winner->forget_client();
+
+    if (proto != LIBSOCKET_BOTH) winner->proto = proto;
+}
+
+/*
+ * Closes running[i] after it failed with `err`. The next address is started
+ * by the following step() without waiting for `delay`.
+ */
+void inet_stream_connector::fail(size_t i, int err) {
+    error = err;
+    start_now = true;
+
+    if (running[i].watched) finished.push_back(std::move(running[i].sock));
+
+    running.erase(running.begin() + i);
+}
+}  // namespace libsocket
+
+/**
+ * @}
+ */
@@ -0,0 +1,108 @@
+#include <sys/mman.h>
+
+/*
+   The committers of the libsocket project, all rights reserved
+   (c) 2012, dermesser <lbo@spheniscida.de>
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS” AND ANY
+   EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+   DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+/**
+ * @file mappedspan.cpp
+ * @brief Ownership of data received by `stream_client_socket::rcv_mapped()`.
+ *
+ * @addtogroup libsocketplusplus
+ * @{
+ */
+
+#include <mappedspan.hpp>
+
+namespace libsocket {
+
+/**
+ * @brief Constructs an empty span.
+ */
+mapped_span::mapped_span(void)
+    : begin(NULL), length(0), map_address(NULL), map_length(0) {}
+
+/**
+ * @brief Move constructor. `other` is empty afterwards.
+ */
+mapped_span::mapped_span(mapped_span&& other)
+    : begin(other.begin),
+      length(other.length),
+      map_address(other.map_address),
+      map_length(other.map_length),
+      copy(std::move(other.copy)) {
+    other.begin = NULL;
+    other.length = 0;
+    other.map_address = NULL;
+    other.map_length = 0;
+}
+
+/**
+ * @brief Destructor. Unmaps the data if it was mapped.
+ */
+mapped_span::~mapped_span(void) { release(); }
+
+/**
+ * @brief Move assignment. Releases the data held before; `other` is empty
+ * afterwards.
+ */
+mapped_span& mapped_span::operator=(mapped_span&& other) {
+    if (this == &other) return *this;
+
+    release();
+
+    begin = other.begin;
+    length = other.length;
+    map_address = other.map_address;
+    map_length = other.map_length;
+    copy = std::move(other.copy);
+
+    other.begin = NULL;
+    other.length = 0;
+    other.map_address = NULL;
+    other.map_length = 0;
+
+    return *this;
+}
+
+/**
+ * @brief Give the data back to the kernel (or free the copy) and make the span
+ * empty.
+ */
+void mapped_span::release(void) {
+    if (map_address != NULL) munmap(map_address, map_length);
+
+    copy.reset();
+
+    begin = NULL;
+    length = 0;
+    map_address = NULL;
+    map_length = 0;
+}
+}  // namespace libsocket
+
+/**
+ * @}
+ */
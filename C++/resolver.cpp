@@ -0,0 +1,511 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <conf.h>
+
+#if LIBSOCKET_LINUX
+#include <sys/eventfd.h>
+#endif
+
+/*
+   The committers of the libsocket project, all rights reserved
+   (c) 2012, dermesser <lbo@spheniscida.de>
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS” AND ANY
+   EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+   DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+/**
+ * @file resolver.cpp
+ * @brief Cached and asynchronous name resolution.
+ *
+ * 	All lookups of the C++ library go through resolver::lookup(),
+ * 	which keeps recent answers in a process-wide cache once
+ * 	set_cache_ttl() enabled it. resolver objects run lookups on
+ * 	worker threads and signal finished ones through a file
+ * 	descriptor.
+ *
+ * @addtogroup libsocketplusplus
+ * @{
+ */
+
+#include <exception.hpp>
+#include <resolver.hpp>
+#include <timerwheel.hpp>
+
+namespace libsocket {
+using std::string;
+
+struct dns_cache_key {
+    string host;
+    string port;
+    int family;
+    int socktype;
+
+    bool operator==(const dns_cache_key& other) const {
+        return family == other.family && socktype == other.socktype &&
+               host == other.host && port == other.port;
+    }
+};
+
+struct dns_cache_key_hash {
+    size_t operator()(const dns_cache_key& key) const {
+        std::hash<string> h;
+
+        return h(key.host) ^ (h(key.port) * 31) ^
+               (static_cast<size_t>(key.family) << 8) ^ key.socktype;
+    }
+};
+
+struct dns_cache_entry {
+    std::shared_ptr<const resolved_addresses> addresses;
+    uint64_t expires;  ///< Milliseconds, CLOCK_MONOTONIC
+};
+
+/*
+ * Shared by all lookups in the process; off until set_cache_ttl() gives it a
+ * TTL. Expired entries are only removed when the cache is full; if that does
+ * not free anything, it is cleared.
+ */
+struct dns_cache {
+    std::mutex lock;
+    std::unordered_map<dns_cache_key, dns_cache_entry, dns_cache_key_hash>
+        entries;
+    unsigned int positive_ttl = 0;
+    unsigned int negative_ttl = 0;
+
+    static const size_t limit = 4096;
+};
+
+// A function-local static, so the cache can be used during static
+// initialization, too.
+static dns_cache& cache(void) {
+    static dns_cache instance;
+
+    return instance;
+}
+
+static uint64_t monotonic_ms(void) { return timer_wheel::now() / 1000; }
+
+// Errors that say something about the name, not about this process.
+// EAI_AGAIN is a temporary failure (e.g. the DNS server timed out) and must
+// not hide the name once the server answers again.
+static bool cacheable_error(int error) {
+    switch (error) {
+        case EAI_NONAME:
+        case EAI_FAIL:
+        case EAI_SERVICE:
+#ifdef EAI_NODATA
+        case EAI_NODATA:
+#endif
+#ifdef EAI_ADDRFAMILY
+        case EAI_ADDRFAMILY:
+#endif
+            return true;
+        default:
+            return false;
+    }
+}
+
+static std::shared_ptr<const resolved_addresses> cached(
+    const dns_cache_key& key) {
+    dns_cache& c = cache();
+    std::lock_guard<std::mutex> guard(c.lock);
+
+    auto it = c.entries.find(key);
+
+    if (it == c.entries.end()) return nullptr;
+
+    if (it->second.expires <= monotonic_ms()) {
+        c.entries.erase(it);
+        return nullptr;
+    }
+
+    return it->second.addresses;
+}
+
+static void store(const dns_cache_key& key,
+           const std::shared_ptr<const resolved_addresses>& addresses) {
+    dns_cache& c = cache();
+    std::lock_guard<std::mutex> guard(c.lock);
+
+    unsigned int ttl =
+        addresses->error() == 0 ? c.positive_ttl : c.negative_ttl;
+
+    if (ttl == 0 || (addresses->error() != 0 &&
+                     !cacheable_error(addresses->error())))
+        return;
+
+    uint64_t now = monotonic_ms();
+
+    if (c.entries.size() >= dns_cache::limit) {
+        for (auto it = c.entries.begin(); it != c.entries.end();) {
+            if (it->second.expires <= now)
+                it = c.entries.erase(it);
+            else
+                ++it;
+        }
+
+        if (c.entries.size() >= dns_cache::limit) c.entries.clear();
+    }
+
+    dns_cache_entry& entry = c.entries[key];
+
+    entry.addresses = addresses;
+    entry.expires = now + ttl;
+}
+
+static int family_of(int proto_osi3) {
+    switch (proto_osi3) {
+        case LIBSOCKET_IPv4:
+            return AF_INET;
+        case LIBSOCKET_IPv6:
+            return AF_INET6;
+        case LIBSOCKET_BOTH:
+            return AF_UNSPEC;
+        default:
+            throw socket_exception(__FILE__, __LINE__,
+                                   "resolver::resolve() - Unknown protocol!",
+                                   false);
+    }
+}
+/**
+ * @brief Copies `list` (which may be NULL).
+ *
+ * @param error 0 or an `EAI_*` code.
+ * @param list Result of `getaddrinfo(3)`; canonical names are not copied.
+ */
+resolved_addresses::resolved_addresses(int error, const struct addrinfo* list)
+    : err(error) {
+    size_t n = 0;
+
+    for (const struct addrinfo* ai = list; ai != NULL; ai = ai->ai_next)
+        if (ai->ai_addrlen <= sizeof(struct sockaddr_storage)) n++;
+
+    // Reserve first: the entries point into `addrs` and to each other.
+    entries.reserve(n);
+    addrs.reserve(n);
+
+    for (const struct addrinfo* ai = list; ai != NULL; ai = ai->ai_next) {
+        if (ai->ai_addrlen > sizeof(struct sockaddr_storage)) continue;
+
+        addrs.push_back(sockaddr_storage());
+        memset(&addrs.back(), 0, sizeof(addrs.back()));
+        memcpy(&addrs.back(), ai->ai_addr, ai->ai_addrlen);
+
+        entries.push_back(*ai);
+        entries.back().ai_addr =
+            reinterpret_cast<struct sockaddr*>(&addrs.back());
+        entries.back().ai_canonname = NULL;
+        entries.back().ai_next = NULL;
+
+        if (entries.size() > 1)
+            entries[entries.size() - 2].ai_next = &entries.back();
+    }
+}
+
+/**
+ * @brief Resolve `host` and `port` like `getaddrinfo(3)`, using the cache.
+ *
+ * @param host Host name or address; NULL for the wildcard address (such
+ * lookups are not cached).
+ * @param port Service name or port number
+ * @param family `AF_INET`, `AF_INET6` or `AF_UNSPEC`
+ * @param socktype `SOCK_STREAM`, `SOCK_DGRAM` or 0
+ *
+ * @returns The addresses, or the error. Never NULL.
+ */
+std::shared_ptr<const resolved_addresses> resolver::lookup(const char* host,
+                                                           const char* port,
+                                                           int family,
+                                                           int socktype) {
+    bool use_cache = host != NULL && port != NULL;
+    dns_cache_key key;
+
+    if (use_cache) {
+        key.host = host;
+        key.port = port;
+        key.family = family;
+        key.socktype = socktype;
+
+        std::shared_ptr<const resolved_addresses> hit = cached(key);
+
+        if (hit) return hit;
+    }
+
+    struct addrinfo hint, *list = NULL;
+
+    memset(&hint, 0, sizeof(hint));
+    hint.ai_family = family;
+    hint.ai_socktype = socktype;
+
+    int ret = getaddrinfo(host, port, &hint, &list);
+
+    std::shared_ptr<const resolved_addresses> result =
+        std::make_shared<resolved_addresses>(ret, ret == 0 ? list : NULL);
+
+    if (ret == 0) freeaddrinfo(list);
+
+    if (use_cache) store(key, result);
+
+    return result;
+}
+
+/**
+ * @brief Set how long answers are cached.
+ *
+ * The cache is disabled until this is called with a nonzero TTL. Entries
+ * already in the cache keep their expiry time.
+ *
+ * @param positive_ms For successful lookups, e.g. 30000. Default: 0.
+ * @param negative_ms For names that could not be resolved, e.g. 5000.
+ * Default: 0.
+ */
+void resolver::set_cache_ttl(unsigned int positive_ms,
+                             unsigned int negative_ms) {
+    dns_cache& c = cache();
+    std::lock_guard<std::mutex> guard(c.lock);
+
+    c.positive_ttl = positive_ms;
+    c.negative_ttl = negative_ms;
+}
+
+/**
+ * @brief Forget all cached answers.
+ */
+void resolver::flush_cache(void) {
+    dns_cache& c = cache();
+    std::lock_guard<std::mutex> guard(c.lock);
+
+    c.entries.clear();
+}
+
+/**
+ * @brief Start the worker threads.
+ *
+ * @param threads Number of lookups that may run at the same time.
+ */
+resolver::resolver(size_t nthreads)
+    : stopping(false), next_id(1), outstanding(0), notify_fd(-1) {
+#if LIBSOCKET_LINUX
+    sfd = notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if (sfd < 0)
+        throw socket_exception(__FILE__, __LINE__,
+                               "resolver::resolver() - Could not create "
+                               "eventfd!");
+#else
+    int fds[2];
+
+    if (0 > pipe(fds))
+        throw socket_exception(__FILE__, __LINE__,
+                               "resolver::resolver() - Could not create pipe!");
+
+    for (int i = 0; i < 2; i++) {
+        fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+        fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+    }
+
+    sfd = fds[0];
+    notify_fd = fds[1];
+#endif
+    is_nonblocking = true;
+
+    if (nthreads == 0) nthreads = 1;
+
+    try {
+        for (size_t i = 0; i < nthreads; i++)
+            threads.emplace_back(&resolver::run, this);
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        wakeup.notify_all();
+
+        for (std::thread& t : threads) t.join();
+
+        if (notify_fd != sfd) close(notify_fd);
+        throw;
+    }
+}
+
+/**
+ * @brief Stop the worker threads.
+ *
+ * Waits for lookups that are running; queued lookups are dropped.
+ */
+resolver::~resolver(void) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wakeup.notify_all();
+
+    for (std::thread& t : threads) t.join();
+
+    if (notify_fd != sfd) close(notify_fd);
+}
+
+/**
+ * @brief Queue a lookup.
+ *
+ * The result is delivered through `next()`; answers from the cache
+ * immediately, others once a worker thread has resolved them.
+ *
+ * @param host Host name or address
+ * @param port Service name or port number
+ * @param proto_osi3 `LIBSOCKET_IPv4` or `LIBSOCKET_IPv6` or `LIBSOCKET_BOTH`
+ * @param socktype `SOCK_STREAM` or `SOCK_DGRAM`
+ *
+ * @returns An id identifying the lookup's `completion`.
+ */
+uint64_t resolver::resolve(const string& host, const string& port,
+                           int proto_osi3, int socktype) {
+    request req;
+    uint64_t id = next_id++;
+
+    req.id = id;
+    req.host = host;
+    req.port = port;
+    req.family = family_of(proto_osi3);
+    req.socktype = socktype;
+
+    outstanding++;
+
+    dns_cache_key key;
+
+    key.host = host;
+    key.port = port;
+    key.family = req.family;
+    key.socktype = socktype;
+
+    std::shared_ptr<const resolved_addresses> hit = cached(key);
+
+    if (hit) {
+        completion c;
+
+        c.id = req.id;
+        c.host = host;
+        c.port = port;
+        c.addresses = hit;
+
+        deliver(std::move(c));
+    } else {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            requests.push_back(std::move(req));
+        }
+        wakeup.notify_one();
+    }
+
+    return id;
+}
+
+/**
+ * @brief Collect a finished lookup.
+ *
+ * Call this until it returns `false` whenever the resolver's file descriptor
+ * is readable.
+ *
+ * @returns `false` if no lookup has finished since the last call.
+ */
+bool resolver::next(completion* result) {
+    if (result == NULL)
+        throw socket_exception(__FILE__, __LINE__,
+                               "resolver::next() - Result is null!", false);
+
+    std::lock_guard<std::mutex> guard(lock);
+
+    if (completions.empty()) {
+        // Under the lock, so no notification for a completion that is not in
+        // the queue yet can be lost.
+        char buf[64];
+
+        while (0 < ::read(sfd, buf, sizeof(buf)))
+            ;
+
+        return false;
+    }
+
+    *result = std::move(completions.front());
+    completions.pop_front();
+    outstanding--;
+
+    return true;
+}
+
+void resolver::run(void) {
+    while (true) {
+        request req;
+
+        {
+            std::unique_lock<std::mutex> guard(lock);
+
+            wakeup.wait(guard,
+                        [this] { return stopping || !requests.empty(); });
+
+            if (stopping) return;
+
+            req = std::move(requests.front());
+            requests.pop_front();
+        }
+
+        completion c;
+
+        c.id = req.id;
+        c.host = req.host;
+        c.port = req.port;
+        c.addresses = lookup(req.host.c_str(), req.port.c_str(), req.family,
+                             req.socktype);
+
+        deliver(std::move(c));
+    }
+}
+
+void resolver::deliver(completion&& c) {
+    std::lock_guard<std::mutex> guard(lock);
+
+    completions.push_back(std::move(c));
+
+#if LIBSOCKET_LINUX
+    uint64_t one = 1;
+#else
+    char one = 1;
+#endif
+
+    // Fails only if the counter (pipe) is full, i.e. readable anyway.
+    if (0 > ::write(notify_fd, &one, sizeof(one))) return;
+}
+}  // namespace libsocket
+
+/**
+ * @}
+ */
@@ -0,0 +1,136 @@
+#include <netinet/in.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/socket.h>
+
+/*
+   The committers of the libsocket project, all rights reserved
+   (c) 2012, dermesser <lbo@spheniscida.de>
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS” AND ANY
+   EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+   DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+/**
+ * @file sessiontable.cpp
+ * @brief Keys for dgram_session_table.
+ *
+ * 	The table itself is a template (sessiontable.hpp); only the
+ * 	conversion between socket addresses and keys lives here.
+ *
+ * @addtogroup libsocketplusplus
+ * @{
+ */
+
+#include <sessiontable.hpp>
+
+namespace libsocket {
+
+/**
+ * @brief Set the key from a `sockaddr_in` or `sockaddr_in6`.
+ *
+ * @returns false for other address families.
+ */
+bool session_key::set(const struct sockaddr* sa) {
+    memset(this, 0, sizeof(*this));
+
+    if (sa == NULL) return false;
+
+    if (sa->sa_family == AF_INET) {
+        const struct sockaddr_in* sin =
+            reinterpret_cast<const struct sockaddr_in*>(sa);
+
+        addr[10] = addr[11] = 0xff;
+        memcpy(addr + 12, &sin->sin_addr, 4);
+        port = sin->sin_port;
+        family = AF_INET;
+
+        return true;
+    }
+    if (sa->sa_family == AF_INET6) {
+        const struct sockaddr_in6* sin6 =
+            reinterpret_cast<const struct sockaddr_in6*>(sa);
+
+        memcpy(addr, &sin6->sin6_addr, 16);
+        port = sin6->sin6_port;
+        family = AF_INET6;
+        scope = sin6->sin6_scope_id;
+
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Convert the key back to a socket address.
+ *
+ * @returns The length of the address.
+ */
+socklen_t session_key::get(struct sockaddr_storage* ss) const {
+    memset(ss, 0, sizeof(*ss));
+
+    if (family == AF_INET) {
+        struct sockaddr_in* sin = reinterpret_cast<struct sockaddr_in*>(ss);
+
+        sin->sin_family = AF_INET;
+        sin->sin_port = port;
+        memcpy(&sin->sin_addr, addr + 12, 4);
+
+        return sizeof(*sin);
+    }
+
+    struct sockaddr_in6* sin6 = reinterpret_cast<struct sockaddr_in6*>(ss);
+
+    sin6->sin6_family = AF_INET6;
+    sin6->sin6_port = port;
+    sin6->sin6_scope_id = scope;
+    memcpy(&sin6->sin6_addr, addr, 16);
+
+    return sizeof(*sin6);
+}
+
+/**
+ * @brief Hash of the key: its three 64 bit words, multiplied and mixed
+ * (the finalizer of MurmurHash3).
+ */
+uint32_t session_key::hash(void) const {
+    uint64_t words[3];
+
+    memcpy(words, this, sizeof(words));
+
+    uint64_t h = words[0] * 0x9e3779b97f4a7c15ULL ^
+                 words[1] * 0xc2b2ae3d27d4eb4fULL ^
+                 words[2] * 0x165667b19e3779f9ULL;
+
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+
+    return uint32_t(h);
+}
+}  // namespace libsocket
+
+/**
+ * @}
+ */
@@ -0,0 +1,255 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/filter.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string>
+
+/*
+   The committers of the libsocket project, all rights reserved
+   (c) 2012, dermesser <lbo@spheniscida.de>
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS” AND ANY
+   EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+   DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+/**
+ * @file shardedserverdgram.cpp
+ * @brief UDP server with one `SO_REUSEPORT` socket and thread per shard.
+ *
+ * @addtogroup libsocketplusplus
+ * @{
+ */
+
+#include <exception.hpp>
+#include <shardedserverdgram.hpp>
+
+#ifndef SO_ATTACH_REUSEPORT_CBPF
+#define SO_ATTACH_REUSEPORT_CBPF 51
+#endif
+
+namespace libsocket {
+using std::string;
+
+/**
+ * @brief Create and bind the sockets of all shards.
+ *
+ * @param host Bind address (Wildcard: "0.0.0.0"/"::")
+ * @param port Bind port
+ * @param proto_osi3 `LIBSOCKET_IPv4` or `LIBSOCKET_IPv6` or `LIBSOCKET_BOTH`
+ * @param shards Number of sockets and threads
+ * @param steer How datagrams are distributed between the shards
+ * @param batch_size Maximum number of datagrams received per `recvmmsg(2)`
+ * @param dgram_size Buffer size per datagram; longer datagrams are truncated
+ */
+inet_dgram_sharded_server::inet_dgram_sharded_server(
+    const string& host, const string& port, int proto_osi3, size_t shards,
+    steering steer_, size_t batch_size_, size_t dgram_size_)
+    : errors(shards),
+      steer(steer_),
+      batch_size(batch_size_),
+      dgram_size(dgram_size_) {
+    if (shards == 0)
+        throw socket_exception(__FILE__, __LINE__,
+                               "inet_dgram_sharded_server::inet_dgram_sharded_"
+                               "server() - Number of shards is null!",
+                               false);
+
+    OptionalDgram options;
+    options.flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    options.sockOptFlags.push_back(SO_REUSEPORT);
+
+    for (size_t i = 0; i < shards; i++)
+        sockets.emplace_back(
+            new inet_dgram_server(host, port, proto_osi3, options));
+
+    if (steer != steer_kernel) attach_filter();
+
+    if (0 > pipe2(stop_pipe, O_CLOEXEC))
+        throw socket_exception(__FILE__, __LINE__,
+                               "inet_dgram_sharded_server::inet_dgram_sharded_"
+                               "server() - Could not create pipe!");
+}
+
+/**
+ * @brief Destructor; stops the threads.
+ *
+ * Exceptions thrown by the handler are discarded; call `stop()` before to
+ * handle them.
+ */
+inet_dgram_sharded_server::~inet_dgram_sharded_server(void) {
+    try {
+        stop();
+    } catch (...) {
+    }
+
+    close(stop_pipe[0]);
+    close(stop_pipe[1]);
+}
+
+/**
+ * @brief The socket of shard `i`.
+ */
+inet_dgram_server& inet_dgram_sharded_server::shard(size_t i) {
+    if (i >= sockets.size())
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "inet_dgram_sharded_server::shard() - Index out of range!", false);
+
+    return *sockets[i];
+}
+
+/*
+ * The filter returns the index of the socket (in the order in which they were
+ * bound) that gets the packet.
+ */
+void inet_dgram_sharded_server::attach_filter(void) {
+    struct sock_filter code[] = {
+        // A = cpu or rxhash
+        {BPF_LD | BPF_W | BPF_ABS, 0, 0,
+         (uint32_t)(SKF_AD_OFF +
+                    (steer == steer_cpu ? SKF_AD_CPU : SKF_AD_RXHASH))},
+        // A = A % shards
+        {BPF_ALU | BPF_MOD | BPF_K, 0, 0, (uint32_t)sockets.size()},
+        // return A
+        {BPF_RET | BPF_A, 0, 0, 0},
+    };
+    struct sock_fprog prog;
+
+    prog.len = sizeof(code) / sizeof(code[0]);
+    prog.filter = code;
+
+    // The program applies to the whole group.
+    if (0 > setsockopt(sockets[0]->getfd(), SOL_SOCKET,
+                       SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)))
+        throw socket_exception(__FILE__, __LINE__,
+                               "inet_dgram_sharded_server::attach_filter() - "
+                               "Could not attach steering program!");
+}
+
+/**
+ * @brief Start one thread per shard.
+ *
+ * @param h Called for every received batch. It is copied into every thread.
+ */
+void inet_dgram_sharded_server::start(const handler& h) {
+    if (!threads.empty())
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "inet_dgram_sharded_server::start() - Already started!", false);
+
+    for (size_t i = 0; i < sockets.size(); i++) {
+        errors[i] = std::exception_ptr();
+        threads.emplace_back(&inet_dgram_sharded_server::run, this, i, h);
+    }
+}
+
+/**
+ * @brief Stop and join all threads.
+ *
+ * Rethrows the first exception a shard thread has stopped with, if any.
+ */
+void inet_dgram_sharded_server::stop(void) {
+    if (threads.empty()) return;
+
+    char c = 0;
+
+    while (0 > write(stop_pipe[1], &c, 1) && errno == EINTR)
+        ;
+
+    for (std::thread& t : threads) t.join();
+
+    threads.clear();
+
+    // Make the pipe usable for the next start().
+    if (0 > read(stop_pipe[0], &c, 1))
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "inet_dgram_sharded_server::stop() - Could not reset pipe!");
+
+    for (std::exception_ptr& e : errors)
+        if (e) {
+            std::exception_ptr first = e;
+
+            for (std::exception_ptr& other : errors)
+                other = std::exception_ptr();
+
+            std::rethrow_exception(first);
+        }
+}
+
+void inet_dgram_sharded_server::run(size_t i, handler h) {
+    try {
+        inet_dgram_server& sock = *sockets[i];
+        // Room for timestamps, in case they are enabled on the socket.
+        dgram_batch batch(batch_size, dgram_size,
+                          dgram_batch::timestamp_control_size);
+        struct pollfd fds[2];
+
+        if (steer == steer_cpu) {
+            long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+            cpu_set_t set;
+
+            CPU_ZERO(&set);
+
+            for (long cpu = i; cpu < cpus && cpu < CPU_SETSIZE;
+                 cpu += sockets.size())
+                CPU_SET(cpu, &set);
+
+            // Not fatal: steering still works, only locality is lost.
+            if (CPU_COUNT(&set) > 0)
+                pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        }
+
+        fds[0].fd = sock.getfd();
+        fds[0].events = POLLIN;
+        fds[1].fd = stop_pipe[0];
+        fds[1].events = POLLIN;
+
+        while (true) {
+            if (0 > poll(fds, 2, -1)) {
+                if (errno == EINTR) continue;
+
+                throw socket_exception(
+                    __FILE__, __LINE__,
+                    "inet_dgram_sharded_server::run() - Error at poll");
+            }
+
+            if (fds[1].revents) break;
+
+            // Read a few batches before polling again, but not so many that a
+            // flood delays stop() for long.
+            for (int round = 0; round < 16 && 0 < sock.rcvmmsg(batch);
+                 round++)
+                h(i, sock, batch);
+        }
+    } catch (...) {
+        errors[i] = std::current_exception();
+    }
+}
+}  // namespace libsocket
+
+/**
+ * @}
+ */
@@ -1,3 +1,4 @@
+#include <string.h>
 #include <unistd.h>
 /*
    The committers of the libsocket project, all rights reserved
@@ -35,21 +36,35 @@
  * 	class graph.
  */
 
+#include <conf.h>
 #include <socket.hpp>
 
+#if LIBSOCKET_LINUX
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#endif
+
 namespace libsocket {
 /**
  * @brief Constructor. Sets `sfd` to -1.
  *
  */
 socket::socket(void)
-    : sfd(-1), is_nonblocking(false), close_on_destructor(true) {}
+    : sfd(-1),
+      is_nonblocking(false),
+      close_on_destructor(true),
+      zerocopy(false),
+      zerocopy_next(0) {}
 
 /**
  * @brief Move constructor.
  */
 socket::socket(socket&& other)
-    : sfd(other.sfd), is_nonblocking(false), close_on_destructor(true) {
+    : sfd(other.sfd),
+      is_nonblocking(false),
+      close_on_destructor(true),
+      zerocopy(other.zerocopy),
+      zerocopy_next(other.zerocopy_next) {
     other.sfd = -1;
 }
 
@@ -102,4 +117,169 @@ int socket::set_sock_opt(int level, int optname, const char* optval,
                          socklen_t optlen) const {
     return setsockopt(sfd, level, optname, optval, optlen);
 }
+
+/**
+ * @brief Enable or disable zero-copy sends (`SO_ZEROCOPY`). Linux only.
+ *
+ * Zero-copy mode is required by `stream_client_socket::snd_zerocopy()` and
+ * `inet_dgram::sndto_zerocopy()`. Those send directly from the caller's
+ * memory instead of copying it into the kernel; the buffers may only be
+ * reused once `reap_zerocopy()` has reported their completion. This pays off
+ * for large sends only (usually >10 KiB), as pinning the pages and processing
+ * the notifications has its own cost.
+ */
+void socket::set_zerocopy(bool enable) {
+#if LIBSOCKET_LINUX
+    int val = enable ? 1 : 0;
+
+    if (0 > setsockopt(sfd, SOL_SOCKET, SO_ZEROCOPY, &val, sizeof(val)))
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "socket::set_zerocopy() - Could not set SO_ZEROCOPY!");
+
+    zerocopy = enable;
+#else
+    (void)enable;
+    errno = ENOSYS;
+    throw socket_exception(
+        __FILE__, __LINE__,
+        "socket::set_zerocopy() - Not supported on this platform");
+#endif
+}
+
+/**
+ * @brief Process the completion notifications of zero-copy sends.
+ *
+ * The notifications are read from the socket's error queue, so a socket with
+ * pending notifications is reported by `poll(2)` with `POLLERR` and by
+ * `epollset::wait()` as readable. This function never blocks.
+ *
+ * Other messages in the error queue (e.g. ICMP errors on UDP sockets with
+ * `IP_RECVERR` enabled) are discarded.
+ *
+ * @param callback Called once per notification. A notification may cover
+ * several consecutive sends.
+ *
+ * @returns The number of notifications processed.
+ */
+size_t socket::reap_zerocopy(
+    const std::function<void(const zerocopy_completion&)>& callback) {
+#if LIBSOCKET_LINUX
+    size_t reaped = 0;
+
+    while (true) {
+        char control[128];
+        struct msghdr msg;
+
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        if (0 > recvmsg(sfd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT)) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            if (errno == EINTR) continue;
+
+            throw socket_exception(
+                __FILE__, __LINE__,
+                "socket::reap_zerocopy() - Could not read error queue!");
+        }
+
+        for (struct cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != NULL;
+             cm = CMSG_NXTHDR(&msg, cm)) {
+            if (!(cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) &&
+                !(cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))
+                continue;
+
+            const struct sock_extended_err* err =
+                reinterpret_cast<const struct sock_extended_err*>(
+                    CMSG_DATA(cm));
+
+            if (err->ee_origin != SO_EE_ORIGIN_ZEROCOPY) continue;
+
+            zerocopy_completion completion;
+            completion.first = err->ee_info;
+            completion.last = err->ee_data;
+            completion.copied = err->ee_code & SO_EE_CODE_ZEROCOPY_COPIED;
+
+            callback(completion);
+            reaped++;
+        }
+    }
+
+    return reaped;
+#else
+    (void)callback;
+    errno = ENOSYS;
+    throw socket_exception(
+        __FILE__, __LINE__,
+        "socket::reap_zerocopy() - Not supported on this platform");
+#endif
+}
+
+/**
+ * @brief Enable or disable kernel receive timestamps (`SO_TIMESTAMPNS`). Linux
+ * only.
+ *
+ * The kernel then records the time (`CLOCK_REALTIME`) at which it received
+ * each packet, before any queueing in the socket. The timestamps are returned
+ * by the receive functions taking a `struct timespec*`, and by
+ * `dgram_batch::timestamp()`. The difference to the time at which the
+ * application gets the data is the time it has spent in the receive queue.
+ *
+ * For stream sockets, the timestamp belongs to the last packet whose data
+ * was returned.
+ */
+void socket::set_timestamps(bool enable) {
+#if LIBSOCKET_LINUX
+    int val = enable ? 1 : 0;
+
+    if (0 > setsockopt(sfd, SOL_SOCKET, SO_TIMESTAMPNS, &val, sizeof(val)))
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "socket::set_timestamps() - Could not set SO_TIMESTAMPNS!");
+#else
+    (void)enable;
+    errno = ENOSYS;
+    throw socket_exception(
+        __FILE__, __LINE__,
+        "socket::set_timestamps() - Not supported on this platform");
+#endif
+}
+
+/**
+ * @brief Find the receive timestamp in the control messages of a received
+ * message.
+ *
+ * Understands `SO_TIMESTAMPNS` and the software timestamp of
+ * `SO_TIMESTAMPING`. Useful when calling `recvmsg(2)` directly.
+ *
+ * @param msg A message received with `recvmsg(2)`.
+ * @param stamp Set to the timestamp, if there is one.
+ *
+ * @returns Whether a timestamp was found.
+ */
+bool receive_timestamp(const struct msghdr* msg, struct timespec* stamp) {
+#if LIBSOCKET_LINUX
+    if (msg->msg_control == NULL) return false;
+
+    for (struct cmsghdr* cm = CMSG_FIRSTHDR(msg); cm != NULL;
+         cm = CMSG_NXTHDR(const_cast<struct msghdr*>(msg), cm)) {
+        if (cm->cmsg_level != SOL_SOCKET) continue;
+
+        if (cm->cmsg_type == SO_TIMESTAMPNS) {
+            memcpy(stamp, CMSG_DATA(cm), sizeof(*stamp));
+            return true;
+        }
+        if (cm->cmsg_type == SO_TIMESTAMPING) {
+            // The software timestamp comes first.
+            memcpy(stamp, CMSG_DATA(cm), sizeof(*stamp));
+            return true;
+        }
+    }
+#else
+    (void)msg;
+    (void)stamp;
+#endif
+    return false;
+}
 }  // namespace libsocket
@@ -0,0 +1,255 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string>
+
+/*
+   The committers of the libsocket project, all rights reserved
+   (c) 2012, dermesser <lbo@spheniscida.de>
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS” AND ANY
+   EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+   DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+/**
+ * @file splicerelay.cpp
+ * @brief [LINUX-only] Kernel-side relay between two stream sockets.
+ *
+ * 	Each direction of a splice_relay moves data from its source socket
+ * 	into a pipe and from the pipe into its destination socket using
+ * 	splice(2), so the payload is never copied to user space.
+ *
+ * @addtogroup libsocketplusplus
+ * @{
+ */
+
+#include <exception.hpp>
+#include <splicerelay.hpp>
+
+namespace libsocket {
+using std::string;
+
+// Upper bound of splice() pairs per direction and pump() call, so that a single
+// busy connection can not starve the others sharing a thread.
+static const int max_rounds = 16;
+
+/**
+ * @brief Constructor.
+ *
+ * Sets both sockets to non-blocking mode and creates one pipe per direction.
+ *
+ * @param first One end of the relay.
+ * @param second The other end.
+ * @param pipe_size Size of each pipe in bytes (see `F_SETPIPE_SZ` in
+ * `fcntl(2)`); this is the most data that is in flight per direction. 0 keeps
+ * the system default (usually 64 KiB). Unprivileged processes may not exceed
+ * `/proc/sys/fs/pipe-max-size`.
+ */
+splice_relay::splice_relay(stream_client_socket& first,
+                           stream_client_socket& second, size_t pipe_size)
+    : a(first), b(second), chunk(0) {
+    if (a.sfd == -1 || b.sfd == -1)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "splice_relay::splice_relay() - Socket not connected!", false);
+
+    dirs[0].from = &a;
+    dirs[0].to = &b;
+    dirs[1].from = &b;
+    dirs[1].to = &a;
+
+    for (direction& dir : dirs) {
+        dir.pipefd[0] = dir.pipefd[1] = -1;
+        dir.in_pipe = 0;
+        dir.eof = dir.closed = dir.congested = false;
+        dir.total = 0;
+    }
+
+    watched[0] = watched[1] = 0;
+
+    try {
+        for (direction& dir : dirs) {
+            if (0 > pipe2(dir.pipefd, O_CLOEXEC | O_NONBLOCK))
+                throw socket_exception(
+                    __FILE__, __LINE__,
+                    "splice_relay::splice_relay() - Could not create pipe!");
+
+            if (pipe_size > 0 &&
+                0 > fcntl(dir.pipefd[1], F_SETPIPE_SZ, (int)pipe_size))
+                throw socket_exception(
+                    __FILE__, __LINE__,
+                    "splice_relay::splice_relay() - Could not set pipe size!");
+        }
+
+        int size = fcntl(dirs[0].pipefd[1], F_GETPIPE_SZ);
+
+        if (size <= 0)
+            throw socket_exception(
+                __FILE__, __LINE__,
+                "splice_relay::splice_relay() - Could not get pipe size!");
+
+        chunk = size;
+
+        for (stream_client_socket* sock : {&a, &b}) {
+            int flags = fcntl(sock->sfd, F_GETFL);
+
+            if (flags < 0 || 0 > fcntl(sock->sfd, F_SETFL, flags | O_NONBLOCK))
+                throw socket_exception(__FILE__, __LINE__,
+                                       "splice_relay::splice_relay() - Could "
+                                       "not set socket to non-blocking mode!");
+
+            sock->is_nonblocking = true;
+        }
+    } catch (...) {
+        for (direction& dir : dirs) {
+            if (dir.pipefd[0] != -1) close(dir.pipefd[0]);
+            if (dir.pipefd[1] != -1) close(dir.pipefd[1]);
+        }
+        throw;
+    }
+}
+
+/**
+ * @brief Destructor. Closes the pipes; data still in them is lost.
+ *
+ * The sockets are left open.
+ */
+splice_relay::~splice_relay(void) {
+    for (direction& dir : dirs) {
+        close(dir.pipefd[0]);
+        close(dir.pipefd[1]);
+    }
+}
+
+/**
+ * @brief Move as much data as possible in both directions without blocking.
+ *
+ * A socket that has sent EOF has its peer socket shut down for writing once
+ * all data received before the EOF has been written to the peer.
+ *
+ * Errors on either socket (e.g. a reset connection) make this function throw
+ * a `socket_exception`; the relay should be destroyed then.
+ *
+ * @returns `false` once both directions are finished, i.e. `done()` is true.
+ */
+bool splice_relay::pump(void) {
+    pump(dirs[0]);
+    pump(dirs[1]);
+
+    return !done();
+}
+
+/**
+ * @brief Whether both directions have seen EOF and passed it on.
+ */
+bool splice_relay::done(void) const { return dirs[0].closed && dirs[1].closed; }
+
+/**
+ * @brief The events the relay currently waits for on one of its sockets.
+ *
+ * @param sock Either of the two sockets given to the constructor.
+ *
+ * @returns A combination of `LIBSOCKET_READ` (the socket has not sent EOF yet
+ * and the data read from it before has been passed on) and `LIBSOCKET_WRITE`
+ * (data or an EOF is waiting to be passed on to it); 0 if the relay is not
+ * waiting for the socket at all.
+ */
+int splice_relay::interest(const stream_client_socket& sock) const {
+    const direction& out = (&sock == &a) ? dirs[0] : dirs[1];
+    const direction& in = (&sock == &a) ? dirs[1] : dirs[0];
+    int method = 0;
+
+    if (!out.eof && !out.congested) method |= LIBSOCKET_READ;
+    if (in.congested || in.in_pipe > 0 || (in.eof && !in.closed))
+        method |= LIBSOCKET_WRITE;
+
+    return method;
+}
+
+// Only reads from the source once the pipe is empty; that way, EAGAIN from the
+// reading splice() always means that the source has no data (and not that the
+// pipe is full), and a congested destination stops reads from the source.
+void splice_relay::pump(direction& dir) {
+    for (int round = 0; round < max_rounds; round++) {
+        // Drain first, so that there is room for new data.
+        if (!drain(dir) || dir.eof) return;
+
+        ssize_t recvd = splice(dir.from->sfd, NULL, dir.pipefd[1], NULL, chunk,
+                               SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+
+        if (recvd < 0) {
+            if (errno == EAGAIN)
+                return;
+            else if (errno == EINTR)
+                continue;
+            else
+                throw socket_exception(
+                    __FILE__, __LINE__,
+                    "splice_relay::pump() - Error while reading!");
+        }
+
+        if (recvd == 0) dir.eof = true;
+
+        dir.in_pipe += recvd;
+    }
+
+    // The last round ended with a read; pass that data (or the EOF) on, too.
+    // Otherwise nothing would be armed to do it: the source may have nothing
+    // more to read, and the destination has not been congested.
+    drain(dir);
+}
+
+// Writes the pipe's contents to the destination and, after EOF, shuts it down
+// for writing. Returns false if the destination is congested.
+bool splice_relay::drain(direction& dir) {
+    while (dir.in_pipe > 0) {
+        ssize_t sent = splice(dir.pipefd[0], NULL, dir.to->sfd, NULL,
+                              dir.in_pipe, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+
+        if (sent < 0) {
+            if (errno == EAGAIN) {
+                dir.congested = true;
+                return false;
+            } else if (errno == EINTR)
+                continue;
+            else
+                throw socket_exception(
+                    __FILE__, __LINE__,
+                    "splice_relay::pump() - Error while writing!");
+        }
+
+        dir.congested = false;
+        dir.in_pipe -= sent;
+        dir.total += sent;
+    }
+
+    if (dir.eof && !dir.closed) {
+        dir.to->shutdown(LIBSOCKET_WRITE);
+        dir.closed = true;
+    }
+
+    return true;
+}
+}  // namespace libsocket
+
+/**
+ * @}
+ */
@@ -39,8 +39,17 @@
 #include <string>
 
 #include <conf.h>
+
+#if LIBSOCKET_LINUX
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/mman.h>
+#endif
+
 #include <libinetsocket.h>
 #include <exception.hpp>
+#include <bufferpool.hpp>
 #include <streamclient.hpp>
 
 namespace libsocket {
@@ -94,6 +103,72 @@ ssize_t stream_client_socket::rcv(void* buf, size_t len, int flags) {
     return recvd;
 }
 
+/**
+ * @brief Receive data from socket, along with the kernel receive timestamp
+ *
+ * Works like `rcv()`, but also returns when the kernel received the data.
+ * Requires `set_timestamps()`.
+ *
+ * @param buf A writable memory buffer of length `len`
+ * @param len Length of `buf`
+ * @param stamp Set to the time (`CLOCK_REALTIME`) at which the kernel received
+ * the last packet whose data is returned; zero if no timestamp is available.
+ * @param flags Flags for `recvmsg(2)`
+ *
+ * @retval >0 n bytes were received.
+ * @retval 0 Peer sent EOF.
+ * @retval -1 Socket is non-blocking and there was no data.
+ */
+ssize_t stream_client_socket::rcv(void* buf, size_t len, struct timespec* stamp,
+                                  int flags) {
+    ssize_t recvd;
+
+    if (shut_rd == true)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "stream_client_socket::rcv() - Socket has already been shut down!",
+            false);
+    if (sfd == -1)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "stream_client_socket::rcv() - Socket is not connected!", false);
+    if (buf == NULL || len == 0 || stamp == NULL)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "stream_client_socket::rcv() - Buffer, length or stamp is null!",
+            false);
+
+    union {
+        char buf[CMSG_SPACE(3 * sizeof(struct timespec))];
+        struct cmsghdr align;
+    } control;
+    struct msghdr msg;
+    struct iovec iov;
+
+    memset(&msg, 0, sizeof(msg));
+
+    iov.iov_base = buf;
+    iov.iov_len = len;
+
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    if (-1 == (recvd = recvmsg(sfd, &msg, flags))) {
+        if (is_nonblocking && errno == EWOULDBLOCK)
+            return -1;
+        else
+            throw socket_exception(
+                __FILE__, __LINE__,
+                "stream_client_socket::rcv() - Error while reading!");
+    }
+
+    if (!receive_timestamp(&msg, stamp)) stamp->tv_sec = stamp->tv_nsec = 0;
+
+    return recvd;
+}
+
 /**
  * @brief Receive data from socket to a string
  *
@@ -224,6 +299,33 @@ stream_client_socket& operator<<(stream_client_socket& sock,
     return sock;
 }
 
+#if LIBSOCKET_HAVE_STRING_VIEW
+/**
+ * @brief Send data to socket
+ *
+ * Like `operator<<(stream_client_socket&, const string&)`, for strings that
+ * are not null-terminated or are part of a larger buffer.
+ */
+stream_client_socket& operator<<(stream_client_socket& sock,
+                                 std::string_view str) {
+    if (sock.shut_wr == true)
+        throw socket_exception(__FILE__, __LINE__,
+                               "stream_client_socket::operator<<(string_view) "
+                               "- Socket has already been shut down!",
+                               false);
+    if (sock.sfd == -1)
+        throw socket_exception(__FILE__, __LINE__,
+                               "<<(string_view) output: Socket not connected!",
+                               false);
+
+    if (-1 == write(sock.sfd, str.data(), str.size()))
+        throw socket_exception(__FILE__, __LINE__,
+                               "<<(string_view) output: Write failed!");
+
+    return sock;
+}
+#endif
+
 /**
  * @brief Send data to socket
  *
@@ -265,6 +367,385 @@ ssize_t stream_client_socket::snd(const void* buf, size_t len, int flags) {
     return snd_bytes;
 }
 
+/**
+ * @brief Send data to socket, without throwing
+ *
+ * Works like `snd()`, but reports errors in `ec` instead of throwing.
+ *
+ * @param buf Data to be sent
+ * @param len Length of `buf`
+ * @param ec Set to the error, or cleared.
+ * @param flags Flags for `send(2)`
+ *
+ * @returns The number of bytes sent, or -1 on error (also if the socket is
+ * non-blocking and no data was sent).
+ */
+ssize_t stream_client_socket::snd(const void* buf, size_t len,
+                                  std::error_code& ec, int flags) {
+    ssize_t snd_bytes;
+
+    if (shut_wr) {
+        ec.assign(ESHUTDOWN, std::system_category());
+        return -1;
+    }
+    if (sfd == -1) {
+        ec.assign(ENOTCONN, std::system_category());
+        return -1;
+    }
+    if (buf == NULL || len == 0) {
+        ec.assign(EINVAL, std::system_category());
+        return -1;
+    }
+
+    if (-1 == (snd_bytes = ::send(sfd, buf, len, flags)))
+        ec.assign(errno, std::system_category());
+    else
+        ec.clear();
+
+    return snd_bytes;
+}
+
+/**
+ * @brief Send data to socket
+ *
+ * Works like `snd(const void*, size_t, int)`; `data` may be any contiguous
+ * container of bytes (see `byte_span`).
+ */
+ssize_t stream_client_socket::snd(byte_span data, int flags) {
+    return snd(data.data(), data.size(), flags);
+}
+
+/**
+ * @brief Send data to socket, without throwing
+ *
+ * See above.
+ */
+ssize_t stream_client_socket::snd(byte_span data, std::error_code& ec,
+                                  int flags) {
+    return snd(data.data(), data.size(), ec, flags);
+}
+
+/**
+ * @brief Receive data from socket, without throwing
+ *
+ * Works like `rcv()`, but reports errors in `ec` instead of throwing.
+ * Unlike `rcv()`, the buffer is not zeroed first.
+ *
+ * @param buf A writable memory buffer of length `len`
+ * @param len Length of `buf`
+ * @param ec Set to the error, or cleared.
+ * @param flags Flags for `recv(2)`
+ *
+ * @retval >0 n bytes were received.
+ * @retval 0 Peer sent EOF.
+ * @retval -1 Error, also if the socket is non-blocking and there was no data.
+ */
+ssize_t stream_client_socket::rcv(void* buf, size_t len, std::error_code& ec,
+                                  int flags) {
+    ssize_t recvd;
+
+    if (shut_rd) {
+        ec.assign(ESHUTDOWN, std::system_category());
+        return -1;
+    }
+    if (sfd == -1) {
+        ec.assign(ENOTCONN, std::system_category());
+        return -1;
+    }
+    if (buf == NULL || len == 0) {
+        ec.assign(EINVAL, std::system_category());
+        return -1;
+    }
+
+    if (-1 == (recvd = ::recv(sfd, buf, len, flags)))
+        ec.assign(errno, std::system_category());
+    else
+        ec.clear();
+
+    return recvd;
+}
+
+/**
+ * @brief Send (part of) a file without copying it through user space
+ *
+ * Uses `sendfile(2)`, or `splice(2)` through a pipe if `fd` is not suitable for
+ * `sendfile(2)` (e.g. a pipe). Linux only.
+ *
+ * On a blocking socket, this function returns after `count` bytes have been
+ * sent or the end of `fd` has been reached. On a non-blocking socket it
+ * returns when the socket buffer is full; call it again with `offset` advanced
+ * by the return value once the socket is writable.
+ *
+ * @param fd File descriptor to read from. Its file offset is not changed.
+ * @param offset Where to start reading in `fd`; ignored if `fd` is a pipe or
+ * socket.
+ * @param count How many bytes to send
+ *
+ * @returns The number of bytes sent. -1 if the socket is non-blocking and no
+ * data was sent.
+ */
+ssize_t stream_client_socket::send_file(int fd, off_t offset, size_t count) {
+    if (shut_wr == true)
+        throw socket_exception(__FILE__, __LINE__,
+                               "stream_client_socket::send_file() - Socket has "
+                               "already been shut down!",
+                               false);
+    if (sfd == -1)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "stream_client_socket::send_file() - Socket not connected!", false);
+
+#if LIBSOCKET_LINUX
+    ssize_t sent;
+
+    if (-1 == (sent = sendfile_inet_stream_socket(sfd, fd, &offset, count))) {
+        if (is_nonblocking && errno == EWOULDBLOCK)
+            return -1;
+        else
+            throw socket_exception(
+                __FILE__, __LINE__,
+                "stream_client_socket::send_file() - Error while sending");
+    }
+
+    return sent;
+#else
+    (void)fd;
+    (void)offset;
+    (void)count;
+    errno = ENOSYS;
+    throw socket_exception(
+        __FILE__, __LINE__,
+        "stream_client_socket::send_file() - Not supported on this platform");
+#endif
+}
+
+#if LIBSOCKET_LINUX
+// The original layout of struct tcp_zerocopy_receive (Linux 4.18); newer
+// kernels accept it as well.
+struct zerocopy_receive_args {
+    uint64_t address;
+    uint32_t length;
+    uint32_t recv_skip_hint;
+};
+#endif
+
+/**
+ * @brief Receive data by mapping it from the kernel (`TCP_ZEROCOPY_RECEIVE`)
+ *
+ * Full pages of received data are mapped read-only into the caller's address
+ * space instead of being copied. Data that does not fill a page, or is not
+ * page-aligned within the kernel's buffers, is copied into a buffer owned by
+ * `span`; this is also the case for non-TCP sockets and on platforms other
+ * than Linux. Zero-copy receive only pays off for bulk transfers with large
+ * segments (e.g. an MTU of 4 KiB of payload plus headers, or header split on
+ * the NIC); check `span->mapped()` to see how often it succeeds.
+ *
+ * Mapping requires the socket to be a TCP socket.
+ *
+ * @param span Receives the data. Data previously held by it is released first.
+ * @param len The maximum number of bytes to receive. Rounded down to full
+ * pages for the mapping.
+ *
+ * @retval >0 n bytes were received; `span->size()` is n.
+ * @retval 0 Peer sent EOF.
+ * @retval -1 Socket is non-blocking and there was no data.
+ */
+ssize_t stream_client_socket::rcv_mapped(mapped_span* span, size_t len) {
+    if (shut_rd == true)
+        throw socket_exception(__FILE__, __LINE__,
+                               "stream_client_socket::rcv_mapped() - Socket "
+                               "has already been shut down!",
+                               false);
+    if (sfd == -1)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "stream_client_socket::rcv_mapped() - Socket not connected!",
+            false);
+    if (span == NULL || len == 0)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "stream_client_socket::rcv_mapped() - Span or length is null!",
+            false);
+
+    span->release();
+
+    size_t copy_len = len;
+
+#if LIBSOCKET_LINUX
+    static const size_t page_size = sysconf(_SC_PAGESIZE);
+    size_t map_len = len - len % page_size;
+
+    if (map_len > 0) {
+        // Wait for data; the mapping call itself does not block.
+        if (!is_nonblocking) {
+            struct pollfd pfd;
+            pfd.fd = sfd;
+            pfd.events = POLLIN;
+
+            while (0 > poll(&pfd, 1, -1))
+                if (errno != EINTR)
+                    throw socket_exception(
+                        __FILE__, __LINE__,
+                        "stream_client_socket::rcv_mapped() - Error while "
+                        "waiting for data");
+        }
+
+        void* region = mmap(NULL, map_len, PROT_READ, MAP_SHARED, sfd, 0);
+
+        if (region != MAP_FAILED) {
+            struct zerocopy_receive_args zc;
+            socklen_t zc_len = sizeof(zc);
+
+            memset(&zc, 0, sizeof(zc));
+            zc.address = reinterpret_cast<uintptr_t>(region);
+            zc.length = map_len;
+
+            if (0 == getsockopt(sfd, IPPROTO_TCP, TCP_ZEROCOPY_RECEIVE, &zc,
+                                &zc_len) &&
+                zc.length > 0) {
+                span->map_address = region;
+                span->map_length = map_len;
+                span->begin = static_cast<const char*>(region);
+                span->length = zc.length;
+
+                return zc.length;
+            }
+
+            munmap(region, map_len);
+
+            // Copy up to where the next page-aligned data starts.
+            if (zc.recv_skip_hint > 0 && zc.recv_skip_hint < len)
+                copy_len = zc.recv_skip_hint;
+        }
+    }
+#endif
+
+    std::unique_ptr<char[]> copy(new char[copy_len]);
+    ssize_t recvd = ::recv(sfd, copy.get(), copy_len, 0);
+
+    if (recvd < 0) {
+        if (is_nonblocking && errno == EWOULDBLOCK)
+            return -1;
+        else
+            throw socket_exception(
+                __FILE__, __LINE__,
+                "stream_client_socket::rcv_mapped() - Error while reading!");
+    }
+
+    if (recvd == 0) return 0;
+
+    span->copy = std::move(copy);
+    span->begin = span->copy.get();
+    span->length = recvd;
+
+    return recvd;
+}
+
+/**
+ * @brief Send data without copying it into the kernel (`MSG_ZEROCOPY`)
+ *
+ * Zero-copy mode has to be enabled with `set_zerocopy()` first. The kernel
+ * sends directly from `buf`, so its contents must not be changed until
+ * `reap_zerocopy()` reports a completion covering `*id`.
+ *
+ * @param buf The data to be sent
+ * @param len Length of `buf`
+ * @param id Set to the id of this send (may be NULL). Ids are assigned
+ * consecutively per socket, starting at 0.
+ * @param flags Additional flags for `send(2)`
+ *
+ * @retval >0 n bytes were sent (may be less than `len`; the rest has not been
+ * handed to the kernel).
+ * @retval -1 The socket is non-blocking and no data was sent, or the kernel
+ * does not allow more memory to be pinned (`errno` is `ENOBUFS`); call
+ * `reap_zerocopy()` and try again, or fall back to `snd()`.
+ */
+ssize_t stream_client_socket::snd_zerocopy(const void* buf, size_t len,
+                                           uint32_t* id, int flags) {
+    if (shut_wr == true)
+        throw socket_exception(__FILE__, __LINE__,
+                               "stream_client_socket::snd_zerocopy() - Socket "
+                               "has already been shut down!",
+                               false);
+    if (sfd == -1)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "stream_client_socket::snd_zerocopy() - Socket not connected!",
+            false);
+    if (buf == NULL || len == 0)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "stream_client_socket::snd_zerocopy() - Buffer or length is null!",
+            false);
+    if (!zerocopy)
+        throw socket_exception(__FILE__, __LINE__,
+                               "stream_client_socket::snd_zerocopy() - "
+                               "Zero-copy mode is not enabled!",
+                               false);
+
+#if LIBSOCKET_LINUX
+    ssize_t snd_bytes;
+
+    if (-1 == (snd_bytes = ::send(sfd, buf, len, flags | MSG_ZEROCOPY))) {
+        if ((is_nonblocking && errno == EWOULDBLOCK) || errno == ENOBUFS)
+            return -1;
+        else
+            throw socket_exception(
+                __FILE__, __LINE__,
+                "stream_client_socket::snd_zerocopy() - Error while sending");
+    }
+
+    if (id != NULL) *id = zerocopy_next;
+    zerocopy_next++;
+
+    return snd_bytes;
+#else
+    (void)id;
+    (void)flags;
+    errno = ENOSYS;
+    throw socket_exception(
+        __FILE__, __LINE__,
+        "stream_client_socket::snd_zerocopy() - Not supported on this platform");
+#endif
+}
+
+/**
+ * @brief Limit the data waiting in the kernel to be sent (`TCP_NOTSENT_LOWAT`)
+ *
+ * The kernel keeps accepting data until the socket buffer is full, and a slow
+ * peer lets megabytes pile up there where the application can neither see
+ * nor reorder them. With a limit, the socket is only writable (for `poll(2)`,
+ * `epoll` and non-blocking sends) while less than `bytes` have not been sent
+ * yet; data already sent and waiting for acknowledgement does not count. The
+ * rest stays with the application, e.g. in a `write_queue`.
+ *
+ * Only for TCP sockets.
+ *
+ * @param bytes The limit; 0 restores the system-wide default
+ * (`net.ipv4.tcp_notsent_lowat`, unlimited unless configured).
+ */
+void stream_client_socket::set_notsent_lowat(unsigned int bytes) {
+    if (sfd == -1)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "stream_client_socket::set_notsent_lowat() - Socket not connected!",
+            false);
+
+#if LIBSOCKET_LINUX && defined(TCP_NOTSENT_LOWAT)
+    if (0 > setsockopt(sfd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &bytes,
+                       sizeof(bytes)))
+        throw socket_exception(__FILE__, __LINE__,
+                               "stream_client_socket::set_notsent_lowat() - "
+                               "Could not set TCP_NOTSENT_LOWAT!");
+#else
+    (void)bytes;
+    errno = ENOSYS;
+    throw socket_exception(__FILE__, __LINE__,
+                           "stream_client_socket::set_notsent_lowat() - Not "
+                           "supported on this platform");
+#endif
+}
+
 /**
  * @brief Shut a socket down
  *
@@ -303,4 +784,21 @@ void stream_client_socket::shutdown(int method) {
     if (method & LIBSOCKET_READ) shut_rd = true;
     if (method & LIBSOCKET_WRITE) shut_wr = true;
 }
+
+/**
+ * @brief Receive data into a buffer from a `buffer_pool`
+ *
+ * Receives up to `buf.capacity()` bytes, like `rcv(void*, size_t, int)`, and
+ * sets the size of `buf` to the number of bytes received.
+ *
+ * @returns The number of bytes received; 0 on EOF. -1 if the socket is
+ * non-blocking and no data was available.
+ */
+ssize_t stream_client_socket::rcv(pooled_buffer& buf, int flags) {
+    ssize_t bytes = rcv(buf.data(), buf.capacity(), flags);
+
+    buf.resize(bytes > 0 ? bytes : 0);
+
+    return bytes;
+}
 }  // namespace libsocket
@@ -0,0 +1,649 @@
+#include <errno.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <memory>
+#include <string>
+
+/*
+   The committers of the libsocket project, all rights reserved
+   (c) 2012, dermesser <lbo@spheniscida.de>
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS” AND ANY
+   EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+   DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+/**
+ * @file streamhandle.cpp
+ * @brief A compact handle for connected stream sockets.
+ *
+ * 	stream_handle is the file descriptor of a connected stream socket
+ * 	plus a few state bits, for servers with very many connections.
+ *
+ * @addtogroup libsocketplusplus
+ * @{
+ */
+
+#include <conf.h>
+
+#include <bufferpool.hpp>
+#include <exception.hpp>
+#include <framing.hpp>
+#include <streamhandle.hpp>
+
+namespace libsocket {
+using std::string;
+
+/**
+ * @brief Take ownership of a connected stream socket descriptor.
+ *
+ * @param fd The descriptor; closed when the handle is destroyed.
+ */
+stream_handle::stream_handle(int fd) : fd(fd), state(0) {
+    int fl;
+
+    if (fd >= 0 && 0 <= (fl = fcntl(fd, F_GETFL)) && (fl & O_NONBLOCK))
+        state |= nonblocking_bit;
+}
+
+/**
+ * @brief Take over the descriptor of a connected stream socket object.
+ *
+ * `sock` is destroyed without closing the descriptor; use this to connect
+ * with `inet_stream` or `unix_stream_client` and keep only the handle.
+ */
+stream_handle::stream_handle(std::unique_ptr<stream_client_socket> sock)
+    : fd(-1), state(0) {
+    if (!sock) return;
+
+    fd = sock->sfd;
+    sock->sfd = -1;
+
+    if (sock->is_nonblocking) state |= nonblocking_bit;
+    if (sock->shut_rd) state |= shut_rd_bit;
+    if (sock->shut_wr) state |= shut_wr_bit;
+}
+
+stream_handle::stream_handle(stream_handle&& other)
+    : fd(other.fd), state(other.state) {
+    other.fd = -1;
+    other.state = 0;
+}
+
+stream_handle::~stream_handle(void) { destroy(); }
+
+stream_handle& stream_handle::operator=(stream_handle&& other) {
+    if (this != &other) {
+        destroy();
+
+        fd = other.fd;
+        state = other.state;
+
+        other.fd = -1;
+        other.state = 0;
+    }
+
+    return *this;
+}
+
+/**
+ * @brief Accept a connection on a listening stream socket.
+ *
+ * @param server An `inet_stream_server`, `unix_stream_server`, or any other
+ * listening stream socket
+ * @param flags `SOCK_NONBLOCK` and/or `SOCK_CLOEXEC` for the new socket
+ *
+ * @returns The handle of the connection; an empty handle if the server socket
+ * is non-blocking and no client is waiting.
+ */
+stream_handle stream_handle::accept(const socket& server, int flags) {
+    std::error_code ec;
+    stream_handle client = accept(server, ec, flags);
+
+    if (ec && ec != std::errc::operation_would_block) {
+        errno = ec.value();
+        throw socket_exception(__FILE__, __LINE__,
+                               "stream_handle::accept() - Could not accept "
+                               "new connection!");
+    }
+
+    return client;
+}
+
+/**
+ * @brief Accept a connection on a listening stream socket, without throwing.
+ *
+ * See above; errors are reported in `ec` and an empty handle is returned.
+ */
+stream_handle stream_handle::accept(const socket& server, std::error_code& ec,
+                                    int flags) {
+    stream_handle client;
+    int cfd;
+
+#if LIBSOCKET_LINUX
+    cfd = ::accept4(server.getfd(), NULL, NULL, flags);
+#else
+    if (0 <= (cfd = ::accept(server.getfd(), NULL, NULL))) {
+        if (flags & SOCK_NONBLOCK)
+            fcntl(cfd, F_SETFL, fcntl(cfd, F_GETFL) | O_NONBLOCK);
+        if (flags & SOCK_CLOEXEC) fcntl(cfd, F_SETFD, FD_CLOEXEC);
+    }
+#endif
+
+    if (cfd < 0) {
+        ec.assign(errno, std::system_category());
+        return client;
+    }
+
+    client.fd = cfd;
+    if (flags & SOCK_NONBLOCK) client.state |= nonblocking_bit;
+
+    ec.clear();
+
+    return client;
+}
+
+/**
+ * @brief Give up ownership of the descriptor.
+ *
+ * @returns The descriptor, which the caller has to close; -1 if the handle was
+ * empty.
+ */
+int stream_handle::release(void) {
+    int ret = fd;
+
+    fd = -1;
+    state = 0;
+
+    return ret;
+}
+
+/**
+ * @brief Close the socket.
+ *
+ * @retval 0 Closed, or the handle was empty.
+ * @retval -1 `close(2)` failed.
+ */
+int stream_handle::destroy(void) {
+    if (fd < 0) return 0;
+
+    int ret = close(fd);
+
+    fd = -1;
+    state = 0;
+
+    return ret < 0 ? -1 : 0;
+}
+
+/**
+ * @brief Send data.
+ *
+ * Like `stream_client_socket::snd()`.
+ *
+ * @returns The number of bytes sent. -1 if the handle is non-blocking and no
+ * data was sent.
+ */
+ssize_t stream_handle::snd(const void* buf, size_t len, int flags) {
+    std::error_code ec;
+    ssize_t bytes = snd(buf, len, ec, flags);
+
+    if (ec && !(nonblocking() && ec == std::errc::operation_would_block)) {
+        errno = ec.value();
+        throw socket_exception(__FILE__, __LINE__,
+                               "stream_handle::snd() - Error while sending");
+    }
+
+    return bytes;
+}
+
+/**
+ * @brief Receive data.
+ *
+ * Like `stream_client_socket::rcv()`, but `buf` is not zeroed.
+ *
+ * @retval >0 n bytes were received.
+ * @retval 0 Peer sent EOF.
+ * @retval -1 The handle is non-blocking and there was no data.
+ */
+ssize_t stream_handle::rcv(void* buf, size_t len, int flags) {
+    std::error_code ec;
+    ssize_t bytes = rcv(buf, len, ec, flags);
+
+    if (ec && !(nonblocking() && ec == std::errc::operation_would_block)) {
+        errno = ec.value();
+        throw socket_exception(__FILE__, __LINE__,
+                               "stream_handle::rcv() - Error while reading!");
+    }
+
+    return bytes;
+}
+
+/**
+ * @brief Send data, without throwing.
+ *
+ * Like `stream_client_socket::snd(const void*, size_t, std::error_code&,
+ * int)`.
+ */
+ssize_t stream_handle::snd(const void* buf, size_t len, std::error_code& ec,
+                           int flags) {
+    ssize_t bytes;
+
+    if (state & shut_wr_bit) {
+        ec.assign(ESHUTDOWN, std::system_category());
+        return -1;
+    }
+    if (fd < 0) {
+        ec.assign(ENOTCONN, std::system_category());
+        return -1;
+    }
+    if (buf == NULL || len == 0) {
+        ec.assign(EINVAL, std::system_category());
+        return -1;
+    }
+
+    if (-1 == (bytes = ::send(fd, buf, len, flags)))
+        ec.assign(errno, std::system_category());
+    else
+        ec.clear();
+
+    return bytes;
+}
+
+/**
+ * @brief Receive data, without throwing.
+ *
+ * Like `stream_client_socket::rcv(void*, size_t, std::error_code&, int)`.
+ */
+ssize_t stream_handle::rcv(void* buf, size_t len, std::error_code& ec,
+                           int flags) {
+    ssize_t bytes;
+
+    if (state & shut_rd_bit) {
+        ec.assign(ESHUTDOWN, std::system_category());
+        return -1;
+    }
+    if (fd < 0) {
+        ec.assign(ENOTCONN, std::system_category());
+        return -1;
+    }
+    if (buf == NULL || len == 0) {
+        ec.assign(EINVAL, std::system_category());
+        return -1;
+    }
+
+    if (-1 == (bytes = ::recv(fd, buf, len, flags)))
+        ec.assign(errno, std::system_category());
+    else
+        ec.clear();
+
+    return bytes;
+}
+
+/**
+ * @brief Send data; `data` may be any contiguous container of bytes.
+ */
+ssize_t stream_handle::snd(byte_span data, int flags) {
+    return snd(data.data(), data.size(), flags);
+}
+
+/**
+ * @brief Send data, without throwing; see above.
+ */
+ssize_t stream_handle::snd(byte_span data, std::error_code& ec, int flags) {
+    return snd(data.data(), data.size(), ec, flags);
+}
+
+/**
+ * @brief Send `buf` as one frame, in the format of `dgram_over_stream`.
+ *
+ * Prefix and message go out in one `writev(2)`. Only for blocking handles.
+ *
+ * @returns `len`
+ */
+ssize_t stream_handle::sndmsg(const void* buf, size_t len) {
+    std::error_code ec;
+    ssize_t bytes = sndmsg(buf, len, ec);
+
+    if (ec) {
+        errno = ec.value();
+        throw socket_exception(__FILE__, __LINE__,
+                               "stream_handle::sndmsg() - Could not send "
+                               "message!");
+    }
+
+    return bytes;
+}
+
+/**
+ * @brief Receive one frame sent by `sndmsg()` or a `dgram_over_stream`.
+ *
+ * Only for blocking handles. Bytes of the message beyond `len` are discarded.
+ *
+ * @returns The number of bytes stored in `dst`; 0 if the peer closed the
+ * connection between two frames.
+ */
+ssize_t stream_handle::rcvmsg(void* dst, size_t len) {
+    std::error_code ec;
+    ssize_t bytes = rcvmsg(dst, len, ec);
+
+    if (ec) {
+        errno = ec.value();
+        throw socket_exception(__FILE__, __LINE__,
+                               "stream_handle::rcvmsg() - Could not receive "
+                               "message!");
+    }
+
+    return bytes;
+}
+
+/**
+ * @brief Send one frame, without throwing.
+ *
+ * See above. Fails with `EINVAL` on non-blocking handles, since a partially
+ * sent frame could not be completed later.
+ */
+ssize_t stream_handle::sndmsg(const void* buf, size_t len,
+                              std::error_code& ec) {
+    char prefix[FRAMING_PREFIX_LENGTH];
+    struct iovec iov[2];
+    size_t total = FRAMING_PREFIX_LENGTH + len;
+    size_t sent = 0;
+
+    if (state & shut_wr_bit) {
+        ec.assign(ESHUTDOWN, std::system_category());
+        return -1;
+    }
+    if (fd < 0) {
+        ec.assign(ENOTCONN, std::system_category());
+        return -1;
+    }
+    if (nonblocking() || (buf == NULL && len > 0)) {
+        ec.assign(EINVAL, std::system_category());
+        return -1;
+    }
+    if (len > INT32_MAX) {
+        ec.assign(EMSGSIZE, std::system_category());
+        return -1;
+    }
+
+    encode_uint32(uint32_t(len), prefix);
+
+    while (sent < total) {
+        int n = 0;
+
+        if (sent < FRAMING_PREFIX_LENGTH) {
+            iov[n].iov_base = prefix + sent;
+            iov[n].iov_len = FRAMING_PREFIX_LENGTH - sent;
+            n++;
+        }
+
+        size_t body = sent > FRAMING_PREFIX_LENGTH
+                          ? sent - FRAMING_PREFIX_LENGTH
+                          : 0;
+
+        if (body < len) {
+            iov[n].iov_base = const_cast<char*>(static_cast<const char*>(buf)) +
+                              body;
+            iov[n].iov_len = len - body;
+            n++;
+        }
+
+        ssize_t bytes = ::writev(fd, iov, n);
+
+        if (bytes < 0) {
+            if (errno == EINTR) continue;
+
+            ec.assign(errno, std::system_category());
+            return -1;
+        }
+
+        sent += bytes;
+    }
+
+    ec.clear();
+
+    return len;
+}
+
+/**
+ * @brief Send `msg` as one frame; see `sndmsg(const void*, size_t)`.
+ */
+ssize_t stream_handle::sndmsg(byte_span msg) {
+    return sndmsg(msg.data(), msg.size());
+}
+
+/**
+ * @brief Send `msg` as one frame, without throwing.
+ */
+ssize_t stream_handle::sndmsg(byte_span msg, std::error_code& ec) {
+    return sndmsg(msg.data(), msg.size(), ec);
+}
+
+/**
+ * @brief Receive one frame, without throwing.
+ *
+ * See above. If the connection ends within a frame, `ec` is `ECONNRESET`.
+ * Fails with `EINVAL` on non-blocking handles.
+ */
+ssize_t stream_handle::rcvmsg(void* dst, size_t len, std::error_code& ec) {
+    char prefix[FRAMING_PREFIX_LENGTH];
+    char discard[256];
+
+    if (state & shut_rd_bit) {
+        ec.assign(ESHUTDOWN, std::system_category());
+        return -1;
+    }
+    if (fd < 0) {
+        ec.assign(ENOTCONN, std::system_category());
+        return -1;
+    }
+    if (nonblocking() || (dst == NULL && len > 0)) {
+        ec.assign(EINVAL, std::system_category());
+        return -1;
+    }
+
+    // EOF before the first byte of a frame is a regular end.
+    ssize_t first;
+
+    do
+        first = ::recv(fd, prefix, FRAMING_PREFIX_LENGTH, 0);
+    while (first < 0 && errno == EINTR);
+
+    if (first < 0) {
+        ec.assign(errno, std::system_category());
+        return -1;
+    }
+    if (first == 0) {
+        ec.clear();
+        return 0;
+    }
+
+    if (!recv_all(prefix + first, FRAMING_PREFIX_LENGTH - first, ec)) return -1;
+
+    uint32_t expected = decode_uint32(prefix);
+    size_t keep = len < expected ? len : expected;
+
+    if (!recv_all(dst, keep, ec)) return -1;
+
+    for (size_t rest = expected - keep; rest > 0;) {
+        size_t n = rest < sizeof(discard) ? rest : sizeof(discard);
+
+        if (!recv_all(discard, n, ec)) return -1;
+
+        rest -= n;
+    }
+
+    return keep;
+}
+
+/**
+ * @brief Shut the connection down for reading and/or writing.
+ *
+ * Like `stream_client_socket::shutdown()`.
+ */
+void stream_handle::shutdown(int method) {
+    int how;
+
+    if (method == (LIBSOCKET_READ | LIBSOCKET_WRITE))
+        how = SHUT_RDWR;
+    else if (method == LIBSOCKET_READ)
+        how = SHUT_RD;
+    else if (method == LIBSOCKET_WRITE)
+        how = SHUT_WR;
+    else
+        return;
+
+    if ((!(method & LIBSOCKET_READ) || (state & shut_rd_bit)) &&
+        (!(method & LIBSOCKET_WRITE) || (state & shut_wr_bit)))
+        return;
+
+    if (0 > ::shutdown(fd, how))
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "stream_handle::shutdown() - Could not shutdown socket");
+
+    if (method & LIBSOCKET_READ) state |= shut_rd_bit;
+    if (method & LIBSOCKET_WRITE) state |= shut_wr_bit;
+}
+
+/*
+ * Converts the address returned by getpeername()/getsockname() to strings.
+ */
+static void address_name(int fd, bool peer, string& host, string& port,
+                         bool numeric) {
+    char hostbuf[NI_MAXHOST], portbuf[NI_MAXSERV];
+    struct sockaddr_storage addr;
+    socklen_t len = sizeof(addr);
+    int ret;
+
+    if (0 > (peer ? getpeername(fd, reinterpret_cast<struct sockaddr*>(&addr),
+                                &len)
+                  : getsockname(fd, reinterpret_cast<struct sockaddr*>(&addr),
+                                &len)))
+        throw socket_exception(__FILE__, __LINE__,
+                               "stream_handle - Could not get address!");
+
+    if (addr.ss_family == AF_UNIX) {
+        const char* path =
+            reinterpret_cast<struct sockaddr_un*>(&addr)->sun_path;
+
+        host.assign(path,
+                    strnlen(path, len - offsetof(struct sockaddr_un, sun_path)));
+        port.clear();
+        return;
+    }
+
+    if (0 != (ret = getnameinfo(reinterpret_cast<struct sockaddr*>(&addr), len,
+                                hostbuf, sizeof(hostbuf), portbuf,
+                                sizeof(portbuf),
+                                numeric ? NI_NUMERICHOST | NI_NUMERICSERV
+                                        : 0)))
+        throw socket_exception(
+            __FILE__, __LINE__,
+            string("stream_handle - getnameinfo() failed: ") +
+                gai_strerror(ret),
+            false);
+
+    host = hostbuf;
+    port = portbuf;
+}
+
+/**
+ * @brief Look up the address of the peer.
+ *
+ * @param host Set to the peer's address, or the path for UNIX sockets
+ * @param port Set to the peer's port; empty for UNIX sockets
+ * @param numeric If false, host and port are resolved to names
+ */
+void stream_handle::getpeer(string& host, string& port, bool numeric) const {
+    address_name(fd, true, host, port, numeric);
+}
+
+/**
+ * @brief Look up the local address of the connection.
+ *
+ * See `getpeer()`.
+ */
+void stream_handle::getlocal(string& host, string& port, bool numeric) const {
+    address_name(fd, false, host, port, numeric);
+}
+
+/*
+ * Receives exactly `len` bytes. Returns false with `ec` set on errors and on
+ * EOF (ECONNRESET).
+ */
+bool stream_handle::recv_all(void* buf, size_t len, std::error_code& ec) {
+    char* p = static_cast<char*>(buf);
+
+    while (len > 0) {
+        ssize_t bytes = ::recv(fd, p, len, 0);
+
+        if (bytes < 0 && errno == EINTR) continue;
+
+        if (bytes <= 0) {
+            ec.assign(bytes < 0 ? errno : ECONNRESET, std::system_category());
+            return false;
+        }
+
+        p += bytes;
+        len -= bytes;
+    }
+
+    ec.clear();
+
+    return true;
+}
+
+/**
+ * @brief Receive data into a buffer from a `buffer_pool`; sets its size.
+ */
+ssize_t stream_handle::rcv(pooled_buffer& buf, int flags) {
+    ssize_t bytes = rcv(buf.data(), buf.capacity(), flags);
+
+    buf.resize(bytes > 0 ? bytes : 0);
+
+    return bytes;
+}
+
+/**
+ * @brief Receive one frame into a buffer from a `buffer_pool`.
+ *
+ * Bytes beyond `dst.capacity()` are discarded; the size of `dst` is set to
+ * the number of bytes stored.
+ */
+ssize_t stream_handle::rcvmsg(pooled_buffer& dst) {
+    ssize_t bytes = rcvmsg(dst.data(), dst.capacity());
+
+    dst.resize(bytes);
+
+    return bytes;
+}
+}  // namespace libsocket
+
+/**
+ * @}
+ */
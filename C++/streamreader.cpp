@@ -0,0 +1,334 @@
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <string>
+
+#if defined(__SSE2__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/*
+   The committers of the libsocket project, all rights reserved
+   (c) 2012, dermesser <lbo@spheniscida.de>
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS” AND ANY
+   EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+   DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+/**
+ * @file streamreader.cpp
+ * @brief Buffered, delimiter-based reading from stream sockets.
+ *
+ * 	stream_reader keeps the data received from a stream socket in
+ * 	one contiguous buffer and searches it for delimiters; found tokens
+ * 	are returned as views into that buffer.
+ *
+ * @addtogroup libsocketplusplus
+ * @{
+ */
+
+#include <exception.hpp>
+#include <streamreader.hpp>
+
+namespace libsocket {
+using std::string;
+
+/*
+ * Returns the offset of the first occurrence of `delim` in `hay` or `len` if
+ * there is none.
+ *
+ * The vectorized versions compare the first and the last byte of the
+ * delimiter at 16 (32) consecutive positions at once and only call memcmp()
+ * for the bytes in between if both match. For the usual "\r\n" that means no
+ * memcmp() at all.
+ */
+static size_t find_delimiter(const char* hay, size_t len, const char* delim,
+                             size_t delim_len) {
+    if (delim_len > len) return len;
+
+    if (delim_len == 1) {
+        const void* hit = memchr(hay, delim[0], len);
+        return hit ? static_cast<const char*>(hit) - hay : len;
+    }
+
+    // Last position at which the delimiter may start.
+    const size_t last = len - delim_len;
+    size_t pos = 0;
+
+#if defined(__AVX2__)
+    const __m256i first32 = _mm256_set1_epi8(delim[0]);
+    const __m256i final32 = _mm256_set1_epi8(delim[delim_len - 1]);
+
+    for (; pos + 32 <= last + 1; pos += 32) {
+        __m256i block_first = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(hay + pos));
+        __m256i block_final = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(hay + pos + delim_len - 1));
+        uint32_t mask = _mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(block_first, first32),
+                             _mm256_cmpeq_epi8(block_final, final32)));
+
+        while (mask != 0) {
+            size_t bit = __builtin_ctz(mask);
+
+            if (delim_len == 2 ||
+                0 == memcmp(hay + pos + bit + 1, delim + 1, delim_len - 2))
+                return pos + bit;
+
+            mask &= mask - 1;
+        }
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i first16 = _mm_set1_epi8(delim[0]);
+    const __m128i final16 = _mm_set1_epi8(delim[delim_len - 1]);
+
+    for (; pos + 16 <= last + 1; pos += 16) {
+        __m128i block_first =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(hay + pos));
+        __m128i block_final = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(hay + pos + delim_len - 1));
+        uint32_t mask = _mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(block_first, first16),
+                          _mm_cmpeq_epi8(block_final, final16)));
+
+        while (mask != 0) {
+            size_t bit = __builtin_ctz(mask);
+
+            if (delim_len == 2 ||
+                0 == memcmp(hay + pos + bit + 1, delim + 1, delim_len - 2))
+                return pos + bit;
+
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    // Scalar fallback and tail of the vectorized search.
+    while (pos <= last) {
+        const void* hit = memchr(hay + pos, delim[0], last - pos + 1);
+
+        if (hit == NULL) break;
+
+        pos = static_cast<const char*>(hit) - hay;
+
+        if (0 == memcmp(hay + pos + 1, delim + 1, delim_len - 1)) return pos;
+
+        pos++;
+    }
+
+    return len;
+}
+
+/**
+ * @brief Constructor.
+ *
+ * @param socket The socket to read from. It is not owned by the reader.
+ * @param initial_size Size of the buffer allocated on the first read.
+ * @param max_size The buffer is never grown beyond this size; a token longer
+ * than that makes `read_until()` throw.
+ */
+stream_reader::stream_reader(stream_client_socket& socket, size_t initial_size,
+                             size_t max_size)
+    : sock(socket),
+      capacity(initial_size > 0 ? initial_size : 1),
+      max_capacity(max_size < initial_size ? initial_size : max_size),
+      begin(0),
+      end(0),
+      scanned(0) {}
+
+/**
+ * @brief Receive data until `delim` is found.
+ *
+ * @param delim The delimiter; may be longer than one byte (e.g. "\r\n").
+ * @param delim_len Its length. Must not be 0.
+ * @param token Set to the data in front of the delimiter. The delimiter itself
+ * is not part of the view. The view is valid until the next call on this
+ * reader.
+ *
+ * @retval >0 Number of bytes consumed from the stream, i.e. `token->size +
+ * delim_len`.
+ * @retval 0 The peer closed the connection before sending the delimiter. Data
+ * received until then stays in the buffer and can be obtained with `read()`.
+ * @retval -1 Socket is non-blocking and the delimiter has not arrived yet.
+ * Call again once the socket is readable.
+ *
+ * Errors on the socket, and tokens longer than the maximum buffer size, make
+ * the function throw a `socket_exception`.
+ */
+ssize_t stream_reader::read_until(const char* delim, size_t delim_len,
+                                  buffer_view* token) {
+    if (delim == NULL || delim_len == 0 || token == NULL)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "stream_reader::read_until() - Delimiter or token is null!",
+            false);
+
+    // A search with another delimiter has to start over.
+    if (last_delim.size() != delim_len ||
+        0 != memcmp(last_delim.data(), delim, delim_len)) {
+        last_delim.assign(delim, delim_len);
+        scanned = 0;
+    }
+
+    while (true) {
+        if (buffer) {
+            const char* data = buffer.get() + begin;
+            size_t pos =
+                scanned + find_delimiter(data + scanned, end - begin - scanned,
+                                         delim, delim_len);
+
+            if (pos < end - begin) {
+                token->data = data;
+                token->size = pos;
+
+                begin += pos + delim_len;
+                scanned = 0;
+
+                return pos + delim_len;
+            }
+
+            // The last delim_len - 1 bytes may be the start of a delimiter.
+            if (end - begin >= delim_len) scanned = end - begin - delim_len + 1;
+        }
+
+        ssize_t recvd = fill();
+
+        if (recvd <= 0) return recvd;
+    }
+}
+
+/**
+ * @brief Receive data until `delim` is found.
+ *
+ * See `read_until(const char*, size_t, buffer_view*)`.
+ */
+ssize_t stream_reader::read_until(const string& delim, buffer_view* token) {
+    return read_until(delim.data(), delim.size(), token);
+}
+
+/**
+ * @brief Receive one line.
+ *
+ * Lines may be terminated by "\n" or "\r\n"; the terminator is not part of
+ * `line`. Return values are the same as for `read_until()`.
+ */
+ssize_t stream_reader::read_line(buffer_view* line) {
+    ssize_t consumed = read_until("\n", 1, line);
+
+    if (consumed > 0 && line->size > 0 && line->data[line->size - 1] == '\r')
+        line->size--;
+
+    return consumed;
+}
+
+/**
+ * @brief Read raw bytes, e.g. a message body after its header.
+ *
+ * Buffered bytes are returned first; if there are none, this reads from the
+ * socket directly without going through the buffer.
+ *
+ * @retval >0 Number of bytes placed in `dst`.
+ * @retval 0 End of stream.
+ * @retval -1 Socket is non-blocking and there is nothing to read.
+ */
+ssize_t stream_reader::read(void* dst, size_t len) {
+    if (dst == NULL || len == 0)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "stream_reader::read() - Buffer or length is null!", false);
+
+    if (begin < end) {
+        size_t n = len < end - begin ? len : end - begin;
+
+        memcpy(dst, buffer.get() + begin, n);
+        begin += n;
+        scanned = scanned > n ? scanned - n : 0;
+
+        return n;
+    }
+
+    return sock.rcv(dst, len);
+}
+
+// Receives as much as fits into the buffer, making room first if necessary.
+ssize_t stream_reader::fill(void) {
+    if (sock.shut_rd == true)
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "stream_reader::fill() - Socket has already been shut down!",
+            false);
+    if (sock.sfd == -1)
+        throw socket_exception(__FILE__, __LINE__,
+                               "stream_reader::fill() - Socket not connected!",
+                               false);
+
+    if (!buffer) buffer.reset(new char[capacity]);
+
+    if (begin == end) begin = end = 0;
+
+    // Move the unread rest to the front once less than a quarter of the buffer
+    // is left behind it; grow only if that does not free anything.
+    if (capacity - end < capacity / 4 + 1 && begin > 0) {
+        memmove(buffer.get(), buffer.get() + begin, end - begin);
+        end -= begin;
+        begin = 0;
+    } else if (end == capacity) {
+        if (capacity >= max_capacity)
+            throw socket_exception(__FILE__, __LINE__,
+                                   "stream_reader::fill() - Token exceeds the "
+                                   "maximum buffer size!",
+                                   false);
+
+        size_t new_capacity =
+            capacity * 2 < max_capacity ? capacity * 2 : max_capacity;
+        std::unique_ptr<char[]> new_buffer(new char[new_capacity]);
+
+        memcpy(new_buffer.get(), buffer.get() + begin, end - begin);
+        end -= begin;
+        begin = 0;
+
+        buffer = std::move(new_buffer);
+        capacity = new_capacity;
+    }
+
+    ssize_t recvd = ::recv(sock.sfd, buffer.get() + end, capacity - end, 0);
+
+    if (recvd < 0) {
+        if (sock.is_nonblocking && errno == EWOULDBLOCK)
+            return -1;
+        else
+            throw socket_exception(
+                __FILE__, __LINE__,
+                "stream_reader::fill() - Error while reading!");
+    }
+
+    end += recvd;
+
+    return recvd;
+}
+}  // namespace libsocket
+
+/**
+ * @}
+ */
@@ -0,0 +1,195 @@
+#include <stdint.h>
+#include <time.h>
+#include <functional>
+#include <vector>
+
+/*
+   The committers of the libsocket project, all rights reserved
+   (c) 2012, dermesser <lbo@spheniscida.de>
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS” AND ANY
+   EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+   DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+/**
+ * @file timerwheel.cpp
+ * @brief Hashed timer wheel.
+ *
+ * 	Every slot is a vector of (key, deadline) pairs. Scheduling appends
+ * 	to the slot of the deadline's tick; expiring walks the slots of the
+ * 	ticks that have passed and takes out the entries that are due.
+ *
+ * @addtogroup libsocketplusplus
+ * @{
+ */
+
+#include <timerwheel.hpp>
+
+namespace libsocket {
+
+/**
+ * @brief Constructor.
+ *
+ * @param n Number of slots. Timers up to `n * res` microseconds in the future
+ * are found without looking at other timers.
+ * @param res Length of one tick in microseconds; timers fire up to one tick
+ * late.
+ */
+timer_wheel::timer_wheel(size_t n, uint64_t res)
+    : slots(n > 0 ? n : 1),
+      tick(res > 0 ? res : 1),
+      current(now() / tick),
+      pending(0) {}
+
+/**
+ * @brief Current time of `CLOCK_MONOTONIC` in microseconds.
+ */
+uint64_t timer_wheel::now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return uint64_t(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * @brief Let `key` fire at `deadline` (microseconds, see `now()`).
+ *
+ * A key may be scheduled several times; it then fires several times.
+ * Deadlines in the past fire on the next call to `expire()`.
+ */
+void timer_wheel::schedule(uint64_t key, uint64_t deadline) {
+    uint64_t t = deadline / tick;
+
+    if (t < current) t = current;
+
+    entry e = {key, deadline};
+
+    slots[t % slots.size()].push_back(e);
+    pending++;
+}
+
+/**
+ * @brief Fire all timers whose deadline is not after `now`.
+ *
+ * `fire` is called with each key; it may schedule new timers, but must not
+ * call `expire()`.
+ *
+ * @returns The number of timers fired.
+ */
+size_t timer_wheel::expire(uint64_t now,
+                           const std::function<void(uint64_t)>& fire) {
+    const uint64_t last = now / tick;
+
+    if (pending == 0 || last < current) {
+        if (last > current) current = last;
+        return 0;
+    }
+
+    // After a long pause, every slot has to be looked at once.
+    const uint64_t ticks =
+        last - current + 1 < slots.size() ? last - current + 1 : slots.size();
+
+    for (uint64_t t = current; t < current + ticks; t++) {
+        std::vector<entry>& slot = slots[t % slots.size()];
+
+        for (size_t i = 0; i < slot.size();) {
+            if (slot[i].deadline <= now) {
+                due.push_back(slot[i]);
+                slot[i] = slot.back();
+                slot.pop_back();
+            } else
+                i++;
+        }
+    }
+
+    // Timers due later during the last tick are still in its slot.
+    current = last;
+    pending -= due.size();
+
+    size_t fired = due.size();
+
+    for (size_t i = 0; i < fired; i++) fire(due[i].key);
+
+    due.clear();
+
+    return fired;
+}
+
+/**
+ * @brief Find the earliest deadline.
+ *
+ * @returns false if there are no timers.
+ */
+bool timer_wheel::next_deadline(uint64_t* deadline) const {
+    if (pending == 0) return false;
+
+    // Usually, the first non-empty slot holds the answer...
+    for (uint64_t t = current; t < current + slots.size(); t++) {
+        const std::vector<entry>& slot = slots[t % slots.size()];
+        bool found = false;
+
+        for (size_t i = 0; i < slot.size(); i++) {
+            if (slot[i].deadline / tick <= t &&
+                (!found || slot[i].deadline < *deadline)) {
+                *deadline = slot[i].deadline;
+                found = true;
+            }
+        }
+
+        if (found) return true;
+    }
+
+    // ...unless all timers are more than one turn ahead.
+    bool found = false;
+
+    for (size_t s = 0; s < slots.size(); s++)
+        for (size_t i = 0; i < slots[s].size(); i++)
+            if (!found || slots[s][i].deadline < *deadline) {
+                *deadline = slots[s][i].deadline;
+                found = true;
+            }
+
+    return found;
+}
+
+/**
+ * @brief Milliseconds until the next timer is due, rounded up; suitable as
+ * timeout for `epollset::wait()` or `poll(2)`.
+ *
+ * @retval -1 There are no timers.
+ * @retval 0 A timer is already due.
+ */
+int timer_wheel::timeout_ms(uint64_t now) const {
+    uint64_t deadline;
+
+    if (!next_deadline(&deadline)) return -1;
+    if (deadline <= now) return 0;
+
+    uint64_t ms = (deadline - now + 999) / 1000;
+
+    return ms > 0x7fffffff ? 0x7fffffff : int(ms);
+}
+}  // namespace libsocket
+
+/**
+ * @}
+ */
@@ -1,3 +1,5 @@
+#include <string.h>
+#include <sys/un.h>
 #include <string>
 
 using std::string;
@@ -149,6 +151,49 @@ void unix_dgram_client::connect(const char* path) {
  */
 void unix_dgram_client::connect(const string& path) { connect(path.c_str()); }
 
+/**
+ * @brief Connect a UNIX datagram socket, without throwing
+ *
+ * Works like `connect()`, but reports errors in `ec` instead of throwing.
+ *
+ * @param path The path of the socket to connect this socket to.
+ * @param ec Set to the error, or cleared.
+ */
+void unix_dgram_client::connect(const char* path, std::error_code& ec) {
+    if (sfd == -1) {
+        ec.assign(EBADF, std::system_category());
+        return;
+    }
+    if (path == NULL) {
+        ec.assign(EINVAL, std::system_category());
+        return;
+    }
+    if (strlen(path) > sizeof(((struct sockaddr_un*)0)->sun_path) - 1) {
+        ec.assign(ENAMETOOLONG, std::system_category());
+        return;
+    }
+
+    if (connect_unix_dgram_socket(sfd, path) < 0) {
+        ec.assign(errno, std::system_category());
+        return;
+    }
+
+    _path.assign(path);
+
+    connected = true;
+
+    ec.clear();
+}
+
+/**
+ * @brief Connect a UNIX datagram socket, without throwing
+ *
+ * See above.
+ */
+void unix_dgram_client::connect(const string& path, std::error_code& ec) {
+    connect(path.c_str(), ec);
+}
+
 /**
  * @brief Disconnect a UNIX datagram socket
  *
@@ -165,4 +210,33 @@ void unix_dgram_client::deconnect(void) {
 
     connected = false;
 }
+
+#if LIBSOCKET_HAVE_STRING_VIEW
+/**
+ * @brief Create and connect a UNIX datagram socket
+ *
+ * Like the `const char*` constructor; `path` need not be null-terminated.
+ */
+unix_dgram_client::unix_dgram_client(std::string_view path, int flags) {
+    setup(c_string<>(path).c_str(), flags);
+}
+
+/**
+ * @brief Connect the socket
+ *
+ * Like `connect(const char*)`.
+ */
+void unix_dgram_client::connect(std::string_view path) {
+    connect(c_string<>(path).c_str());
+}
+
+/**
+ * @brief Connect the socket, without throwing
+ *
+ * See above.
+ */
+void unix_dgram_client::connect(std::string_view path, std::error_code& ec) {
+    connect(c_string<>(path).c_str(), ec);
+}
+#endif
 }  // namespace libsocket
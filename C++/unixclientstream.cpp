@@ -3,6 +3,7 @@
 
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/un.h>
 #include <unistd.h>
 
 /*
@@ -46,6 +47,11 @@
 #include <exception.hpp>
 #include <unixclientstream.hpp>
 
+#include <fcntl.h>
+#ifndef SOCK_NONBLOCK
+#define SOCK_NONBLOCK O_NONBLOCK
+#endif
+
 namespace libsocket {
 using std::string;
 
@@ -101,6 +107,8 @@ void unix_stream_client::connect(const char* path, int socket_flags) {
                                "unix_stream_client::unix_stream_client: Could "
                                "not create and connect UNIX socket!");
 
+    is_nonblocking = socket_flags & SOCK_NONBLOCK;
+
     // New file descriptor, therefore reset shutdown flags
     shut_rd = false;
     shut_wr = false;
@@ -117,4 +125,85 @@ void unix_stream_client::connect(const char* path, int socket_flags) {
 void unix_stream_client::connect(const string& path, int socket_flags) {
     connect(path.c_str(), socket_flags);
 }
+
+/**
+ * @brief Connect socket, without throwing
+ *
+ * Works like `connect()`, but reports errors in `ec` instead of throwing.
+ *
+ * @param path The server socket's path
+ * @param ec Set to the error, or cleared.
+ * @param socket_flags Flags for `socket(2)`
+ */
+void unix_stream_client::connect(const char* path, std::error_code& ec,
+                                 int socket_flags) {
+    if (sfd != -1) {
+        ec.assign(EISCONN, std::system_category());
+        return;
+    }
+    if (path == NULL) {
+        ec.assign(EINVAL, std::system_category());
+        return;
+    }
+    if (strlen(path) > sizeof(((struct sockaddr_un*)0)->sun_path) - 1) {
+        ec.assign(ENAMETOOLONG, std::system_category());
+        return;
+    }
+
+    if (0 > (sfd = create_unix_stream_socket(path, socket_flags))) {
+        ec.assign(errno, std::system_category());
+        sfd = -1;
+        return;
+    }
+
+    _path.assign(path);
+
+    is_nonblocking = socket_flags & SOCK_NONBLOCK;
+
+    shut_rd = false;
+    shut_wr = false;
+
+    ec.clear();
+}
+
+/**
+ * @brief Connect socket, without throwing
+ *
+ * See above.
+ */
+void unix_stream_client::connect(const string& path, std::error_code& ec,
+                                 int socket_flags) {
+    connect(path.c_str(), ec, socket_flags);
+}
+
+#if LIBSOCKET_HAVE_STRING_VIEW
+/**
+ * @brief Create and connect a UNIX stream socket
+ *
+ * Like the `const char*` constructor; `path` need not be null-terminated.
+ */
+unix_stream_client::unix_stream_client(std::string_view path,
+                                       int socket_flags) {
+    connect(path, socket_flags);
+}
+
+/**
+ * @brief Connect the socket
+ *
+ * Like `connect(const char*, int)`.
+ */
+void unix_stream_client::connect(std::string_view path, int socket_flags) {
+    connect(c_string<>(path).c_str(), socket_flags);
+}
+
+/**
+ * @brief Connect the socket, without throwing
+ *
+ * See above.
+ */
+void unix_stream_client::connect(std::string_view path, std::error_code& ec,
+                                 int socket_flags) {
+    connect(c_string<>(path).c_str(), ec, socket_flags);
+}
+#endif
 }  // namespace libsocket
@@ -4,6 +4,8 @@
 
 #include <memory>
 
+#include <sys/un.h>
+
 /*
    The committers of the libsocket project, all rights reserved
    (c) 2012, dermesser <lbo@spheniscida.de>
@@ -42,6 +44,7 @@
 
 #include <libunixsocket.h>
 #include <exception.hpp>
+#include <bufferpool.hpp>
 #include <unixdgram.hpp>
 
 namespace libsocket {
@@ -245,4 +248,160 @@ ssize_t unix_dgram::rcvfrom(string& buf, string& source, int recvfrom_flags) {
 
     return bytes;
 }
+
+/**
+ * @brief Send data to datagram socket, without throwing
+ *
+ * Works like `sndto()`, but reports errors in `ec` instead of throwing.
+ *
+ * @param buf Pointer to data.
+ * @param length Length of `buf`
+ * @param path Path of destination
+ * @param ec Set to the error, or cleared.
+ * @param sendto_flags Flags for `sendto(2)`
+ *
+ * @returns How many bytes were sent, or -1 on error (also if the socket is
+ * non-blocking and its send buffer is full).
+ */
+ssize_t unix_dgram::sndto(const void* buf, size_t length, const char* path,
+                          std::error_code& ec, int sendto_flags) {
+    ssize_t bytes;
+
+    if (buf == NULL || path == NULL) {
+        ec.assign(EINVAL, std::system_category());
+        return -1;
+    }
+    if (strlen(path) > sizeof(((struct sockaddr_un*)0)->sun_path) - 1) {
+        ec.assign(ENAMETOOLONG, std::system_category());
+        return -1;
+    }
+
+    if (0 > (bytes = sendto_unix_dgram_socket(sfd, buf, length, path,
+                                              sendto_flags)))
+        ec.assign(errno, std::system_category());
+    else
+        ec.clear();
+
+    return bytes;
+}
+
+/**
+ * @brief Send data to datagram socket, without throwing
+ *
+ * See above.
+ */
+ssize_t unix_dgram::sndto(const void* buf, size_t length, const string& path,
+                          std::error_code& ec, int sendto_flags) {
+    return sndto(buf, length, path.c_str(), ec, sendto_flags);
+}
+
+/**
+ * @brief Receive data and store the sender's address, without throwing
+ *
+ * Works like `rcvfrom()`, but reports errors in `ec` instead of throwing.
+ *
+ * @param buf Receive buffer
+ * @param length Length of `buf`
+ * @param source Buffer for sender's path
+ * @param source_len `source`'s length
+ * @param ec Set to the error, or cleared.
+ * @param recvfrom_flags Flags for `recvfrom(2)`
+ *
+ * @returns How many bytes were received, or -1 on error (also if the socket is
+ * non-blocking and there was no datagram).
+ */
+ssize_t unix_dgram::rcvfrom(void* buf, size_t length, char* source,
+                            size_t source_len, std::error_code& ec,
+                            int recvfrom_flags) {
+    ssize_t bytes;
+
+    if (buf == NULL) {
+        ec.assign(EINVAL, std::system_category());
+        return -1;
+    }
+
+    if (0 > (bytes = recvfrom_unix_dgram_socket(sfd, buf, length, source,
+                                                source_len, recvfrom_flags)))
+        ec.assign(errno, std::system_category());
+    else
+        ec.clear();
+
+    return bytes;
+}
+
+/**
+ * @brief Receive data and store the sender's address, without throwing
+ *
+ * See above.
+ */
+ssize_t unix_dgram::rcvfrom(void* buf, size_t length, string& source,
+                            std::error_code& ec, int recvfrom_flags) {
+    char path[sizeof(((struct sockaddr_un*)0)->sun_path) + 1];
+    ssize_t bytes;
+
+    memset(path, 0, sizeof(path));
+
+    bytes = rcvfrom(buf, length, path, sizeof(path) - 1, ec, recvfrom_flags);
+
+    if (bytes >= 0) source.assign(path);
+
+    return bytes;
+}
+
+#if LIBSOCKET_HAVE_STRING_VIEW
+/**
+ * @brief Send a datagram to a socket
+ *
+ * Like `sndto(const void*, size_t, const char*, int)`; `path` need not be
+ * null-terminated.
+ */
+ssize_t unix_dgram::sndto(const void* buf, size_t length,
+                          std::string_view path, int sendto_flags) {
+    return sndto(buf, length, c_string<>(path).c_str(), sendto_flags);
+}
+
+/**
+ * @brief Send a datagram to a socket
+ *
+ * `buf` may be any contiguous container of bytes (see `byte_span`).
+ */
+ssize_t unix_dgram::sndto(byte_span buf, std::string_view path,
+                          int sendto_flags) {
+    return sndto(buf.data(), buf.size(), path, sendto_flags);
+}
+
+/**
+ * @brief Send a datagram to a socket, without throwing
+ *
+ * See above.
+ */
+ssize_t unix_dgram::sndto(const void* buf, size_t length,
+                          std::string_view path, std::error_code& ec,
+                          int sendto_flags) {
+    return sndto(buf, length, c_string<>(path).c_str(), ec, sendto_flags);
+}
+#endif
+
+/**
+ * @brief Receive a datagram into a buffer from a `buffer_pool`
+ *
+ * Like `rcvfrom(void*, size_t, string&, int)`; sets the size of `buf` to the
+ * number of bytes received. Longer datagrams are truncated to
+ * `buf.capacity()`.
+ */
+ssize_t unix_dgram::rcvfrom(pooled_buffer& buf, string& source,
+                            int recvfrom_flags) {
+    char path[sizeof(((struct sockaddr_un*)0)->sun_path) + 1];
+
+    memset(path, 0, sizeof(path));
+
+    ssize_t bytes = rcvfrom(buf.data(), buf.capacity(), path, sizeof(path) - 1,
+                            recvfrom_flags);
+
+    buf.resize(bytes > 0 ? bytes : 0);
+
+    if (bytes >= 0) source.assign(path);
+
+    return bytes;
+}
 }  // namespace libsocket
@@ -115,4 +115,25 @@ void unix_dgram_server::setup(const char* bindpath, int socket_flags) {
 void unix_dgram_server::setup(const string& bindpath, int socket_flags) {
     setup(bindpath.c_str(), socket_flags);
 }
+
+#if LIBSOCKET_HAVE_STRING_VIEW
+/**
+ * @brief Create a bound UNIX datagram socket
+ *
+ * Like the `const char*` constructor; `bindpath` need not be null-terminated.
+ */
+unix_dgram_server::unix_dgram_server(std::string_view bindpath,
+                                     int socket_flags) {
+    setup(c_string<>(bindpath).c_str(), socket_flags);
+}
+
+/**
+ * @brief Bind the socket
+ *
+ * Like `setup(const char*, int)`.
+ */
+void unix_dgram_server::setup(std::string_view bindpath, int socket_flags) {
+    setup(c_string<>(bindpath).c_str(), socket_flags);
+}
+#endif
 }  // namespace libsocket
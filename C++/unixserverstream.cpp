@@ -40,6 +40,11 @@
 #include <exception.hpp>
 #include <unixserverstream.hpp>
 
+#include <fcntl.h>
+#ifndef SOCK_NONBLOCK
+#define SOCK_NONBLOCK O_NONBLOCK
+#endif
+
 namespace libsocket {
 using std::string;
 
@@ -143,7 +148,74 @@ unique_ptr<unix_stream_client> unix_stream_server::accept2(int flags) {
     }
 
     client->sfd = cfd;
+    client->is_nonblocking = flags & SOCK_NONBLOCK;
 
     return client;
 }
+
+/**
+ * @brief Accepts an incoming connection, without throwing
+ *
+ * Works like `accept()`, but reports errors in `ec` instead of throwing.
+ *
+ * @param ec Set to the error, or cleared.
+ * @param flags Flags for `accept4()`; useless on other implementations.
+ *
+ * @returns The client socket, or NULL on error (also if the socket is
+ * non-blocking and no client is waiting).
+ */
+unix_stream_client* unix_stream_server::accept(std::error_code& ec,
+                                               int flags) {
+    return accept2(ec, flags).release();
+}
+
+/**
+ * @brief Accepts an incoming connection and returns an owned pointer, without
+ * throwing
+ *
+ * See above.
+ */
+unique_ptr<unix_stream_client> unix_stream_server::accept2(std::error_code& ec,
+                                                           int flags) {
+    int cfd;
+
+    if (sfd == -1) {
+        ec.assign(EINVAL, std::system_category());
+        return nullptr;
+    }
+
+    if (0 > (cfd = accept_unix_stream_socket(sfd, flags))) {
+        ec.assign(errno, std::system_category());
+        return nullptr;
+    }
+
+    unique_ptr<unix_stream_client> client(new unix_stream_client);
+
+    client->sfd = cfd;
+    client->is_nonblocking = flags & SOCK_NONBLOCK;
+
+    ec.clear();
+
+    return client;
+}
+
+#if LIBSOCKET_HAVE_STRING_VIEW
+/**
+ * @brief Create a UNIX stream server socket
+ *
+ * Like the `const char*` constructor; `path` need not be null-terminated.
+ */
+unix_stream_server::unix_stream_server(std::string_view path, int flags) {
+    setup(path, flags);
+}
+
+/**
+ * @brief Set up a UNIX stream server socket
+ *
+ * Like `setup(const char*, int)`.
+ */
+void unix_stream_server::setup(std::string_view path, int flags) {
+    setup(c_string<>(path).c_str(), flags);
+}
+#endif
 }  // namespace libsocket
@@ -0,0 +1,540 @@
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <new>
+#include <string>
+
+/*
+   The committers of the libsocket project, all rights reserved
+   (c) 2012, dermesser <lbo@spheniscida.de>
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS” AND ANY
+   EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+   DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+/**
+ * @file writequeue.cpp
+ * @brief A queue of outgoing data for a stream socket written by many threads.
+ *
+ * 	Writers push onto a lock-free stack; one thread at a time (the flusher)
+ * 	takes the stack, reverses it and sends the buffers with writev(2).
+ *
+ * @addtogroup libsocketplusplus
+ * @{
+ */
+
+#include <conf.h>
+
+#include <bufferpool.hpp>
+#include <exception.hpp>
+#include <writequeue.hpp>
+
+namespace libsocket {
+using std::string;
+
+/**
+ * @brief One buffer in a write_queue.
+ *
+ * Copied data is stored right behind the node, so a copying `write()` costs a
+ * single allocation.
+ */
+struct write_queue_node {
+    write_queue_node* next;
+    const char* data;  ///< First byte not sent yet
+    size_t size;       ///< Bytes not sent yet
+    string owned;
+    pooled_buffer pooled;
+};
+
+/// Buffers passed to one writev(2) call at most.
+static const int max_iov = 128;
+
+static write_queue_node* new_node(size_t inline_bytes) {
+    void* mem = ::operator new(sizeof(write_queue_node) + inline_bytes);
+    write_queue_node* node = new (mem) write_queue_node;
+
+    node->next = nullptr;
+    node->data = reinterpret_cast<const char*>(node + 1);
+    node->size = inline_bytes;
+
+    return node;
+}
+
+static void delete_node(write_queue_node* node) {
+    node->~write_queue_node();
+    ::operator delete(node);
+}
+
+static void delete_list(write_queue_node* node) {
+    while (node != nullptr) {
+        write_queue_node* next = node->next;
+        delete_node(node);
+        node = next;
+    }
+}
+
+/**
+ * @brief Create a queue for `sock`.
+ *
+ * The socket may be blocking or non-blocking; see the class documentation.
+ */
+write_queue::write_queue(stream_client_socket& s)
+    : sock(s),
+      incoming(nullptr),
+      flushing(false),
+      blocked(false),
+      error(0),
+      bytes(0),
+      full(false),
+      high_mark(0),
+      low_mark(0),
+      head(nullptr),
+      tail(nullptr),
+      armed(false) {}
+
+write_queue::~write_queue(void) {
+    delete_list(incoming.load());
+    delete_list(head);
+}
+
+/**
+ * @brief Send `data`, or queue a copy of it if it cannot be sent right away.
+ *
+ * If the queue is empty and no other thread is flushing, `data` is sent
+ * directly and only what the socket did not take is copied. Otherwise it is
+ * queued, and sent now if no other thread is flushing. Returns without
+ * waiting if another thread is flushing, or if the send buffer of a
+ * non-blocking socket is full.
+ *
+ * @returns `false` if the queue is above its high watermark; the producer
+ * should pause until the resume callback is called. Always `true` without
+ * watermarks.
+ */
+bool write_queue::write(byte_span data) {
+    if (data.size() == 0) return !full.load();
+
+    size_t sent;
+
+    if (send_direct(data.data(), data.size(), sent)) {
+        write_queue_node* node = nullptr;
+
+        if (sent < data.size()) {
+            node = new_node(data.size() - sent);
+            memcpy(const_cast<char*>(node->data),
+                   static_cast<const char*>(data.data()) + sent, node->size);
+        }
+
+        finish_direct(node);
+        return !full.load();
+    }
+
+    write_queue_node* node = new_node(data.size());
+    memcpy(const_cast<char*>(node->data), data.data(), data.size());
+
+    push(node);
+
+    return !full.load();
+}
+
+/**
+ * @brief Send `data`, or queue it without copying; see `write(byte_span)`.
+ */
+bool write_queue::write(string&& data) {
+    if (data.empty()) return !full.load();
+
+    size_t sent = 0;
+    bool direct = send_direct(data.data(), data.size(), sent);
+
+    write_queue_node* node = nullptr;
+
+    if (sent < data.size()) {
+        node = new_node(0);
+        node->owned = std::move(data);
+        node->data = node->owned.data() + sent;
+        node->size = node->owned.size() - sent;
+    }
+
+    if (direct)
+        finish_direct(node);
+    else
+        push(node);
+
+    return !full.load();
+}
+
+/**
+ * @brief Send the valid bytes of a pooled buffer, or queue them without
+ * copying; see `write(byte_span)`.
+ *
+ * The queue keeps a reference to the buffer until it has been sent; do not
+ * modify it before.
+ */
+bool write_queue::write(const pooled_buffer& buf) {
+    if (!buf || buf.empty()) return !full.load();
+
+    size_t sent = 0;
+    bool direct = send_direct(buf.data(), buf.size(), sent);
+
+    write_queue_node* node = nullptr;
+
+    if (sent < buf.size()) {
+        node = new_node(0);
+        node->pooled = buf;
+        node->data = buf.data() + sent;
+        node->size = buf.size() - sent;
+    }
+
+    if (direct)
+        finish_direct(node);
+    else
+        push(node);
+
+    return !full.load();
+}
+
+/**
+ * @brief Send what is queued, unless another thread is doing so already.
+ *
+ * Call this when the event loop reports the socket as writable, or, without
+ * `watch()`, when a non-blocking socket can take more data.
+ */
+void write_queue::flush(void) {
+    blocked.store(false);
+
+    kick();
+
+    int err = error.load();
+
+    if (err != 0) {
+        errno = err;
+        throw socket_exception(__FILE__, __LINE__,
+                               "write_queue::flush() - Could not send data!");
+    }
+}
+
+/**
+ * @brief Bound the queue.
+ *
+ * Call this before the queue is used by several threads.
+ *
+ * @param high `write()` returns `false` while more than `high` bytes are
+ * queued. 0 disables the watermarks.
+ * @param low The resume callback is called when the queue has drained to
+ * `low` bytes after crossing `high`.
+ * @param kernel_unsent If not 0, `TCP_NOTSENT_LOWAT` is set to this value on
+ * the socket, so that no more than about this much unsent data waits in the
+ * kernel. Only for TCP sockets.
+ */
+void write_queue::set_watermarks(size_t high, size_t low,
+                                 unsigned int kernel_unsent) {
+    if (low > high)
+        throw socket_exception(__FILE__, __LINE__,
+                               "write_queue::set_watermarks() - Low watermark "
+                               "is above high watermark!",
+                               false);
+
+    if (kernel_unsent > 0) sock.set_notsent_lowat(kernel_unsent);
+
+    high_mark = high;
+    low_mark = low;
+}
+
+/**
+ * @brief Set the function called when a paused queue has drained to the low
+ * watermark.
+ *
+ * It runs in the thread that sent the data, usually the flusher (e.g. the
+ * event loop calling `flush()`), and may call `write()`. Call this before the
+ * queue is used by several threads.
+ */
+void write_queue::on_resume(const std::function<void(void)>& callback) {
+    resume = callback;
+}
+
+void write_queue::push(write_queue_node* node) {
+    int err = error.load();
+
+    if (err != 0) {
+        delete_node(node);
+        errno = err;
+        throw socket_exception(
+            __FILE__, __LINE__,
+            "write_queue::write() - Sending has failed before!");
+    }
+
+    added(node->size);
+
+    node->next = incoming.load(std::memory_order_relaxed);
+    while (!incoming.compare_exchange_weak(node->next, node))
+        ;
+
+    kick();
+    check_error();
+}
+
+/**
+ * @brief Become the flusher if the queue is empty and idle, and send `len`
+ * bytes directly.
+ *
+ * @param sent Set to the number of bytes the socket took.
+ *
+ * @returns `true` if this thread is the flusher now; `finish_direct()` must
+ * be called then. `false` if the data has to be queued.
+ */
+bool write_queue::send_direct(const void* data, size_t len, size_t& sent) {
+    if (blocked.load() || incoming.load() != nullptr) return false;
+
+    bool expected = false;
+
+    if (!flushing.compare_exchange_strong(expected, true)) return false;
+
+    if (head != nullptr || blocked.load() || error.load() != 0) {
+        // Queued data has to go first; let push() deal with it.
+        flushing.store(false);
+        return false;
+    }
+
+    ssize_t n;
+
+    do
+        n = ::send(sock.getfd(), data, len, 0);
+    while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) error.store(errno);
+        n = 0;
+    }
+
+    sent = n;
+
+    return true;
+}
+
+/**
+ * @brief Queue what `send_direct()` could not send, flush anything written by
+ * other threads in the meantime and give up the flusher role.
+ */
+void write_queue::finish_direct(write_queue_node* rest) {
+    if (rest != nullptr) {
+        added(rest->size);
+        head = tail = rest;
+    }
+
+    if (rest != nullptr || incoming.load() != nullptr) {
+        try {
+            drain();
+        } catch (...) {
+            flushing.store(false);
+            throw;
+        }
+    }
+
+    flushing.store(false);
+
+    if (incoming.load() != nullptr) kick();
+
+    check_error();
+}
+
+void write_queue::added(size_t n) {
+    size_t now = bytes.fetch_add(n) + n;
+
+    if (high_mark == 0 || now <= high_mark || full.load()) return;
+
+    full.store(true);
+
+    // The flusher may have drained the queue before it could see `full`.
+    if (bytes.load() <= low_mark) resumed();
+}
+
+void write_queue::removed(size_t n) {
+    size_t now = bytes.fetch_sub(n) - n;
+
+    if (now <= low_mark && full.load()) resumed();
+}
+
+void write_queue::resumed(void) {
+    bool expected = true;
+
+    if (full.compare_exchange_strong(expected, false) && resume) resume();
+}
+
+void write_queue::check_error(void) {
+    int err = error.load();
+
+    if (err != 0) {
+        errno = err;
+        throw socket_exception(__FILE__, __LINE__,
+                               "write_queue::write() - Could not send data!");
+    }
+}
+
+/**
+ * @brief Become the flusher and drain the queue, if nobody else is.
+ *
+ * A writer that finds a flusher leaves its buffer to it. The flusher looks at
+ * `incoming` again after giving up the role, so a buffer pushed just before
+ * is not left behind.
+ */
+void write_queue::kick(void) {
+    while (!blocked.load()) {
+        bool expected = false;
+
+        if (!flushing.compare_exchange_strong(expected, true)) return;
+
+        try {
+            drain();
+        } catch (...) {
+            flushing.store(false);
+            throw;
+        }
+
+        flushing.store(false);
+
+        if (incoming.load() == nullptr) return;
+    }
+}
+
+void write_queue::drain(void) {
+    struct iovec iov[max_iov];
+
+    for (;;) {
+        take_incoming();
+
+        if (head == nullptr) break;
+
+        if (error.load() != 0) {
+            drop_all();
+            continue;
+        }
+
+        int n = 0;
+        for (write_queue_node* node = head; node != nullptr && n < max_iov;
+             node = node->next, n++) {
+            iov[n].iov_base = const_cast<char*>(node->data);
+            iov[n].iov_len = node->size;
+        }
+
+        ssize_t sent;
+
+        if (n == 1)
+            sent = ::send(sock.getfd(), iov[0].iov_base, iov[0].iov_len, 0);
+        else
+            sent = ::writev(sock.getfd(), iov, n);
+
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                blocked.store(true);
+                set_armed(true);
+                return;
+            }
+
+            error.store(errno);
+            drop_all();
+            continue;
+        }
+
+        consume(sent);
+    }
+
+    set_armed(false);
+}
+
+/**
+ * @brief Move the buffers pushed by writers to the end of the flusher's list,
+ * restoring the order in which they were pushed.
+ */
+void write_queue::take_incoming(void) {
+    write_queue_node* list = incoming.exchange(nullptr);
+    write_queue_node* reversed = nullptr;
+    write_queue_node* last = list;
+
+    while (list != nullptr) {
+        write_queue_node* next = list->next;
+        list->next = reversed;
+        reversed = list;
+        list = next;
+    }
+
+    if (reversed == nullptr) return;
+
+    if (tail != nullptr)
+        tail->next = reversed;
+    else
+        head = reversed;
+
+    tail = last;
+}
+
+/**
+ * @brief Remove `n` sent bytes from the front of the flusher's list.
+ */
+void write_queue::consume(size_t n) {
+    removed(n);
+
+    while (n > 0) {
+        if (n < head->size) {
+            head->data += n;
+            head->size -= n;
+            return;
+        }
+
+        n -= head->size;
+
+        write_queue_node* next = head->next;
+        delete_node(head);
+        head = next;
+    }
+
+    if (head == nullptr) tail = nullptr;
+}
+
+void write_queue::drop_all(void) {
+    size_t dropped = 0;
+
+    for (write_queue_node* node = head; node != nullptr; node = node->next)
+        dropped += node->size;
+
+    removed(dropped);
+
+    delete_list(head);
+    head = tail = nullptr;
+
+    set_armed(false);
+}
+
+void write_queue::set_armed(bool on) {
+    if (!arm || on == armed) return;
+
+    arm(on);
+    armed = on;
+}
+
+}  // namespace libsocket
+
+/**
+ * @}
+ */
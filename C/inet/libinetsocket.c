@@ -20,7 +20,13 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/ioctl.h>
+#if LIBSOCKET_LINUX
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/sendfile.h>
+#endif
 #include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>  // read()/write()
 
@@ -642,6 +648,156 @@ int shutdown_inet_stream_socket(int sfd, int method) {
     return 0;
 }
 
+#if LIBSOCKET_LINUX
+/*
+ * Moves `count` bytes from `fd` to `sfd` with splice(2). Used if sendfile(2)
+ * does not support `fd` as source (e.g. if `fd` is a pipe or a socket).
+ *
+ * A pipe is spliced to the socket directly. Anything else goes through an
+ * intermediate pipe: if an offset is given, bytes that were moved into the
+ * pipe but could not be written to the socket are simply read again on the
+ * next call. Without an offset (a socket) they can't be read again, so in
+ * that case the bytes already in the pipe are written even if the socket is
+ * non-blocking; no more are read from `fd` afterwards.
+ */
+static ssize_t splice_to_socket(int sfd, int fd, off_t *offset, size_t count) {
+    int pipefd[2], errno_saved, failed = 0, draining = 0;
+    size_t sent = 0;
+    ssize_t in_pipe = 0, out;
+    off_t pos = offset != NULL ? *offset : 0;
+    struct stat st;
+
+    if (fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode)) {
+        while (sent < count) {
+            out = splice(fd, NULL, sfd, NULL, count - sent,
+                         SPLICE_F_MOVE | SPLICE_F_MORE);
+
+            if (out == 0) break;  // EOF on fd
+
+            if (out < 0) {
+                if (errno == EINTR) continue;
+                if (sent == 0) return -1;
+                break;
+            }
+
+            sent += out;
+        }
+
+        return sent;
+    }
+
+    // Sockets have no offset.
+    if (offset != NULL && lseek(fd, 0, SEEK_CUR) < 0 && errno == ESPIPE)
+        offset = NULL;
+
+    if (-1 == check_error(pipe2(pipefd, O_CLOEXEC))) return -1;
+
+    while (sent < count) {
+        if (in_pipe == 0) {
+            if (draining) break;  // socket buffer full, pipe empty
+
+            in_pipe = splice(fd, offset != NULL ? &pos : NULL, pipefd[1], NULL,
+                             count - sent, SPLICE_F_MOVE);
+
+            if (in_pipe == 0) break;  // EOF on fd
+
+            if (in_pipe < 0) {
+                in_pipe = 0;
+                if (errno == EINTR) continue;
+                failed = 1;
+                break;
+            }
+        }
+
+        out = splice(pipefd[0], NULL, sfd, NULL, in_pipe,
+                     SPLICE_F_MOVE | SPLICE_F_MORE);
+
+        if (out < 0 && errno == EINTR) continue;
+
+        if (out < 0 && errno == EAGAIN && offset == NULL) {
+            struct pollfd pfd = {sfd, POLLOUT, 0};
+            poll(&pfd, 1, -1);
+            draining = 1;
+            continue;
+        }
+
+        if (out <= 0) {
+            failed = 1;
+            break;
+        }
+
+        in_pipe -= out;
+        sent += out;
+    }
+
+    errno_saved = errno;
+    close(pipefd[0]);
+    close(pipefd[1]);
+    errno = errno_saved;
+
+    if (offset != NULL) *offset += sent;
+
+    if (failed && sent == 0) return -1;
+
+    return sent;
+}
+
+/**
+ * @brief Send a file (or part of it) over a stream socket without copying it
+ * to user space.
+ *
+ * Uses `sendfile(2)`; if `fd` cannot be used with `sendfile(2)`, the data is
+ * moved through a pipe using `splice(2)` instead.
+ *
+ * On blocking sockets this function returns when `count` bytes have been sent
+ * or the end of `fd` has been reached. On non-blocking sockets it returns as
+ * soon as the socket buffer is full.
+ *
+ * @param sfd The socket to send to
+ * @param fd The file descriptor to read from
+ * @param offset Offset in `fd` to start reading at; updated to point behind the
+ * last byte sent. If `NULL`, the file offset of `fd` is used and updated.
+ * Ignored if `fd` is a pipe or socket.
+ * @param count Number of bytes to send
+ *
+ * @retval n *n* bytes were sent; less than `count` if the end of `fd` was
+ * reached, the socket is non-blocking, or an error occurred after some bytes
+ * had been sent (the next call reports it).
+ * @retval -1 Error; if `errno` is `EAGAIN`, the socket is non-blocking and no
+ * byte could be sent.
+ */
+ssize_t sendfile_inet_stream_socket(int sfd, int fd, off_t *offset,
+                                    size_t count) {
+    size_t sent = 0;
+    ssize_t bytes;
+
+    if (sfd < 0 || fd < 0) return -1;
+
+    while (sent < count) {
+        bytes = sendfile(sfd, fd, offset, count - sent);
+
+        if (bytes == 0) break;  // EOF on fd
+
+        if (bytes < 0) {
+            if (errno == EINTR) continue;
+
+            if ((errno == EINVAL || errno == ENOSYS || errno == ESPIPE) &&
+                sent == 0)
+                return splice_to_socket(sfd, fd, offset, count);
+
+            if (sent > 0) break;  // report what was sent; the error recurs
+
+            check_error(bytes);
+            return -1;
+        }
+
+        sent += bytes;
+    }
+
+    return sent;
+}
+#endif
+
 /*
  * Server part
  *
@@ -12,6 +12,9 @@
 #include <sys/types.h>
 #include <sys/un.h>  // UNIX domain sockets
 #include <unistd.h>  // read()/write()
+#if LIBSOCKET_LINUX
+#include <libinetsocket.h>  // sendfile_inet_stream_socket()
+#endif
 
 /**
  * @addtogroup libunixsocket
@@ -336,6 +339,20 @@ int shutdown_unix_stream_socket(int sfd, int method) {
     return 0;
 }
 
+#if LIBSOCKET_LINUX
+/**
+ * @brief Send a file (or part of it) over a UNIX stream socket without copying
+ * it to user space.
+ *
+ * Nothing about this is specific to the address family, so it is the same as
+ * `sendfile_inet_stream_socket()`; see there.
+ */
+ssize_t sendfile_unix_stream_socket(int sfd, int fd, off_t *offset,
+                                    size_t count) {
+    return sendfile_inet_stream_socket(sfd, fd, offset, count);
+}
+#endif
+
 /**
  * @brief Create a passive UNIX socket
  *
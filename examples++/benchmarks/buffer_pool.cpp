@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <libsocket/bufferpool.hpp>
+#include <libsocket/exception.hpp>
+
+/*
+ * Receive buffers from std::vector vs. buffer_pool.
+ *
+ * Usage: buffer_pool [threads] [iterations]
+ *
+ * 1. Allocation rate: every thread gets a buffer, writes to it and drops it,
+ *    `iterations` times. The vectors are sized like received messages
+ *    (64..2048 bytes); the pool's buffers are 2 KiB.
+ * 2. Resident memory under churn: 50000 messages are kept, and each
+ *    iteration replaces a random one by a new message of random size, as a
+ *    server with many slow consumers would. RSS is measured after the churn
+ *    and after all messages have been dropped. Every case runs in its own
+ *    process.
+ *
+ * Defaults: 4 threads, 2000000 iterations.
+ */
+
+using libsocket::buffer_pool;
+using libsocket::pooled_buffer;
+using libsocket::socket_exception;
+
+static const size_t buffer_size = 2048;
+static const size_t live_messages = 50000;
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start)
+        .count();
+}
+
+static size_t rss_kib(void) {
+    long pages = 0, resident = 0;
+    FILE* f = fopen("/proc/self/statm", "r");
+
+    if (f == NULL) return 0;
+    if (fscanf(f, "%ld %ld", &pages, &resident) != 2) resident = 0;
+    fclose(f);
+
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+template <typename F>
+static double rate(size_t threads, size_t iterations, F f) {
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t t = 0; t < threads; t++)
+        workers.emplace_back([&f, t, iterations] {
+            std::minstd_rand rng(t);
+
+            for (size_t i = 0; i < iterations; i++) f(rng);
+        });
+    for (auto& w : workers) w.join();
+
+    return threads * iterations / seconds_since(start) / 1e6;
+}
+
+// Runs f in a child process, which prints its results.
+template <typename F>
+static void isolated(F f) {
+    std::cout.flush();
+
+    pid_t pid = fork();
+
+    if (pid == 0) {
+        f();
+        std::cout.flush();
+        _exit(0);
+    }
+
+    waitpid(pid, NULL, 0);
+}
+
+int main(int argc, char** argv) {
+    const size_t threads = argc > 1 ? atoi(argv[1]) : 4;
+    const size_t iterations = argc > 2 ? atoi(argv[2]) : 2000000;
+
+    try {
+        std::cout << "allocation rate (" << threads << " threads):\n";
+
+        isolated([=] {
+            double r = rate(threads, iterations, [](std::minstd_rand& rng) {
+                std::vector<char> v(64 + rng() % (buffer_size - 64));
+
+                v[0] = 1;
+                asm volatile("" : : "r"(v.data()) : "memory");
+            });
+
+            std::cout << "  std::vector: " << r << " M/s\n";
+        });
+        isolated([=] {
+            buffer_pool pool;
+            double r = rate(threads, iterations, [&pool](std::minstd_rand&) {
+                pooled_buffer b = pool.get();
+
+                b.data()[0] = 1;
+                asm volatile("" : : "r"(b.data()) : "memory");
+            });
+
+            std::cout << "  buffer_pool: " << r << " M/s\n";
+        });
+
+        std::cout << "resident memory, " << live_messages
+                  << " live messages:\n";
+
+        isolated([=] {
+            std::vector<std::vector<char>> live(live_messages);
+            std::minstd_rand rng(1);
+
+            for (size_t i = 0; i < iterations; i++)
+                live[rng() % live_messages].assign(64 + rng() % (buffer_size - 64),
+                                                   1);
+
+            size_t busy = rss_kib();
+
+            live.clear();
+            live.shrink_to_fit();
+
+            std::cout << "  std::vector: " << busy << " KiB, " << rss_kib()
+                      << " KiB after dropping all\n";
+        });
+        isolated([=] {
+            size_t after;
+
+            {
+                buffer_pool pool;
+                std::vector<pooled_buffer> live(live_messages);
+                std::minstd_rand rng(1);
+
+                for (size_t i = 0; i < iterations; i++) {
+                    pooled_buffer& b = live[rng() % live_messages];
+
+                    b = pool.get();
+                    b.resize(64 + rng() % (buffer_size - 64));
+                    memset(b.data(), 1, b.size());
+                }
+
+                size_t busy = rss_kib();
+
+                live.clear();
+                live.shrink_to_fit();
+                after = rss_kib();
+
+                std::cout << "  buffer_pool: " << busy << " KiB, " << after
+                          << " KiB after dropping all (" << pool.slabs()
+                          << " slabs)";
+            }
+
+            std::cout << ", " << rss_kib() << " KiB after destroying the pool\n";
+        });
+    } catch (const socket_exception& exc) {
+        std::cerr << exc.mesg;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,22 @@
+#!/bin/bash
+
+g++ -std=c++11 -pthread -o zerocopy_send zerocopy_send.cpp -lsocket++
+g++ -std=c++11 -pthread -o zerocopy_receive zerocopy_receive.cpp -lsocket++
+g++ -std=c++11 -pthread -o udp_loadgen udp_loadgen.cpp -lsocket++
+g++ -std=c++11 -pthread -o reuseport_pps reuseport_pps.cpp -lsocket++
+g++ -std=c++11 -pthread -o latency_histogram latency_histogram.cpp -lsocket++
+g++ -std=c++11 -pthread -o multicast_throughput multicast_throughput.cpp -lsocket++
+g++ -std=c++11 -pthread -o paced_send paced_send.cpp -lsocket++
+g++ -std=c++11 -pthread -o session_lookup session_lookup.cpp -lsocket++
+g++ -std=c++11 -pthread -o tiny_packets tiny_packets.cpp -lsocket++
+g++ -std=c++11 -pthread -o connect_latency connect_latency.cpp -lsocket++
+g++ -std=c++11 -pthread -o resolver_cache resolver_cache.cpp -lsocket++
+g++ -std=c++11 -pthread -o fastopen_rpc fastopen_rpc.cpp -lsocket++
+g++ -std=c++11 -pthread -o pooled_requests pooled_requests.cpp -lsocket++
+g++ -std=c++11 -pthread -o connect_rate connect_rate.cpp -lsocket++
+g++ -std=c++11 -pthread -o error_paths error_paths.cpp -lsocket++
+g++ -std=c++11 -pthread -o idle_memory idle_memory.cpp -lsocket++
+g++ -std=c++11 -pthread -o policy_socket policy_socket.cpp -lsocket++
+g++ -std=c++11 -pthread -o buffer_pool buffer_pool.cpp -lsocket++
+g++ -std=c++11 -pthread -o write_queue write_queue.cpp -lsocket++
+g++ -std=c++11 -pthread -o write_watermarks write_watermarks.cpp -lsocket++
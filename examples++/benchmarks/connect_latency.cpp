@@ -0,0 +1,177 @@
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <libsocket/exception.hpp>
+#include <libsocket/inetserverstream.hpp>
+#include <libsocket/inetstreamconnector.hpp>
+
+/*
+ * Time to connect to a host whose first address does not answer.
+ *
+ * Usage: connect_latency [connects [attempt_delay_ms [timeout_ms]]]
+ *
+ * The host has two addresses: 127.0.0.2, where a listener with a full accept
+ * queue silently drops all SYNs, and 127.0.0.1, where a server accepts. The
+ * addresses are tried
+ *
+ *  - one after another, giving each `timeout_ms` before moving on (what a
+ *    client with a connect timeout does; without one, the kernel gives up
+ *    only after about two minutes), and
+ *  - with inet_stream_connector, which starts the second attempt after
+ *    `attempt_delay_ms`.
+ *
+ * For reference, the connector is also timed with the working address only.
+ *
+ * Defaults: 20 connects, 250 ms, 1000 ms.
+ */
+
+using libsocket::inet_stream;
+using libsocket::inet_stream_connector;
+using libsocket::inet_stream_server;
+using libsocket::socket_exception;
+
+typedef std::chrono::steady_clock clock_type;
+
+static const char* const live_port = "47391";
+static const int dead_port = 47392;
+
+static struct sockaddr_in make_addr(const char* ip, int port) {
+    struct sockaddr_in a;
+
+    memset(&a, 0, sizeof(a));
+    a.sin_family = AF_INET;
+    a.sin_port = htons(port);
+    inet_pton(AF_INET, ip, &a.sin_addr);
+
+    return a;
+}
+
+// Connects to one address, waiting at most timeout_ms.
+static bool connect_one(const struct sockaddr_in& a, int timeout_ms) {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+
+    if (0 > ::connect(fd, reinterpret_cast<const struct sockaddr*>(&a),
+                      sizeof(a)) &&
+        errno != EINPROGRESS) {
+        close(fd);
+        return false;
+    }
+
+    struct pollfd p = {fd, POLLOUT, 0};
+    int err = 1;
+    socklen_t len = sizeof(err);
+
+    if (1 == poll(&p, 1, timeout_ms))
+        getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len);
+
+    close(fd);
+
+    return err == 0;
+}
+
+static void report(const char* name, std::vector<double>& ms) {
+    std::sort(ms.begin(), ms.end());
+
+    std::cout << name << "p50 " << ms[ms.size() / 2] << " ms, p90 "
+              << ms[ms.size() * 9 / 10] << " ms, max " << ms.back() << " ms"
+              << std::endl;
+}
+
+int main(int argc, char** argv) {
+    const size_t connects = argc > 1 ? atoi(argv[1]) : 20;
+    const int delay = argc > 2 ? atoi(argv[2]) : 250;
+    const int timeout = argc > 3 ? atoi(argv[3]) : 1000;
+
+    try {
+        inet_stream_server server("127.0.0.1", live_port, LIBSOCKET_IPv4);
+
+        // A listener whose accept queue is full drops further SYNs, like a
+        // host that is down.
+        struct sockaddr_in dead = make_addr("127.0.0.2", dead_port);
+        int blackhole = ::socket(AF_INET, SOCK_STREAM, 0);
+        int filler = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+
+        if (0 > bind(blackhole, reinterpret_cast<struct sockaddr*>(&dead),
+                     sizeof(dead)) ||
+            0 > listen(blackhole, 0)) {
+            perror("blackhole");
+            return 1;
+        }
+
+        ::connect(filler, reinterpret_cast<struct sockaddr*>(&dead),
+                  sizeof(dead));
+        usleep(100000);
+
+        struct sockaddr_in live = make_addr("127.0.0.1", atoi(live_port));
+        struct addrinfo live_ai, dead_ai;
+
+        memset(&live_ai, 0, sizeof(live_ai));
+        live_ai.ai_family = AF_INET;
+        live_ai.ai_socktype = SOCK_STREAM;
+        live_ai.ai_addr = reinterpret_cast<struct sockaddr*>(&live);
+        live_ai.ai_addrlen = sizeof(live);
+
+        dead_ai = live_ai;
+        dead_ai.ai_addr = reinterpret_cast<struct sockaddr*>(&dead);
+        dead_ai.ai_addrlen = sizeof(dead);
+        dead_ai.ai_next = &live_ai;
+
+        std::vector<double> sequential, eyeballs, direct;
+
+        for (size_t i = 0; i < connects; i++) {
+            auto start = clock_type::now();
+
+            if (!connect_one(dead, timeout) && !connect_one(live, timeout)) {
+                std::cerr << "Sequential connect failed" << std::endl;
+                return 1;
+            }
+
+            sequential.push_back(std::chrono::duration<double, std::milli>(
+                                     clock_type::now() - start)
+                                     .count());
+            server.accept2();
+
+            for (int pass = 0; pass < 2; pass++) {
+                start = clock_type::now();
+
+                inet_stream_connector conn(pass == 0 ? &dead_ai : &live_ai, 0,
+                                           delay);
+
+                while (!conn.step(-1))
+                    ;
+
+                std::unique_ptr<inet_stream> sock = conn.result();
+
+                (pass == 0 ? eyeballs : direct)
+                    .push_back(std::chrono::duration<double, std::milli>(
+                                   clock_type::now() - start)
+                                   .count());
+                server.accept2();
+            }
+        }
+
+        report("sequential, dead first:             ", sequential);
+        report("inet_stream_connector, dead first: ", eyeballs);
+        report("inet_stream_connector, live only:  ", direct);
+
+        close(filler);
+        close(blackhole);
+    } catch (const socket_exception& exc) {
+        std::cerr << exc.mesg;
+        return 1;
+    }
+
+    return 0;
+}
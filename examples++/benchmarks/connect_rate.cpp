@@ -0,0 +1,120 @@
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <libsocket/exception.hpp>
+#include <libsocket/inetclientstream.hpp>
+#include <libsocket/inetserverstream.hpp>
+
+/*
+ * Connect rate to a local listener.
+ *
+ * Usage: connect_rate [connects]
+ *
+ * Opens and closes `connects` TCP connections to a server on 127.0.0.1 (and
+ * ::1, if available), once without asking for the local address and once
+ * calling gethostClient() after each connect. The local address is only
+ * looked up in the second case.
+ *
+ * Besides the overall rate, the median time per connect is printed: on busy
+ * loopback interfaces a few SYNs hitting ports still in TIME_WAIT are
+ * retransmitted after a second, which dominates the rate.
+ *
+ * Defaults: 5000 connects.
+ */
+
+using libsocket::inet_stream;
+using libsocket::inet_stream_server;
+using libsocket::socket_exception;
+
+static void serve(inet_stream_server* server) {
+    char buf[16];
+
+    try {
+        // Wait for the client to close first, so TIME_WAIT ends up on the
+        // client's side and does not block reused ports.
+        while (true) server->accept2()->rcv(buf, sizeof(buf));
+    } catch (const socket_exception& exc) {
+        std::cerr << exc.mesg;
+    }
+}
+
+struct result {
+    double rate;    ///< connects/s
+    double median;  ///< microseconds per connect
+};
+
+static result run(const char* host, int proto, size_t connects,
+                  bool local_address) {
+    std::vector<double> times;
+    size_t chars = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    times.reserve(connects);
+
+    for (size_t i = 0; i < connects; i++) {
+        auto t0 = std::chrono::steady_clock::now();
+        inet_stream sock(host, "47431", proto);
+
+        if (local_address) chars += sock.gethostClient().size();
+
+        times.push_back(std::chrono::duration<double, std::micro>(
+                            std::chrono::steady_clock::now() - t0)
+                            .count());
+    }
+
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                             start)
+                   .count();
+
+    if (local_address && chars == 0) std::cerr << "no local address?\n";
+
+    std::nth_element(times.begin(), times.begin() + connects / 2, times.end());
+
+    return result{connects / s, times[connects / 2]};
+}
+
+static void bench(const char* host, int proto, size_t connects) {
+    // Used by the server thread until the program exits
+    inet_stream_server* server = new inet_stream_server(host, "47431", proto);
+
+    std::thread(serve, server).detach();
+
+    {
+        inet_stream sock(host, "47431", proto);
+
+        std::cout << host << ": local address " << sock.gethostClient()
+                  << " port " << sock.getportClient() << std::endl;
+    }
+
+    result plain = run(host, proto, connects, false);
+    result local = run(host, proto, connects, true);
+
+    std::cout << "  connect only:              " << plain.rate
+              << " connects/s, median " << plain.median << " us" << std::endl;
+    std::cout << "  connect + gethostClient(): " << local.rate
+              << " connects/s, median " << local.median << " us" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    const size_t connects = argc > 1 ? atoi(argv[1]) : 5000;
+
+    try {
+        bench("127.0.0.1", LIBSOCKET_IPv4, connects);
+    } catch (const socket_exception& exc) {
+        std::cerr << exc.mesg;
+        return 1;
+    }
+
+    try {
+        bench("::1", LIBSOCKET_IPv6, connects);
+    } catch (const socket_exception& exc) {
+        std::cerr << "IPv6 skipped: " << exc.mesg;
+    }
+
+    return 0;
+}
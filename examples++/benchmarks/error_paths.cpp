@@ -0,0 +1,120 @@
+#include <stdlib.h>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <system_error>
+
+#include <libsocket/exception.hpp>
+#include <libsocket/inetclientdgram.hpp>
+#include <libsocket/inetclientstream.hpp>
+#include <libsocket/inetserverstream.hpp>
+
+/*
+ * Cost of expected errors reported by socket_exception vs. std::error_code.
+ *
+ * Usage: error_paths [iterations]
+ *
+ * 1. Connecting to a closed local port (ECONNREFUSED), like a health check of
+ *    a server that is down.
+ * 2. rcv() with MSG_DONTWAIT on a connected TCP socket without data (EAGAIN).
+ *    The throwing rcv() only returns -1 for non-blocking sockets and throws
+ *    otherwise.
+ * 3. sndto() to a host name that can not be resolved (cached negative answer).
+ *
+ * Defaults: 20000 iterations.
+ */
+
+using libsocket::inet_dgram_client;
+using libsocket::inet_stream;
+using libsocket::inet_stream_server;
+using libsocket::socket_exception;
+
+template <typename F>
+static double run(size_t iterations, F f) {
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < iterations; i++) f();
+
+    return std::chrono::duration<double, std::nano>(
+               std::chrono::steady_clock::now() - start)
+               .count() /
+           iterations;
+}
+
+static void report(const char* what, double thrown, double code) {
+    std::cout << what << ":\n  socket_exception: " << thrown
+              << " ns\n  std::error_code:  " << code << " ns" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    const size_t iterations = argc > 1 ? atoi(argv[1]) : 20000;
+    size_t errors = 0;
+
+    try {
+        double thrown = run(iterations, [&errors] {
+            try {
+                inet_stream sock("127.0.0.1", "1", LIBSOCKET_IPv4);
+            } catch (const socket_exception&) {
+                errors++;
+            }
+        });
+        double code = run(iterations, [&errors] {
+            std::error_code ec;
+            inet_stream sock;
+
+            sock.connect("127.0.0.1", "1", LIBSOCKET_IPv4, ec);
+
+            if (ec) errors++;
+        });
+
+        report("refused connect", thrown, code);
+
+        inet_stream_server server("127.0.0.1", "47451", LIBSOCKET_IPv4);
+        inet_stream client("127.0.0.1", "47451", LIBSOCKET_IPv4);
+        std::unique_ptr<inet_stream> peer = server.accept2();
+        char buf[64];
+
+        thrown = run(iterations, [&] {
+            try {
+                client.rcv(buf, sizeof(buf), MSG_DONTWAIT);
+            } catch (const socket_exception&) {
+                errors++;
+            }
+        });
+        code = run(iterations, [&] {
+            std::error_code ec;
+
+            client.rcv(buf, sizeof(buf), ec, MSG_DONTWAIT);
+
+            if (ec) errors++;
+        });
+
+        report("rcv() without data", thrown, code);
+
+        inet_dgram_client dgram(LIBSOCKET_IPv4);
+
+        thrown = run(iterations, [&] {
+            try {
+                dgram.sndto("x", 1, "no-such-host.invalid", "9");
+            } catch (const socket_exception&) {
+                errors++;
+            }
+        });
+        code = run(iterations, [&] {
+            std::error_code ec;
+
+            dgram.sndto("x", 1, "no-such-host.invalid", "9", ec);
+
+            if (ec) errors++;
+        });
+
+        report("sndto() to an unknown host", thrown, code);
+    } catch (const socket_exception& exc) {
+        std::cerr << exc.mesg;
+        return 1;
+    }
+
+    std::cout << "(" << errors << " errors)" << std::endl;
+
+    return 0;
+}
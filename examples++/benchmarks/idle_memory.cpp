@@ -0,0 +1,113 @@
+#include <malloc.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <libsocket/exception.hpp>
+#include <libsocket/inetclientstream.hpp>
+#include <libsocket/inetserverstream.hpp>
+#include <libsocket/streamhandle.hpp>
+
+/*
+ * User-space memory per idle server-side connection: inet_stream objects from
+ * accept2() vs. stream_handle.
+ *
+ * Usage: idle_memory [connections]
+ *
+ * Opens `connections` loopback connections and keeps the accepted ends. The
+ * heap is measured with mallinfo2() (glibc), so kernel socket buffers are not
+ * included; they are the same in both cases. Each connection takes two file
+ * descriptors; the limit is raised as far as allowed.
+ *
+ * Defaults: 5000 connections.
+ */
+
+using libsocket::inet_stream;
+using libsocket::inet_stream_server;
+using libsocket::socket_exception;
+using libsocket::stream_client_socket;
+using libsocket::stream_handle;
+
+static size_t heap(void) { return mallinfo2().uordblks; }
+
+static stream_handle connect(void) {
+    return stream_handle(std::unique_ptr<stream_client_socket>(
+        new inet_stream("127.0.0.1", "47481", LIBSOCKET_IPv4)));
+}
+
+int main(int argc, char** argv) {
+    size_t connections = argc > 1 ? atoi(argv[1]) : 5000;
+    struct rlimit lim;
+
+    getrlimit(RLIMIT_NOFILE, &lim);
+    lim.rlim_cur = lim.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &lim);
+
+    if (2 * connections + 16 > lim.rlim_cur) {
+        connections = (lim.rlim_cur - 16) / 2;
+        std::cerr << "file descriptor limit: using " << connections
+                  << " connections\n";
+    }
+
+    try {
+        inet_stream_server server("127.0.0.1", "47481", LIBSOCKET_IPv4);
+        std::vector<stream_handle> clients;
+
+        clients.reserve(connections);
+
+        // Warm up the resolver cache and allocator.
+        {
+            stream_handle c = connect();
+            server.accept2(LIBSOCKET_NUMERIC);
+        }
+
+        double objects, handles;
+
+        {
+            std::vector<std::unique_ptr<inet_stream>> accepted;
+
+            accepted.reserve(connections);
+
+            size_t before = heap();
+
+            for (size_t i = 0; i < connections; i++) {
+                clients.push_back(connect());
+                accepted.push_back(server.accept2(LIBSOCKET_NUMERIC));
+            }
+
+            objects = double(heap() - before) / connections +
+                      sizeof(accepted[0]);
+
+            clients.clear();
+        }
+
+        {
+            std::vector<stream_handle> accepted;
+
+            accepted.reserve(connections);
+
+            size_t before = heap();
+
+            for (size_t i = 0; i < connections; i++) {
+                clients.push_back(connect());
+                accepted.push_back(stream_handle::accept(server));
+            }
+
+            handles = double(heap() - before) / connections +
+                      sizeof(accepted[0]);
+
+            clients.clear();
+        }
+
+        std::cout << connections << " idle connections, bytes per connection:"
+                  << "\n  inet_stream (accept2()): " << objects
+                  << "\n  stream_handle:           " << handles << std::endl;
+    } catch (const socket_exception& exc) {
+        std::cerr << exc.mesg;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,135 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <libsocket/exception.hpp>
+#include <libsocket/inetclientdgram.hpp>
+#include <libsocket/inetserverdgram.hpp>
+
+/*
+ * Splits the latency of UDP datagrams into the time until the kernel has
+ * received them and the time they wait in the socket's receive queue, using
+ * kernel receive timestamps (set_timestamps()).
+ *
+ * Usage: latency_histogram [count [interval_us [work_us]]]
+ *
+ * A sender thread sends `count` datagrams over loopback, one every
+ * `interval_us` microseconds, each carrying its send time. The receiver
+ * simulates `work_us` microseconds of processing per datagram (randomly
+ * between 0 and 2 * work_us), so datagrams queue up whenever processing is
+ * slower than the sender. For every datagram,
+ *
+ *   kernel = kernel timestamp - send time   (stack, scheduling of the sender)
+ *   queue  = time rcvfrom() returned - kernel timestamp
+ *
+ * are printed as histograms with power-of-two microsecond buckets. With a
+ * clock_gettime() after rcvfrom() only, both would be mixed together.
+ *
+ * Defaults: 20000 datagrams, 100 us interval, 80 us work.
+ */
+
+using libsocket::inet_dgram_client;
+using libsocket::inet_dgram_server;
+
+static int64_t ns(const struct timespec& ts) {
+    return int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ns(ts);
+}
+
+struct histogram {
+    std::vector<unsigned long> buckets;  // bucket i: [2^(i-1), 2^i) us
+
+    histogram(void) : buckets(24, 0) {}
+
+    void add(int64_t nanos) {
+        uint64_t us = nanos > 0 ? nanos / 1000 : 0;
+        size_t i = 0;
+
+        while (us > 0 && i < buckets.size() - 1) {
+            us >>= 1;
+            i++;
+        }
+        buckets[i]++;
+    }
+
+    void print(const char* name) const {
+        std::cout << name << ":\n";
+
+        for (size_t i = 0; i < buckets.size(); i++) {
+            if (buckets[i] == 0) continue;
+
+            std::cout << "  < " << (1ul << i) << " us\t" << buckets[i] << "\n";
+        }
+    }
+};
+
+int main(int argc, char** argv) {
+    const long count = argc > 1 ? atol(argv[1]) : 20000;
+    const long interval_us = argc > 2 ? atol(argv[2]) : 100;
+    const long work_us = argc > 3 ? atol(argv[3]) : 80;
+
+    try {
+        inet_dgram_server srv("127.0.0.1", "4324", LIBSOCKET_IPv4);
+        srv.set_timestamps();
+
+        std::thread sender([&]() {
+            inet_dgram_client sock("127.0.0.1", "4324", LIBSOCKET_IPv4);
+            int64_t next = now_ns();
+
+            for (long i = 0; i < count; i++) {
+                while (now_ns() < next)
+                    ;
+                int64_t sent = now_ns();
+                sock.snd(&sent, sizeof(sent));
+                next += interval_us * 1000;
+            }
+        });
+
+        histogram kernel, queue;
+        std::string host, port;
+
+        for (long i = 0; i < count; i++) {
+            int64_t sent;
+            struct timespec stamp;
+
+            srv.rcvfrom(&sent, sizeof(sent), host, port, &stamp, 0, true);
+
+            int64_t received = now_ns();
+
+            if (stamp.tv_sec == 0) {
+                std::cerr << "No kernel timestamp!\n";
+                return 1;
+            }
+
+            kernel.add(ns(stamp) - sent);
+            queue.add(received - ns(stamp));
+
+            // Simulated processing
+            int64_t until = received + (rand() % (2 * work_us + 1)) * 1000;
+            while (now_ns() < until)
+                ;
+        }
+
+        sender.join();
+
+        kernel.print("kernel (send -> kernel receive)");
+        queue.print("queue (kernel receive -> application)");
+    } catch (const libsocket::socket_exception& exc) {
+        std::cerr << exc.mesg;
+        return 1;
+    }
+
+    return 0;
+}
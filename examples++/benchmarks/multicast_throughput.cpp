@@ -0,0 +1,150 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <libsocket/dgrambatch.hpp>
+#include <libsocket/exception.hpp>
+#include <libsocket/inetmulticast.hpp>
+
+/*
+ * Loopback multicast throughput of one inet_multicast socket that is a member
+ * of many groups.
+ *
+ * Usage: multicast_throughput [groups [seconds]]
+ *
+ * The receiver joins the groups 239.255.0.1, 239.255.0.2, ... on the loopback
+ * interface and receives with rcvmmsg(), counting the datagrams per group
+ * using dgram_batch::destination(). A sender thread sends 64 byte datagrams
+ * to all groups in turn, plus every 16th datagram to 239.255.1.1, which only
+ * another socket on the same port has joined; thanks to IP_MULTICAST_ALL
+ * being off, the receiver must not see those.
+ *
+ * Linux allows 20 groups per socket by default; for more, raise
+ * net.ipv4.igmp_max_memberships.
+ *
+ * Defaults: 16 groups, 3 seconds.
+ */
+
+using libsocket::dgram_batch;
+using libsocket::inet_multicast;
+
+static const char* port = "4325";
+
+static std::string group_name(size_t i) {
+    char name[32];
+
+    snprintf(name, sizeof(name), "239.255.%zu.%zu", (i + 1) / 256,
+             (i + 1) % 256);
+
+    return name;
+}
+
+static void generate(size_t groups, std::atomic<bool>* running) {
+    inet_multicast sock("0");
+    dgram_batch batch(64, 64);
+    std::vector<struct sockaddr_in> dsts(groups + 1);
+
+    sock.set_interface("lo");
+    sock.set_loop(true);
+
+    for (size_t i = 0; i <= groups; i++) {
+        memset(&dsts[i], 0, sizeof(dsts[i]));
+        dsts[i].sin_family = AF_INET;
+        dsts[i].sin_port = htons(atoi(port));
+        inet_pton(AF_INET, i < groups ? group_name(i).c_str() : "239.255.1.1",
+                  &dsts[i].sin_addr);
+    }
+
+    size_t sent = 0, group = 0;
+
+    for (size_t i = 0; i < batch.capacity(); i++) memset(batch.data(i), 'x', 64);
+
+    while (*running) {
+        for (size_t i = 0; i < batch.capacity(); i++, sent++) {
+            const struct sockaddr_in& dst =
+                sent % 16 == 15 ? dsts[groups] : dsts[group++ % groups];
+
+            batch.set_length(i, 64);
+            batch.set_address(i, reinterpret_cast<const struct sockaddr*>(&dst),
+                              sizeof(dst));
+        }
+        batch.resize(batch.capacity());
+        sock.sndmmsg(batch);
+    }
+}
+
+int main(int argc, char** argv) {
+    const size_t groups = argc > 1 ? atoi(argv[1]) : 16;
+    const int seconds = argc > 2 ? atoi(argv[2]) : 3;
+
+    try {
+        inet_multicast rcv(port, LIBSOCKET_IPv4, SOCK_NONBLOCK);
+        inet_multicast other(port);
+
+        for (size_t i = 0; i < groups; i++) rcv.join(group_name(i), "lo");
+        other.join("239.255.1.1", "lo");
+
+        rcv.set_destination_info();
+
+        std::cout << "Joined " << rcv.memberships() << " groups" << std::endl;
+
+        dgram_batch batch(64, 2048, dgram_batch::destination_control_size);
+        std::vector<unsigned long long> per_group(groups);
+        unsigned long long total = 0, foreign = 0;
+
+        std::atomic<bool> running(true);
+        std::thread sender(generate, groups, &running);
+
+        auto start = std::chrono::steady_clock::now();
+        auto end = start + std::chrono::seconds(seconds);
+
+        while (std::chrono::steady_clock::now() < end) {
+            if (rcv.rcvmmsg(batch) < 0) continue;
+
+            for (size_t i = 0; i < batch.size(); i++) {
+                struct sockaddr_storage dst;
+
+                if (!batch.destination(i, &dst)) continue;
+
+                size_t host = ntohl(reinterpret_cast<struct sockaddr_in*>(&dst)
+                                        ->sin_addr.s_addr) &
+                              0xffff;
+
+                if (host >= 1 && host <= groups)
+                    per_group[host - 1]++;
+                else
+                    foreign++;
+            }
+            total += batch.size();
+        }
+
+        running = false;
+        sender.join();
+
+        unsigned long long least = total, most = 0;
+
+        for (unsigned long long n : per_group) {
+            if (n < least) least = n;
+            if (n > most) most = n;
+        }
+
+        std::cout << total / seconds << " datagrams/s over " << groups
+                  << " groups (" << least << " to " << most
+                  << " per group), " << foreign
+                  << " from groups not joined" << std::endl;
+    } catch (const libsocket::socket_exception& exc) {
+        std::cerr << exc.mesg;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <libsocket/dgrampacer.hpp>
+#include <libsocket/epoll.hpp>
+#include <libsocket/exception.hpp>
+#include <libsocket/inetclientdgram.hpp>
+#include <libsocket/inetserverdgram.hpp>
+
+/*
+ * Shows how pacing avoids receiver drops.
+ *
+ * Usage: paced_send [count [rate_mbit [work_us]]]
+ *
+ * A receiver with a small socket buffer spends `work_us` microseconds on each
+ * 1200 byte datagram. `count` datagrams are sent to it over loopback, first
+ * as fast as possible and then through a dgram_pacer (pace_user) limited to
+ * `rate_mbit` Mbit/s, driven by an epollset. For both runs, the number of
+ * datagrams that arrived, the achieved send rate and the largest queue depth
+ * in the pacer are printed.
+ *
+ * Defaults: 20000 datagrams, 50 Mbit/s, 20 us of work (i.e. the receiver can
+ * handle about 480 Mbit/s on average, but not a burst at loopback speed).
+ */
+
+using libsocket::dgram_pacer;
+using libsocket::epollset;
+using libsocket::inet_dgram_client;
+using libsocket::inet_dgram_server;
+using libsocket::pacer_stats;
+using libsocket::timer_wheel;
+
+static const char* port = "4327";
+static const size_t dgram_size = 1200;
+
+static void receive(inet_dgram_server* srv, int work_us,
+                    std::atomic<unsigned long>* received) {
+    char buf[2048];
+
+    while (true) {
+        ssize_t n = recv(srv->getfd(), buf, sizeof(buf), 0);
+
+        if (n <= 1) return;  // Stop marker
+
+        uint64_t until = timer_wheel::now() + work_us;
+        while (timer_wheel::now() < until)
+            ;
+
+        (*received)++;
+    }
+}
+
+static unsigned long run(size_t count, uint64_t rate, int work_us) {
+    inet_dgram_server srv("127.0.0.1", port, LIBSOCKET_IPv4);
+    int rcvbuf = 64 * 1024;
+
+    setsockopt(srv.getfd(), SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    std::atomic<unsigned long> received(0);
+    std::thread receiver(receive, &srv, work_us, &received);
+
+    inet_dgram_client sock("127.0.0.1", port, LIBSOCKET_IPv4);
+    dgram_pacer pacer(sock, dgram_pacer::pace_user, 256);
+    size_t dest = pacer.add_destination(rate, 16 * dgram_size);
+    epollset<inet_dgram_client> set;
+    char dgram[dgram_size];
+    size_t max_queued = 0;
+
+    memset(dgram, 'x', sizeof(dgram));
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < count;) {
+        if (pacer.send(dest, dgram, sizeof(dgram)) >= 0) {
+            i++;
+            continue;
+        }
+
+        // Queue full: wait until the pacer can send again.
+        pacer_stats st = pacer.stats(dest);
+        if (st.queued > max_queued) max_queued = st.queued;
+
+        set.wait(pacer.next_timeout());
+        pacer.flush();
+    }
+
+    while (pacer.stats(dest).queued > 0) {
+        set.wait(pacer.next_timeout());
+        pacer.flush();
+    }
+
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    pacer_stats st = pacer.stats(dest);
+
+    // Give the receiver time to empty its buffer, then stop it.
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    sock.snd("", 1);
+    receiver.join();
+
+    std::cout << (rate ? "paced:   " : "unpaced: ") << received << " of "
+              << count << " received, "
+              << st.bytes * 8 / seconds / 1000000 << " Mbit/s, max. queue "
+              << max_queued << std::endl;
+
+    return received;
+}
+
+int main(int argc, char** argv) {
+    const size_t count = argc > 1 ? atoi(argv[1]) : 20000;
+    const uint64_t rate = (argc > 2 ? atoi(argv[2]) : 50) * 1000000ULL / 8;
+    const int work_us = argc > 3 ? atoi(argv[3]) : 20;
+
+    try {
+        run(count, 0, work_us);
+        run(count, rate, work_us);
+    } catch (const libsocket::socket_exception& exc) {
+        std::cerr << exc.mesg;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include <stdlib.h>
+#include <chrono>
+#include <iostream>
+#include <memory>
+
+#include <libsocket/exception.hpp>
+#include <libsocket/inetclientstream.hpp>
+#include <libsocket/inetserverstream.hpp>
+#include <libsocket/policysocket.hpp>
+
+/*
+ * Cost of a small send and receive with inet_stream vs. a policy_socket
+ * configured for an event loop (non-blocking, error codes, no checks).
+ *
+ * Usage: policy_socket [iterations]
+ *
+ * Both ends of a loopback connection are driven from one thread: one byte is
+ * sent each way and read again, so almost all of the time is spent in the
+ * kernel; the difference is the per-call overhead of the library.
+ *
+ * Defaults: 200000 round trips.
+ */
+
+using libsocket::inet_stream;
+using libsocket::inet_stream_server;
+using libsocket::policy_socket;
+using libsocket::socket_exception;
+
+namespace policy = libsocket::policy;
+
+typedef policy_socket<policy::stream, policy::nonblocking, policy::error_codes,
+                      policy::unchecked>
+    fast_socket;
+
+template <typename F>
+static double run(size_t iterations, F f) {
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < iterations; i++) f();
+
+    return std::chrono::duration<double, std::nano>(
+               std::chrono::steady_clock::now() - start)
+               .count() /
+           iterations;
+}
+
+int main(int argc, char** argv) {
+    const size_t iterations = argc > 1 ? atoi(argv[1]) : 200000;
+    size_t errors = 0;
+
+    try {
+        inet_stream_server server("127.0.0.1", "47491", LIBSOCKET_IPv4);
+        char buf[16];
+
+        inet_stream a("127.0.0.1", "47491", LIBSOCKET_IPv4);
+        std::unique_ptr<inet_stream> b = server.accept2(LIBSOCKET_NUMERIC);
+
+        double objects = run(iterations, [&] {
+            a.snd("x", 1);
+            if (b->rcv(buf, sizeof(buf)) != 1) errors++;
+            b->snd("y", 1);
+            if (a.rcv(buf, sizeof(buf)) != 1) errors++;
+        });
+
+        fast_socket c(std::unique_ptr<libsocket::socket>(
+            new inet_stream("127.0.0.1", "47491", LIBSOCKET_IPv4)));
+        fast_socket d(std::unique_ptr<libsocket::socket>(
+            server.accept2(LIBSOCKET_NUMERIC)));
+
+        double policies = run(iterations, [&] {
+            c.snd("x", 1);
+            if (d.rcv(buf, sizeof(buf)) != 1) errors++;
+            d.snd("y", 1);
+            if (c.rcv(buf, sizeof(buf)) != 1) errors++;
+        });
+
+        std::cout << "round trip (2x snd + 2x rcv):\n  inet_stream:   "
+                  << objects << " ns\n  policy_socket: " << policies << " ns"
+                  << std::endl;
+    } catch (const socket_exception& exc) {
+        std::cerr << exc.mesg;
+        return 1;
+    }
+
+    std::cout << "(" << errors << " errors)" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,109 @@
+#include <stdlib.h>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <libsocket/connectionpool.hpp>
+#include <libsocket/exception.hpp>
+#include <libsocket/inetclientstream.hpp>
+#include <libsocket/inetserverstream.hpp>
+
+/*
+ * Request rate with a new connection per request vs. connections from a
+ * connection_pool.
+ *
+ * Usage: pooled_requests [requests [threads]]
+ *
+ * Each of `threads` client threads sends `requests` small requests to a local
+ * server and waits for the answers. The server runs one thread per
+ * connection.
+ *
+ * Defaults: 5000 requests, 4 threads.
+ */
+
+using libsocket::connection_pool;
+using libsocket::inet_stream;
+using libsocket::inet_stream_server;
+using libsocket::socket_exception;
+
+static void answer(std::unique_ptr<inet_stream> client) {
+    char buf[64];
+
+    try {
+        while (0 < client->rcv(buf, sizeof(buf))) client->snd("OK\n", 3);
+    } catch (const socket_exception&) {
+    }
+}
+
+static void serve(inet_stream_server* server) {
+    try {
+        while (true) std::thread(answer, server->accept2()).detach();
+    } catch (const socket_exception& exc) {
+        std::cerr << exc.mesg;
+    }
+}
+
+template <typename F>
+static double run(size_t threads, size_t requests, F request) {
+    std::vector<std::thread> clients;
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t t = 0; t < threads; t++)
+        clients.emplace_back([requests, &request] {
+            try {
+                for (size_t i = 0; i < requests; i++) request();
+            } catch (const socket_exception& exc) {
+                std::cerr << exc.mesg;
+            }
+        });
+
+    for (std::thread& t : clients) t.join();
+
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                             start)
+                   .count();
+
+    return threads * requests / s;
+}
+
+int main(int argc, char** argv) {
+    const size_t requests = argc > 1 ? atoi(argv[1]) : 5000;
+    const size_t threads = argc > 2 ? atoi(argv[2]) : 4;
+
+    try {
+        inet_stream_server server("127.0.0.1", "47421", LIBSOCKET_IPv4);
+
+        std::thread(serve, &server).detach();
+
+        double fresh = run(threads, requests, [] {
+            char buf[8];
+            inet_stream sock("localhost", "47421", LIBSOCKET_IPv4);
+
+            sock.snd("GET\n", 4);
+            sock.rcv(buf, sizeof(buf));
+        });
+
+        connection_pool pool;
+
+        double pooled = run(threads, requests, [&pool] {
+            char buf[8];
+            connection_pool::lease sock =
+                pool.get_inet("localhost", "47421", LIBSOCKET_IPv4);
+
+            sock->snd("GET\n", 4);
+            sock->rcv(buf, sizeof(buf));
+        });
+
+        std::cout << "new connection per request: " << fresh
+                  << " requests/s" << std::endl;
+        std::cout << "connection_pool:            " << pooled
+                  << " requests/s" << std::endl;
+    } catch (const socket_exception& exc) {
+        std::cerr << exc.mesg;
+        return 1;
+    }
+
+    return 0;
+}
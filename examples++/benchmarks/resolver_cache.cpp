@@ -0,0 +1,71 @@
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include <libsocket/exception.hpp>
+#include <libsocket/inetclientdgram.hpp>
+#include <libsocket/inetserverdgram.hpp>
+#include <libsocket/resolver.hpp>
+
+/*
+ * Cost of sndto() with a host name, with and without the resolver cache.
+ *
+ * Usage: resolver_cache [datagrams [host]]
+ *
+ * Sends `datagrams` one-byte datagrams to a local server, addressed by `host`
+ * (which has to resolve to 127.0.0.1; "localhost" is found in /etc/hosts).
+ * Without the cache, every sndto() calls getaddrinfo().
+ *
+ * Defaults: 100000 datagrams, localhost.
+ */
+
+using libsocket::inet_dgram_client;
+using libsocket::inet_dgram_server;
+using libsocket::resolver;
+using libsocket::socket_exception;
+
+int main(int argc, char** argv) {
+    const size_t datagrams = argc > 1 ? atoi(argv[1]) : 100000;
+    const std::string host = argc > 2 ? argv[2] : "localhost";
+
+    typedef std::chrono::steady_clock clock;
+
+    try {
+        inet_dgram_server server("127.0.0.1", "47401", LIBSOCKET_IPv4);
+        inet_dgram_client client(LIBSOCKET_IPv4);
+        char buf[16];
+
+        for (int cached = 0; cached < 2; cached++) {
+            if (cached)
+                resolver::set_cache_ttl(30000, 5000);
+            else
+                resolver::set_cache_ttl(0, 0);
+
+            resolver::flush_cache();
+
+            auto start = clock::now();
+
+            for (size_t i = 0; i < datagrams; i++) {
+                client.sndto("x", 1, host, "47401");
+
+                // Keep the receive queue from overflowing.
+                while (0 < ::recv(server.getfd(), buf, sizeof(buf), MSG_DONTWAIT))
+                    ;
+            }
+
+            double ns = std::chrono::duration<double, std::nano>(
+                            clock::now() - start)
+                            .count();
+
+            std::cout << (cached ? "cached:   " : "uncached: ")
+                      << ns / datagrams << " ns per sndto()" << std::endl;
+        }
+    } catch (const socket_exception& exc) {
+        std::cerr << exc.mesg;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include <netdb.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <libsocket/dgrambatch.hpp>
+#include <libsocket/exception.hpp>
+#include <libsocket/inetclientdgram.hpp>
+#include <libsocket/shardedserverdgram.hpp>
+
+/*
+ * Measures how the receive rate of inet_dgram_sharded_server scales with the
+ * number of shards.
+ *
+ * Usage: reuseport_pps [max_shards [flows [seconds]]]
+ *
+ * For 1, 2, 4, ... max_shards shards, `flows` local generator threads (like
+ * udp_loadgen) send 64 byte datagrams to the server on 127.0.0.1 for
+ * `seconds` seconds. The received datagrams per second and their distribution
+ * over the shards are printed. Generators and server share the machine, so
+ * use at most half of the CPUs for shards.
+ *
+ * Defaults: as many shards as CPUs, 8 flows, 3 seconds.
+ */
+
+using libsocket::dgram_batch;
+using libsocket::inet_dgram_client;
+using libsocket::inet_dgram_server;
+using libsocket::inet_dgram_sharded_server;
+
+static void generate(const struct addrinfo* dst, std::atomic<bool>* running) {
+    inet_dgram_client sock(LIBSOCKET_IPv4);
+    dgram_batch batch(64, 64);
+
+    for (size_t i = 0; i < batch.capacity(); i++) {
+        memset(batch.data(i), 'x', 64);
+        batch.set_length(i, 64);
+        batch.set_address(i, dst->ai_addr, dst->ai_addrlen);
+    }
+    batch.resize(batch.capacity());
+
+    while (*running) sock.sndmmsg(batch);
+}
+
+int main(int argc, char** argv) {
+    const size_t max_shards =
+        argc > 1 ? atoi(argv[1]) : std::thread::hardware_concurrency();
+    const size_t flows = argc > 2 ? atoi(argv[2]) : 8;
+    const int seconds = argc > 3 ? atoi(argv[3]) : 3;
+    const char* port = "4323";
+
+    struct addrinfo hint, *dst;
+
+    memset(&hint, 0, sizeof(hint));
+    hint.ai_family = AF_INET;
+    hint.ai_socktype = SOCK_DGRAM;
+    getaddrinfo("127.0.0.1", port, &hint, &dst);
+
+    try {
+        for (size_t shards = 1; shards <= max_shards; shards *= 2) {
+            inet_dgram_sharded_server srv("127.0.0.1", port, LIBSOCKET_IPv4,
+                                          shards);
+            std::unique_ptr<std::atomic<unsigned long long>[]> received(
+                new std::atomic<unsigned long long>[shards]);
+
+            for (size_t i = 0; i < shards; i++) received[i] = 0;
+
+            srv.start([&received](size_t shard, inet_dgram_server&,
+                                  dgram_batch& batch) {
+                received[shard] += batch.size();
+            });
+
+            std::atomic<bool> running(true);
+            std::vector<std::thread> generators;
+
+            for (size_t f = 0; f < flows; f++)
+                generators.emplace_back(generate, dst, &running);
+
+            std::this_thread::sleep_for(std::chrono::seconds(seconds));
+            running = false;
+
+            for (std::thread& t : generators) t.join();
+            srv.stop();
+
+            unsigned long long total = 0;
+
+            for (size_t i = 0; i < shards; i++) total += received[i];
+
+            std::cout << shards << " shard(s): " << total / seconds
+                      << " datagrams/s (";
+            for (size_t i = 0; i < shards; i++)
+                std::cout << (i ? " " : "") << 100 * received[i] / (total + 1)
+                          << "%";
+            std::cout << ")" << std::endl;
+        }
+    } catch (const libsocket::socket_exception& exc) {
+        std::cerr << exc.mesg;
+        return 1;
+    }
+
+    freeaddrinfo(dst);
+
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <libsocket/sessiontable.hpp>
+
+/*
+ * Cost of finding the per-peer state of a datagram: by the host and port
+ * strings (as returned by rcvfrom()) in an unordered_map, or by the binary
+ * address in a dgram_session_table.
+ *
+ * Usage: session_lookup [peers [lookups]]
+ *
+ * `lookups` source addresses are drawn at random from `peers` IPv4 peers,
+ * and the state of each is looked up the one way and the other. The string
+ * variant includes the getnameinfo(NI_NUMERICHOST | NI_NUMERICSERV) call that
+ * rcvfrom() does for every datagram.
+ *
+ * Defaults: 10000 peers, 5000000 lookups.
+ */
+
+using libsocket::dgram_session_table;
+using libsocket::timer_wheel;
+
+struct peer {
+    unsigned long packets = 0;
+};
+
+int main(int argc, char** argv) {
+    const size_t peers = argc > 1 ? atoi(argv[1]) : 10000;
+    const size_t lookups = argc > 2 ? atoi(argv[2]) : 5000000;
+
+    std::vector<struct sockaddr_in> addrs(peers);
+
+    for (size_t i = 0; i < peers; i++) {
+        memset(&addrs[i], 0, sizeof(addrs[i]));
+        addrs[i].sin_family = AF_INET;
+        addrs[i].sin_addr.s_addr = htonl(0x0a000000 + i / 16);
+        addrs[i].sin_port = htons(10000 + i % 16);
+    }
+
+    std::vector<unsigned int> order(lookups);
+
+    srand(1);
+    for (size_t i = 0; i < lookups; i++) order[i] = rand() % peers;
+
+    typedef std::chrono::steady_clock clock;
+    unsigned long check = 0;
+
+    {
+        std::unordered_map<std::string, peer> table;
+        char host[NI_MAXHOST], port[NI_MAXSERV];
+        auto start = clock::now();
+
+        for (size_t i = 0; i < lookups; i++) {
+            const struct sockaddr_in& a = addrs[order[i]];
+
+            getnameinfo(reinterpret_cast<const struct sockaddr*>(&a),
+                        sizeof(a), host, sizeof(host), port, sizeof(port),
+                        NI_NUMERICHOST | NI_NUMERICSERV);
+
+            check += ++table[std::string(host) + ":" + port].packets;
+        }
+
+        double ns = std::chrono::duration<double, std::nano>(clock::now() -
+                                                             start)
+                        .count();
+
+        std::cout << "strings:       " << ns / lookups << " ns per datagram"
+                  << std::endl;
+    }
+
+    {
+        dgram_session_table<peer> table(60 * 1000000ULL);
+        uint64_t now = timer_wheel::now();
+        auto start = clock::now();
+
+        for (size_t i = 0; i < lookups; i++) {
+            const struct sockaddr_in& a = addrs[order[i]];
+
+            check += ++table.get(reinterpret_cast<const struct sockaddr*>(&a),
+                                 now)->packets;
+        }
+
+        double ns = std::chrono::duration<double, std::nano>(clock::now() -
+                                                             start)
+                        .count();
+
+        std::cout << "session table: " << ns / lookups << " ns per datagram"
+                  << std::endl;
+    }
+
+    return check == 0;
+}
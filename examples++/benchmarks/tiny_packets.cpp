@@ -0,0 +1,77 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <chrono>
+#include <iostream>
+
+#include <libsocket/dgrambatch.hpp>
+#include <libsocket/exception.hpp>
+#include <libsocket/inetclientdgram.hpp>
+#include <libsocket/inetserverdgram.hpp>
+
+/*
+ * Send rate of small datagrams on a connected UDP socket: one snd() per
+ * datagram vs. dgram_batch::append() and one snd_batch() per batch.
+ *
+ * Usage: tiny_packets [count [size [batch]]]
+ *
+ * The datagrams go to a server socket on loopback that is never read, so
+ * most of them are dropped after the socket buffer has filled up; only the
+ * sender's cost is measured.
+ *
+ * Defaults: 2000000 datagrams of 16 bytes, batches of 64.
+ */
+
+using libsocket::dgram_batch;
+using libsocket::inet_dgram_client;
+using libsocket::inet_dgram_server;
+
+typedef std::chrono::steady_clock timer;
+
+static void report(const char* what, size_t count, timer::time_point start) {
+    double seconds =
+        std::chrono::duration<double>(timer::now() - start).count();
+
+    std::cout << what << count / seconds / 1e6 << " M datagrams/s"
+              << std::endl;
+}
+
+int main(int argc, char** argv) {
+    const size_t count = argc > 1 ? atoi(argv[1]) : 2000000;
+    const size_t size = argc > 2 ? atoi(argv[2]) : 16;
+    const size_t batch_size = argc > 3 ? atoi(argv[3]) : 64;
+
+    try {
+        inet_dgram_server sink("127.0.0.1", "4329", LIBSOCKET_IPv4);
+        inet_dgram_client sock("127.0.0.1", "4329", LIBSOCKET_IPv4);
+        char msg[2048];
+
+        memset(msg, 'x', sizeof(msg));
+
+        auto start = timer::now();
+
+        for (size_t i = 0; i < count; i++) sock.snd(msg, size);
+
+        report("snd():       ", count, start);
+
+        dgram_batch batch(batch_size, size);
+
+        start = timer::now();
+
+        for (size_t i = 0; i < count; i++) {
+            if (!batch.append(msg, size)) {
+                sock.snd_batch(batch);
+                batch.clear();
+                batch.append(msg, size);
+            }
+        }
+        sock.snd_batch(batch);
+
+        report("snd_batch(): ", count, start);
+    } catch (const libsocket::socket_exception& exc) {
+        std::cerr << exc.mesg;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include <netdb.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <libsocket/dgrambatch.hpp>
+#include <libsocket/exception.hpp>
+#include <libsocket/inetclientdgram.hpp>
+
+/*
+ * UDP load generator: sends datagrams as fast as possible using sendmmsg().
+ *
+ * Usage: udp_loadgen host port [flows [seconds [size]]]
+ *
+ * Every flow is a thread with its own socket (and thus source port), so a
+ * SO_REUSEPORT server sees `flows` different flows. Defaults: 4 flows, 5
+ * seconds, 64 byte datagrams.
+ */
+
+using libsocket::dgram_batch;
+using libsocket::inet_dgram_client;
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0]
+                  << " host port [flows [seconds [size]]]\n";
+        return 1;
+    }
+
+    const size_t flows = argc > 3 ? atoi(argv[3]) : 4;
+    const int seconds = argc > 4 ? atoi(argv[4]) : 5;
+    const size_t size = argc > 5 ? atoi(argv[5]) : 64;
+
+    struct addrinfo hint, *dst;
+
+    memset(&hint, 0, sizeof(hint));
+    hint.ai_socktype = SOCK_DGRAM;
+
+    if (0 != getaddrinfo(argv[1], argv[2], &hint, &dst)) {
+        std::cerr << "Could not resolve " << argv[1] << "\n";
+        return 1;
+    }
+
+    std::atomic<bool> running(true);
+    std::atomic<unsigned long long> sent(0);
+    std::vector<std::thread> threads;
+
+    for (size_t f = 0; f < flows; f++)
+        threads.emplace_back([&]() {
+            try {
+                inet_dgram_client sock(dst->ai_family == AF_INET6
+                                           ? LIBSOCKET_IPv6
+                                           : LIBSOCKET_IPv4);
+                dgram_batch batch(64, size);
+
+                for (size_t i = 0; i < batch.capacity(); i++) {
+                    memset(batch.data(i), 'x', size);
+                    batch.set_length(i, size);
+                    batch.set_address(i, dst->ai_addr, dst->ai_addrlen);
+                }
+                batch.resize(batch.capacity());
+
+                unsigned long long n = 0;
+
+                while (running) n += sock.sndmmsg(batch);
+
+                sent += n;
+            } catch (const libsocket::socket_exception& exc) {
+                std::cerr << exc.mesg;
+            }
+        });
+
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    running = false;
+
+    for (std::thread& t : threads) t.join();
+
+    std::cout << "sent " << sent << " datagrams, " << sent / seconds
+              << " per second\n";
+
+    freeaddrinfo(dst);
+
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include <stdlib.h>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <libsocket/exception.hpp>
+#include <libsocket/inetclientstream.hpp>
+#include <libsocket/inetserverstream.hpp>
+#include <libsocket/writequeue.hpp>
+
+/*
+ * Many threads sending small messages on one TCP connection: snd() under a
+ * mutex vs. write_queue.
+ *
+ * Usage: write_queue [threads] [messages per thread] [message size]
+ *
+ * A reader thread drains the other end of a loopback connection. With the
+ * mutex, every writer waits for the lock and makes its own send() call; with
+ * the queue, writers only append and whoever flushes sends many messages per
+ * writev() call.
+ *
+ * Defaults: 8 threads, 100000 messages of 64 bytes each.
+ */
+
+using libsocket::inet_stream;
+using libsocket::inet_stream_server;
+using libsocket::socket_exception;
+using libsocket::write_queue;
+
+typedef std::function<void(const std::string&)> sender;
+
+template <typename F>
+static double run(inet_stream_server& server, size_t threads, size_t messages,
+                  size_t size, F make_sender) {
+    inet_stream a("127.0.0.1", "47492", LIBSOCKET_IPv4);
+    std::unique_ptr<inet_stream> b = server.accept2(LIBSOCKET_NUMERIC);
+
+    const size_t total = threads * messages * size;
+
+    std::thread reader([&] {
+        char buf[65536];
+        size_t received = 0;
+
+        while (received < total) {
+            ssize_t n = b->rcv(buf, sizeof(buf));
+            if (n <= 0) break;
+            received += n;
+        }
+    });
+
+    sender send = make_sender(a);
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> writers;
+    for (size_t t = 0; t < threads; t++)
+        writers.emplace_back([&] {
+            std::string msg(size, 'x');
+            for (size_t i = 0; i < messages; i++) send(msg);
+        });
+
+    for (size_t t = 0; t < threads; t++) writers[t].join();
+    reader.join();
+
+    return threads * messages /
+           std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start)
+               .count();
+}
+
+int main(int argc, char** argv) {
+    const size_t threads = argc > 1 ? atoi(argv[1]) : 8;
+    const size_t messages = argc > 2 ? atoi(argv[2]) : 100000;
+    const size_t size = argc > 3 ? atoi(argv[3]) : 64;
+
+    try {
+        inet_stream_server server("127.0.0.1", "47492", LIBSOCKET_IPv4);
+
+        std::mutex lock;
+        double locked =
+            run(server, threads, messages, size, [&](inet_stream& sock) {
+                inet_stream* s = &sock;
+                return sender([&lock, s](const std::string& msg) {
+                    std::lock_guard<std::mutex> guard(lock);
+                    s->snd(msg.data(), msg.size());
+                });
+            });
+
+        std::unique_ptr<write_queue> queue;
+        double queued =
+            run(server, threads, messages, size, [&](inet_stream& sock) {
+                queue.reset(new write_queue(sock));
+                write_queue* q = queue.get();
+                return sender([q](const std::string& msg) {
+                    q->write(libsocket::byte_span(msg));
+                });
+            });
+
+        std::cout << threads << " threads, " << size
+                  << " byte messages:\n  mutex + snd(): " << locked / 1e6
+                  << " M msg/s\n  write_queue:   " << queued / 1e6
+                  << " M msg/s" << std::endl;
+    } catch (const socket_exception& exc) {
+        std::cerr << exc.mesg;
+        return 1;
+    }
+
+    return 0;
+}
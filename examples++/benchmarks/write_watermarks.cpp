@@ -0,0 +1,165 @@
+#include <fcntl.h>
+#include <linux/sockios.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <libsocket/epoll.hpp>
+#include <libsocket/exception.hpp>
+#include <libsocket/inetclientstream.hpp>
+#include <libsocket/inetserverstream.hpp>
+#include <libsocket/writequeue.hpp>
+
+/*
+ * A producer writing as fast as it can to a peer that reads slowly, through
+ * a write_queue without limits, with watermarks, and with watermarks plus
+ * TCP_NOTSENT_LOWAT.
+ *
+ * Usage: write_watermarks [seconds] [peer rate in KiB/s]
+ *
+ * Every message carries the time it was written; the peer reports how long
+ * messages took to arrive. Without limits, memory and latency grow for as
+ * long as the producer runs. Watermarks bound the queue, but the kernel still
+ * buffers megabytes in front of the peer; TCP_NOTSENT_LOWAT moves that data
+ * into the queue, where it is bounded too.
+ *
+ * Defaults: 2 seconds, 4096 KiB/s.
+ */
+
+using libsocket::epollset;
+using libsocket::inet_stream;
+using libsocket::inet_stream_server;
+using libsocket::socket_exception;
+using libsocket::write_queue;
+
+typedef std::chrono::steady_clock clk;
+
+static const size_t message_size = 64;
+
+static long long now_us(void) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               clk::now().time_since_epoch())
+        .count();
+}
+
+static void run(inet_stream_server& server, const char* name, double seconds,
+                size_t rate, size_t high, size_t low, unsigned int unsent) {
+    std::unique_ptr<inet_stream> sock(
+        new inet_stream("127.0.0.1", "47493", LIBSOCKET_IPv4));
+    std::unique_ptr<inet_stream> peer = server.accept2(LIBSOCKET_NUMERIC);
+
+    fcntl(sock->getfd(), F_SETFL, fcntl(sock->getfd(), F_GETFL) | O_NONBLOCK);
+
+    epollset<libsocket::socket> set;
+    write_queue queue(*sock);
+    std::mutex lock;
+    std::condition_variable resumed;
+
+    queue.watch(set);
+    if (high > 0) queue.set_watermarks(high, low, unsent);
+    queue.on_resume([&] {
+        std::lock_guard<std::mutex> guard(lock);
+        resumed.notify_all();
+    });
+
+    std::atomic<bool> stop(false);
+    const clk::time_point end =
+        clk::now() + std::chrono::duration_cast<clk::duration>(
+                         std::chrono::duration<double>(seconds));
+
+    std::thread loop([&] {
+        while (!stop) {
+            auto ready = set.wait(10);
+            for (size_t i = 0; i < ready.second.size(); i++)
+                if (ready.second[i] == sock.get()) queue.flush();
+        }
+    });
+
+    // The peer: reads `rate` bytes per second and measures latencies.
+    long long total_latency = 0, max_latency = 0, received = 0;
+    std::thread reader([&] {
+        char buf[4096];
+        size_t have = 0;
+        const long long pause = 1000000LL * sizeof(buf) / rate;
+
+        while (clk::now() < end) {
+            ssize_t n = ::read(peer->getfd(), buf + have, sizeof(buf) - have);
+            if (n <= 0) break;
+            have += n;
+
+            long long t = now_us();
+            size_t i = 0;
+            for (; i + message_size <= have; i += message_size) {
+                long long latency = t - atoll(buf + i);
+                total_latency += latency;
+                if (latency > max_latency) max_latency = latency;
+                received++;
+            }
+            memmove(buf, buf + i, have - i);
+            have -= i;
+
+            usleep(pause);
+        }
+    });
+
+    size_t max_queued = 0, max_kernel = 0;
+    char msg[message_size];
+
+    for (size_t n = 0; clk::now() < end; n++) {
+        snprintf(msg, sizeof(msg), "%-63lld", now_us());
+        msg[message_size - 1] = '\n';
+
+        if (!queue.write(libsocket::byte_span(msg, sizeof(msg)))) {
+            std::unique_lock<std::mutex> guard(lock);
+            resumed.wait_until(guard, end, [&] { return !queue.paused(); });
+        }
+
+        if (n % 256 == 0) {
+            int unsent_bytes = 0;
+            ioctl(sock->getfd(), SIOCOUTQNSD, &unsent_bytes);
+
+            if (queue.queued() > max_queued) max_queued = queue.queued();
+            if ((size_t)unsent_bytes > max_kernel) max_kernel = unsent_bytes;
+        }
+    }
+
+    reader.join();
+    stop = true;
+    loop.join();
+
+    std::cout << name << ":\n  queued, max:          " << max_queued / 1024
+              << " KiB\n  unsent in kernel, max: " << max_kernel / 1024
+              << " KiB\n  latency, mean:        "
+              << (received ? total_latency / received / 1000 : 0)
+              << " ms\n  latency, max:         " << max_latency / 1000
+              << " ms\n";
+}
+
+int main(int argc, char** argv) {
+    const double seconds = argc > 1 ? atof(argv[1]) : 2;
+    const size_t rate = (argc > 2 ? atoi(argv[2]) : 4096) * 1024;
+
+    try {
+        inet_stream_server server("127.0.0.1", "47493", LIBSOCKET_IPv4);
+
+        run(server, "no limits", seconds, rate, 0, 0, 0);
+        run(server, "watermarks 256/64 KiB", seconds, rate, 256 << 10,
+            64 << 10, 0);
+        run(server, "watermarks + TCP_NOTSENT_LOWAT 16 KiB", seconds, rate,
+            256 << 10, 64 << 10, 16384);
+    } catch (const socket_exception& exc) {
+        std::cerr << exc.mesg;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <libsocket/exception.hpp>
+#include <libsocket/inetclientstream.hpp>
+#include <libsocket/inetserverstream.hpp>
+
+/*
+ * Compares rcv() with rcv_mapped() over loopback.
+ *
+ * Usage: zerocopy_receive [port]
+ *
+ * A sender thread writes 1 GiB per run in 256 KiB chunks. For each read size,
+ * the receiver reads it once using rcv() and once using rcv_mapped(), and
+ * touches one byte per cache line so that both variants actually read the
+ * data.
+ *
+ * Data can only be mapped if the kernel has it in page-aligned pages. On
+ * loopback, this is the case if the sender uses MSG_ZEROCOPY from a
+ * page-aligned buffer, which is what the sender does here. With plain
+ * snd(), most of the data would be copied after all. The last column shows
+ * the share of bytes that were mapped.
+ */
+
+using libsocket::inet_stream;
+using libsocket::mapped_span;
+
+static const size_t total_bytes = 1 << 30;
+
+// Keeps the compiler from dropping touch().
+static volatile uint64_t checksum;
+
+static uint64_t touch(const char* data, size_t len) {
+    uint64_t sum = 0;
+
+    for (size_t i = 0; i < len; i += 64) sum += data[i];
+
+    return sum;
+}
+
+static void sender(libsocket::inet_stream_server* srv) {
+    const size_t chunk = 256 << 10;
+    std::unique_ptr<inet_stream> conn(srv->accept2());
+    void* buf;
+
+    if (0 != posix_memalign(&buf, 4096, chunk)) return;
+
+    memset(buf, 'x', chunk);
+    conn->set_zerocopy();
+
+    // The buffer never changes, so it is reused without waiting for the
+    // completions.
+    for (size_t sent = 0; sent < total_bytes;) {
+        uint32_t id;
+        ssize_t n = conn->snd_zerocopy(buf, chunk, &id);
+
+        if (n > 0) sent += n;
+
+        conn->reap_zerocopy([](const libsocket::zerocopy_completion&) {});
+    }
+
+    conn.reset();
+    free(buf);
+}
+
+int main(int argc, char** argv) {
+    std::string host = "127.0.0.1", port = argc > 1 ? argv[1] : "4322";
+
+    try {
+        libsocket::inet_stream_server srv(host, port, LIBSOCKET_IPv4);
+
+        std::cout << "read size\trcv() MiB/s\trcv_mapped() MiB/s\tmapped\n";
+
+        for (size_t size = 64 << 10; size <= (4 << 20); size *= 4) {
+            double rates[2];
+            size_t mapped_bytes = 0;
+
+            for (int mode = 0; mode < 2; mode++) {
+                std::thread t(sender, &srv);
+                inet_stream conn(host, port, LIBSOCKET_IPv4);
+                std::vector<char> buf(size);
+                mapped_span span;
+                size_t received = 0;
+                ssize_t n;
+
+                auto start = std::chrono::steady_clock::now();
+
+                do {
+                    if (mode == 0) {
+                        n = conn.rcv(buf.data(), size);
+                        if (n > 0) checksum += touch(buf.data(), n);
+                    } else {
+                        n = conn.rcv_mapped(&span, size);
+                        if (n > 0) checksum += touch(span.data(), n);
+                        if (span.mapped()) mapped_bytes += n;
+                    }
+                    received += n > 0 ? n : 0;
+                } while (n > 0);
+
+                std::chrono::duration<double> secs =
+                    std::chrono::steady_clock::now() - start;
+                rates[mode] = received / secs.count() / (1 << 20);
+
+                t.join();
+            }
+
+            std::cout << size << "\t\t" << rates[0] << "\t\t" << rates[1]
+                      << "\t\t\t" << 100.0 * mapped_bytes / total_bytes
+                      << "%\n";
+
+        }
+    } catch (const libsocket::socket_exception& exc) {
+        std::cerr << exc.mesg;
+        return 1;
+    }
+
+    return 0;
+}
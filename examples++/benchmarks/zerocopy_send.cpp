@@ -0,0 +1,144 @@
+#include <poll.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <libsocket/exception.hpp>
+#include <libsocket/inetclientstream.hpp>
+#include <libsocket/inetserverstream.hpp>
+
+/*
+ * Compares snd() with snd_zerocopy() for different send sizes.
+ *
+ * Usage: zerocopy_send [host port]
+ *
+ * Without arguments, a sink thread on 127.0.0.1 receives the data. Note that
+ * the kernel always copies data sent over loopback (all completions are
+ * reported as "copied"), so only the overhead of zero-copy mode can be seen
+ * there. For meaningful numbers, run a sink on another machine, e.g.
+ * `nc -l 4321 > /dev/null`, and pass its address.
+ */
+
+using libsocket::inet_stream;
+using libsocket::zerocopy_completion;
+
+static const size_t total_bytes = 1 << 28;
+static const size_t num_buffers = 32;
+
+static double run(inet_stream& sock, size_t size, bool zerocopy,
+                  size_t* copied) {
+    std::vector<std::unique_ptr<char[]>> buffers;
+    std::vector<size_t> pending(num_buffers, 0);
+    std::vector<size_t> owner(4096);
+
+    for (size_t i = 0; i < num_buffers; i++) {
+        buffers.emplace_back(new char[size]);
+        memset(buffers.back().get(), 'a' + i % 26, size);
+    }
+
+    auto release = [&](const zerocopy_completion& c) {
+        for (uint32_t id = c.first; id != c.last + 1; id++)
+            pending[owner[id % owner.size()]]--;
+        if (c.copied) (*copied)++;
+    };
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t sent = 0, i = 0; sent < total_bytes; i = (i + 1) % num_buffers) {
+        if (!zerocopy) {
+            sent += sock.snd(buffers[i].get(), size);
+            continue;
+        }
+
+        // Wait until the kernel is done with this buffer.
+        while (pending[i] > 0) {
+            struct pollfd pfd = {sock.getfd(), 0, 0};
+            poll(&pfd, 1, -1);
+            sock.reap_zerocopy(release);
+        }
+
+        uint32_t id;
+        ssize_t n = sock.snd_zerocopy(buffers[i].get(), size, &id);
+
+        if (n < 0) {  // ENOBUFS
+            sock.reap_zerocopy(release);
+            continue;
+        }
+
+        owner[id % owner.size()] = i;
+        pending[i]++;
+        sent += n;
+    }
+
+    for (size_t i = 0; i < num_buffers; i++)
+        while (pending[i] > 0) {
+            struct pollfd pfd = {sock.getfd(), 0, 0};
+            poll(&pfd, 1, -1);
+            sock.reap_zerocopy(release);
+        }
+
+    std::chrono::duration<double> secs =
+        std::chrono::steady_clock::now() - start;
+
+    return total_bytes / secs.count() / (1 << 20);
+}
+
+int main(int argc, char** argv) {
+    std::string host = "127.0.0.1", port = "4321";
+    std::unique_ptr<std::thread> sink;
+
+    try {
+        if (argc == 3) {
+            host = argv[1];
+            port = argv[2];
+        } else {
+            std::shared_ptr<libsocket::inet_stream_server> srv(
+                new libsocket::inet_stream_server(host, port,
+                                                  LIBSOCKET_IPv4));
+
+            sink.reset(new std::thread([srv]() {
+                std::vector<char> buf(1 << 20);
+
+                while (true) {
+                    std::unique_ptr<inet_stream> conn(srv->accept2());
+
+                    while (conn->rcv(buf.data(), buf.size()) > 0)
+                        ;
+                }
+            }));
+            sink->detach();
+        }
+
+        std::cout << "size\tcopy MiB/s\tzerocopy MiB/s\tcopied completions\n";
+
+        for (size_t size = 4096; size <= (1 << 20); size *= 2) {
+            size_t copied = 0;
+            double copy_rate, zc_rate;
+
+            // One connection at a time; the sink only serves one.
+            {
+                inet_stream plain(host, port, LIBSOCKET_IPv4);
+                copy_rate = run(plain, size, false, &copied);
+            }
+            {
+                inet_stream zc(host, port, LIBSOCKET_IPv4);
+                zc.set_zerocopy();
+                zc_rate = run(zc, size, true, &copied);
+            }
+
+            std::cout << size << "\t" << copy_rate << "\t\t" << zc_rate
+                      << "\t\t" << copied << std::endl;
+        }
+    } catch (const libsocket::socket_exception& exc) {
+        std::cerr << exc.mesg;
+        return 1;
+    }
+
+    return 0;
+}
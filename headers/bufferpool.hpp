@@ -0,0 +1,148 @@
+#ifndef LIBSOCKET_BUFFERPOOL_H_B837F248DD2B4A70A1A445BDA4BFA2FE
+#define LIBSOCKET_BUFFERPOOL_H_B837F248DD2B4A70A1A445BDA4BFA2FE
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+/**
+ * @file bufferpool.hpp
+ * @brief Fixed-size receive buffers from a slab pool.
+ */
+/*
+   The committers of the libsocket project, all rights reserved
+   (c) 2012, dermesser <lbo@spheniscida.de>
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS” AND ANY
+   EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+   DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+namespace libsocket {
+
+/**
+ * @addtogroup libsocketplusplus
+ * @{
+ */
+
+struct buffer_pool_state;
+struct buffer_block;
+
+/**
+ * @brief A reference-counted handle to a buffer from a `buffer_pool`.
+ *
+ * Copies of a handle refer to the same buffer; when the last one is destroyed
+ * (or `reset()`), the buffer goes back to its pool. A buffer has a fixed
+ * `capacity()` and a `size()`, the number of valid bytes, which the receive
+ * functions taking a `pooled_buffer` set. The size is shared by all copies.
+ *
+ * A handle may be passed between threads; copying and destroying handles of
+ * the same buffer concurrently is safe, writing to the buffer is not.
+ */
+class pooled_buffer {
+   public:
+    pooled_buffer(void) : block(nullptr) {}
+    pooled_buffer(const pooled_buffer& other);
+    pooled_buffer(pooled_buffer&& other) : block(other.block) {
+        other.block = nullptr;
+    }
+    ~pooled_buffer(void) { reset(); }
+
+    pooled_buffer& operator=(const pooled_buffer& other);
+    pooled_buffer& operator=(pooled_buffer&& other);
+
+    char* data(void) const;
+    size_t size(void) const;
+    size_t capacity(void) const;
+    bool empty(void) const { return size() == 0; }
+    void resize(size_t n);
+
+    /// Whether the handle refers to a buffer.
+    explicit operator bool(void) const { return block != nullptr; }
+    size_t use_count(void) const;
+
+    void reset(void);
+
+   private:
+    friend class buffer_pool;
+
+    explicit pooled_buffer(buffer_block* b) : block(b) {}
+
+    buffer_block* block;
+};
+
+/**
+ * @brief A pool of fixed-size buffers, allocated in large slabs.
+ *
+ * Allocating a receive buffer per message with `new` or `std::vector` costs a
+ * `malloc(3)`/`free(3)` pair each time and, with messages of varying size,
+ * fragments the heap of a long-running server. A buffer_pool hands out
+ * buffers of one size from slabs of `slab_size` bytes that are mapped with
+ * `mmap(2)` when needed and never returned to the system while the pool
+ * exists; released buffers are reused.
+ *
+ * Each thread keeps up to `thread_cache` released buffers of a pool, from
+ * which `get()` takes them without locking. The shared free list is protected
+ * by a mutex and exchanges buffers with the threads' caches in batches.
+ *
+ * With `hugepages` set, slabs are mapped with `MAP_HUGETLB` (Linux), which
+ * needs configured huge pages (`vm.nr_hugepages`); if that fails, transparent
+ * huge pages are requested with `madvise(2)` instead. Use a `slab_size` that
+ * is a multiple of the huge page size (2 MiB on x86-64).
+ *
+ * With `max_slabs`, `get()` throws once all slabs are in use; buffers cached
+ * by other threads do not count as free then.
+ *
+ * The pool is threadsafe. Buffers may outlive the pool; the slabs are unmapped
+ * once the pool is destroyed and all its buffers have been released, which
+ * for buffers in other threads' caches is the next time those threads use a
+ * pool, or when they exit.
+ */
+class buffer_pool {
+   public:
+    /// Parameters of a pool.
+    struct settings {
+        size_t buffer_size = 2048;      ///< Bytes per buffer
+        size_t slab_size = 1 << 21;     ///< Bytes per slab (rounded up)
+        size_t max_slabs = 0;           ///< 0 for no limit
+        size_t thread_cache = 64;       ///< Per thread; 0 disables the caches
+        bool hugepages = false;         ///< Try to back slabs by huge pages
+    };
+
+    buffer_pool(void);
+    explicit buffer_pool(const settings& s);
+    buffer_pool(const buffer_pool&) = delete;
+    ~buffer_pool(void);
+
+    pooled_buffer get(void);
+
+    size_t buffer_size(void) const;
+    size_t slabs(void) const;
+    size_t available(void) const;
+
+   private:
+    buffer_pool_state* state;
+};
+
+/**
+ * @}
+ */
+}  // namespace libsocket
+#endif
@@ -0,0 +1,122 @@
+#ifndef LIBSOCKET_BYTESPAN_H_71C5A20B86F84D838E360D16F1A345FC
+#define LIBSOCKET_BYTESPAN_H_71C5A20B86F84D838E360D16F1A345FC
+
+#include <stddef.h>
+#include <string.h>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#if __cplusplus >= 201703L
+#include <string_view>
+/// Whether the `std::string_view` overloads are available (C++17).
+#define LIBSOCKET_HAVE_STRING_VIEW 1
+#else
+#define LIBSOCKET_HAVE_STRING_VIEW 0
+#endif
+
+/**
+ * @file bytespan.hpp
+ * @brief Views of bytes and strings owned by the caller.
+ */
+/*
+   The committers of the libsocket project, all rights reserved
+   (c) 2012, dermesser <lbo@spheniscida.de>
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS” AND ANY
+   EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+   DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+namespace libsocket {
+
+/**
+ * @addtogroup libsocketplusplus
+ * @{
+ */
+
+/**
+ * @brief A read-only view of bytes owned by the caller.
+ *
+ * Functions taking a `byte_span` accept any contiguous container of one-byte
+ * elements, e.g. `std::string`, `std::vector<char>`, `std::vector<uint8_t>`,
+ * `std::array<char, N>`, `std::string_view` or `mapped_span`, without copying
+ * it. A pointer and a length are passed as `byte_span(ptr, len)`.
+ *
+ * The view does not keep the container alive.
+ */
+class byte_span {
+   public:
+    byte_span(void) : ptr(nullptr), len(0) {}
+    byte_span(const void* data, size_t size)
+        : ptr(static_cast<const char*>(data)), len(size) {}
+    template <typename Container,
+              typename = typename std::enable_if<
+                  sizeof(*std::declval<const Container&>().data()) == 1>::type>
+    byte_span(const Container& c)
+        : ptr(reinterpret_cast<const char*>(c.data())), len(c.size()) {}
+
+    const char* data(void) const { return ptr; }
+    size_t size(void) const { return len; }
+    bool empty(void) const { return len == 0; }
+
+   private:
+    const char* ptr;
+    size_t len;
+};
+
+#if LIBSOCKET_HAVE_STRING_VIEW
+/**
+ * @brief A null-terminated copy of a `std::string_view`.
+ *
+ * Host names, ports and paths have to be null-terminated for the C layer.
+ * Strings shorter than `N` are copied into a buffer on the stack; longer ones
+ * into a `std::string`, so the function receiving them can report that they
+ * are too long.
+ */
+template <size_t N = 256>
+class c_string {
+   public:
+    explicit c_string(std::string_view s) {
+        if (s.size() < N) {
+            memcpy(small, s.data(), s.size());
+            small[s.size()] = 0;
+            str = small;
+        } else {
+            large.assign(s);
+            str = large.c_str();
+        }
+    }
+    c_string(const c_string&) = delete;
+
+    const char* c_str(void) const { return str; }
+
+   private:
+    char small[N];
+    std::string large;
+    const char* str;
+};
+#endif
+
+/**
+ * @}
+ */
+}  // namespace libsocket
+#endif
@@ -0,0 +1,153 @@
+#ifndef LIBSOCKET_CONNECTIONPOOL_H_F0C55F063B9A4035896523361AA25D84
+#define LIBSOCKET_CONNECTIONPOOL_H_F0C55F063B9A4035896523361AA25D84
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+
+#include "libinetsocket.h"
+#include "streamclient.hpp"
+
+/**
+ * @file connectionpool.hpp
+ * @brief Reusing idle stream connections.
+ */
+/*
+   The committers of the libsocket project, all rights reserved
+   (c) 2012, dermesser <lbo@spheniscida.de>
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS” AND ANY
+   EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+   DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+namespace libsocket {
+using std::string;
+
+/**
+ * @addtogroup libsocketplusplus
+ * @{
+ */
+
+struct connection_pool_state;
+
+/**
+ * @brief Keeps idle client connections open for reuse.
+ *
+ * `get_inet()` and `get_unix()` hand out a `lease` on a connection to the
+ * given endpoint: an idle one if there is one, otherwise a new one. When the
+ * lease is destroyed, the connection goes back to the pool, unless it was shut
+ * down or `discard()`ed -- discard a connection whenever the protocol state is
+ * unclear, e.g. after an exception in the middle of a request.
+ *
+ * Endpoints are identified by host, port and protocol (`LIBSOCKET_IPv4`,
+ * `LIBSOCKET_IPv6` or `LIBSOCKET_BOTH`), or by the path of a UNIX socket,
+ * together with the `socket(2)` flags; a `get_inet()` with `SOCK_NONBLOCK`
+ * never returns a blocking connection and vice versa. For each endpoint, at
+ * most `max_idle` connections are kept. A connection is closed instead of
+ * reused when it has been idle for longer than `max_idle_ms` or open for
+ * longer than `max_age_ms` (so load balancers and DNS changes are eventually
+ * noticed).
+ *
+ * Before an idle connection is handed out, it is checked with
+ * `recv(MSG_PEEK | MSG_DONTWAIT)`: a connection the server has closed (EOF),
+ * or on which unexpected data has arrived, is closed and the next one tried.
+ *
+ * The pool is threadsafe. Each thread keeps up to `thread_cache` connections
+ * it returned in a thread-local list, from which it takes them again without
+ * any locking; only connections beyond that go through the pool's shared,
+ * mutex-protected list (where other threads can pick them up). Leases are
+ * meant to be used by one thread at a time. If the pool is destroyed, the
+ * connections in other threads' lists are closed the next time those threads
+ * use a pool, or when they exit.
+ */
+class connection_pool {
+   public:
+    /// Limits on idle connections.
+    struct limits {
+        size_t max_idle = 8;            ///< Per endpoint, in the shared list
+        uint64_t max_idle_ms = 30000;   ///< Close connections idle longer
+        uint64_t max_age_ms = 300000;   ///< Close connections older than this
+        size_t thread_cache = 4;        ///< Per thread; 0 disables the lists
+    };
+
+    /**
+     * @brief A connection checked out from a pool.
+     *
+     * Movable, not copyable. Returns the connection to the pool when
+     * destroyed.
+     */
+    class lease {
+       public:
+        lease(void);
+        lease(lease&& other);
+        lease& operator=(lease&& other);
+        lease(const lease&) = delete;
+        ~lease(void);
+
+        /// The connection; NULL for an empty lease.
+        stream_client_socket* get(void) const { return sock.get(); }
+        stream_client_socket* operator->(void) const { return sock.get(); }
+        stream_client_socket& operator*(void) const { return *sock; }
+        explicit operator bool(void) const { return bool(sock); }
+
+        /// Whether the connection has been used before.
+        bool reused(void) const { return was_reused; }
+
+        void discard(void);
+        std::unique_ptr<stream_client_socket> release(void);
+
+       private:
+        friend class connection_pool;
+
+        std::weak_ptr<connection_pool_state> pool;
+        string host;
+        string port;
+        int proto;
+        int flags;
+        std::unique_ptr<stream_client_socket> sock;
+        uint64_t created;  ///< Microseconds, CLOCK_MONOTONIC
+        bool was_reused;
+    };
+
+    connection_pool(void);
+    explicit connection_pool(const limits& lim);
+    connection_pool(const connection_pool&) = delete;
+    ~connection_pool(void);
+
+    lease get_inet(const string& host, const string& port,
+                   int proto_osi3 = LIBSOCKET_BOTH, int flags = 0);
+    lease get_unix(const string& path, int flags = 0);
+
+    size_t idle(void) const;
+    void prune(void);
+
+   private:
+    std::shared_ptr<connection_pool_state> state;
+
+    lease get(const string& host, const string& port, int proto, int flags);
+    static void put_back(lease& l);
+};
+
+/**
+ * @}
+ */
+}  // namespace libsocket
+#endif
@@ -0,0 +1,139 @@
+#ifndef LIBSOCKET_DGRAMBATCH_H_EA14EBF393C446128663553193EBAF27
+#define LIBSOCKET_DGRAMBATCH_H_EA14EBF393C446128663553193EBAF27
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <time.h>
+#include <memory>
+
+/**
+ * @file dgrambatch.hpp
+ * @brief [LINUX-only] Preallocated message headers for sending and receiving
+ * many datagrams with one system call (`sendmmsg(2)`/`recvmmsg(2)`).
+ */
+/*
+   The committers of the libsocket project, all rights reserved
+   (c) 2012, dermesser <lbo@spheniscida.de>
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS” AND ANY
+   EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+   DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+namespace libsocket {
+
+/**
+ * @addtogroup libsocketplusplus
+ * @{
+ */
+
+/**
+ * @brief A set of datagrams, each with its buffer, peer address and optional
+ * control data, for use with the batch functions (e.g.
+ * `inet_dgram::rcvmmsg()`).
+ *
+ * Everything is allocated once by the constructor, so receiving or sending a
+ * batch does not allocate memory. Every entry either uses a buffer owned by
+ * the batch (of `dgram_size` bytes) or, after `set_buffer()`, memory owned by
+ * the caller, so datagrams can be received into or sent from their final
+ * place without another copy.
+ *
+ * After a receive call, `size()` is the number of datagrams received, and
+ * `data()`, `length()` and `address()` describe each of them. If the socket
+ * has receive timestamps enabled (`socket::set_timestamps()`) and the batch
+ * was created with a control size of at least `timestamp_control_size`,
+ * `timestamp()` returns when the kernel received each datagram. Likewise,
+ * `destination()` returns the address each datagram was sent to (e.g. the
+ * multicast group) if `IP_PKTINFO`/`IPV6_RECVPKTINFO` is enabled and there
+ * is room for `destination_control_size` more bytes. For sending,
+ * fill the entries using `set_length()` (or `set_buffer()`) and
+ * `set_address()`, and set the number of entries with `resize()`; or copy
+ * small datagrams into the batch one after another with `append()`.
+ *
+ * THIS CLASS IS NOT THREADSAFE.
+ */
+class dgram_batch {
+   public:
+    /// Control buffer size (per entry) that holds a receive timestamp.
+    static const size_t timestamp_control_size =
+        CMSG_SPACE(3 * sizeof(struct timespec));
+    /// Control buffer size (per entry) that holds the destination address.
+    static const size_t destination_control_size =
+        CMSG_SPACE(sizeof(struct in6_pktinfo));
+
+    dgram_batch(size_t count, size_t dgram_size = 2048,
+                size_t control_size = 0);
+    dgram_batch(const dgram_batch&) = delete;
+
+    /// Number of entries.
+    size_t capacity(void) const { return count; }
+    /// Number of entries received by the last receive call, or to be sent.
+    size_t size(void) const { return filled; }
+    void resize(size_t n);
+    /// Remove all entries, e.g. before `append()`ing new ones.
+    void clear(void) { filled = 0; }
+
+    bool append(const void* buf, size_t len);
+    bool append(const void* buf, size_t len, const struct sockaddr* addr,
+                socklen_t addrlen);
+
+    char* data(size_t i);
+    const char* data(size_t i) const;
+    size_t length(size_t i) const;
+    bool truncated(size_t i) const;
+    void set_length(size_t i, size_t len);
+    void set_buffer(size_t i, void* buf, size_t len);
+
+    const struct sockaddr* address(size_t i) const;
+    socklen_t address_length(size_t i) const;
+    void set_address(size_t i, const struct sockaddr* addr, socklen_t len);
+
+    const struct msghdr* header(size_t i) const;
+    bool timestamp(size_t i, struct timespec* stamp) const;
+    bool destination(size_t i, struct sockaddr_storage* dst) const;
+
+    /// Raw header array, e.g. for calling `recvmmsg(2)` directly.
+    struct mmsghdr* headers(void) { return hdrs.get(); }
+
+    void prepare_receive(void);
+    void prepare_send(bool with_addresses);
+    void finish_receive(size_t n);
+
+   private:
+    size_t count;
+    size_t filled;
+    size_t control_size;
+
+    std::unique_ptr<struct mmsghdr[]> hdrs;
+    std::unique_ptr<struct iovec[]> iovs;
+    std::unique_ptr<size_t[]> capacities;  ///< Buffer size of each entry
+    std::unique_ptr<struct sockaddr_storage[]> addrs;
+    std::unique_ptr<char[]> buffers;
+    std::unique_ptr<char[]> controls;
+
+    void check_index(size_t i, const char* function) const;
+};
+
+/**
+ * @}
+ */
+}  // namespace libsocket
+#endif
@@ -4,6 +4,8 @@
 #include <string.h>
 #include <unistd.h>
 #include <string>
+#include <system_error>
+#include "bytespan.hpp"
 #include "socket.hpp"
 
 /**
@@ -40,6 +42,8 @@
 
 namespace libsocket {
 using std::string;
+class dgram_batch;
+class pooled_buffer;
 
 /**
  * @addtogroup libsocketplusplus
@@ -64,14 +68,30 @@ class dgram_client_socket : public virtual socket {
                                            const char* str);
     friend dgram_client_socket& operator<<(dgram_client_socket& sock,
                                            const string& str);
+#if LIBSOCKET_HAVE_STRING_VIEW
+    friend dgram_client_socket& operator<<(dgram_client_socket& sock,
+                                           std::string_view str);
+#endif
 
     ssize_t snd(const void* buf, size_t len, int flags = 0);  // flags: send()
+    ssize_t snd(byte_span data, int flags = 0);
 
     // I
     friend dgram_client_socket& operator>>(dgram_client_socket& sock,
                                            string& dest);
 
     ssize_t rcv(void* buf, size_t len, int flags = 0);
+    ssize_t rcv(pooled_buffer& buf, int flags = 0);
+
+    // Non-throwing
+    ssize_t snd(const void* buf, size_t len, std::error_code& ec,
+                int flags = 0);
+    ssize_t snd(byte_span data, std::error_code& ec, int flags = 0);
+    ssize_t rcv(void* buf, size_t len, std::error_code& ec, int flags = 0);
+
+    // Batches [Linux]
+    int snd_batch(dgram_batch& batch, int flags = 0);
+    int rcv_batch(dgram_batch& batch, int flags = 0);
 
     // @deprecated
     bool getconn(void) const;
@@ -95,6 +95,9 @@ class dgram_over_stream {
     ssize_t sndmsg(const std::vector<uint8_t>& msg);
     ssize_t rcvmsg(std::vector<uint8_t>* dst);
 
+    ssize_t sndmsg(byte_span msg);
+    ssize_t rcvmsg(pooled_buffer* dst);
+
    private:
     static const size_t RECV_BUF_SIZE = 256;
 
@@ -0,0 +1,160 @@
+#ifndef LIBSOCKET_DGRAMPACER_H_0CDBC480E1154BCC8295B9F224C11BC5
+#define LIBSOCKET_DGRAMPACER_H_0CDBC480E1154BCC8295B9F224C11BC5
+
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <time.h>
+#include <string>
+#include <vector>
+
+#include "socket.hpp"
+#include "timerwheel.hpp"
+
+/**
+ * @file dgrampacer.hpp
+ * @brief [LINUX-only] Sending datagrams at a limited rate per destination.
+ */
+/*
+   The committers of the libsocket project, all rights reserved
+   (c) 2012, dermesser <lbo@spheniscida.de>
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS” AND ANY
+   EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+   DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+namespace libsocket {
+using std::string;
+
+/**
+ * @addtogroup libsocketplusplus
+ * @{
+ */
+
+/**
+ * @brief Counters of a `dgram_pacer` destination.
+ */
+struct pacer_stats {
+    unsigned long long datagrams;  ///< Datagrams sent
+    unsigned long long bytes;      ///< Bytes sent
+    double rate;          ///< Bytes per second sent since the first datagram
+    size_t queued;        ///< Datagrams waiting in the pacer
+    size_t queued_bytes;  ///< Bytes waiting in the pacer (or, with
+                          ///< `pace_txtime`, held back by the kernel)
+};
+
+/**
+ * @brief Sends datagrams no faster than a given rate per destination, so
+ * bursts do not overrun the receivers' socket buffers.
+ *
+ * Each destination (a peer address, or the peer of a connected socket) has a
+ * token bucket: `rate` bytes per second, and up to `burst` bytes at once.
+ * How a datagram exceeding the bucket is delayed depends on the mode:
+ *
+ * - `pace_user`: The datagram is copied into the destination's queue and sent
+ *   by `flush()` once there are enough tokens. Destinations waiting for tokens
+ *   are kept in a `timer_wheel`; drive the pacer from your event loop:
+ *
+ *         auto ready = set.wait(pacer.next_timeout());
+ *         ...
+ *         pacer.flush();
+ *
+ * - `pace_txtime`: The datagram is sent at once, with a departure time
+ *   (`SO_TXTIME`) computed from the bucket; the kernel holds it back until
+ *   then. This needs a qdisc that honours departure times on the outgoing
+ *   interface; other qdiscs send immediately. `fq` takes departure times of
+ *   `CLOCK_MONOTONIC`, the default. `etf` drops datagrams whose clock differs
+ *   from its own, usually `CLOCK_TAI`; pass that clock to the constructor.
+ * - `pace_socket`: The kernel paces the whole socket to the sum of all
+ *   destination rates (`SO_MAX_PACING_RATE`); datagrams are sent at once.
+ *   This needs the `fq` qdisc and is only per-destination with one
+ *   destination, e.g. on a connected socket.
+ *
+ * The pacer does not own the socket, which may be any datagram socket (e.g.
+ * `inet_dgram_server`, or a connected `inet_dgram_client`).
+ *
+ * THIS CLASS IS NOT THREADSAFE.
+ */
+class dgram_pacer {
+   public:
+    enum mode { pace_user, pace_txtime, pace_socket };
+
+    dgram_pacer(socket& sock, mode m = pace_user, size_t queue_limit = 1024,
+                clockid_t txtime_clock = CLOCK_MONOTONIC);
+    dgram_pacer(const dgram_pacer&) = delete;
+
+    size_t add_destination(const string& host, const string& port,
+                           uint64_t rate, size_t burst = 0);
+    size_t add_destination(const struct sockaddr* addr, socklen_t len,
+                           uint64_t rate, size_t burst = 0);
+    size_t add_destination(uint64_t rate, size_t burst = 0);
+    void set_rate(size_t dest, uint64_t rate, size_t burst = 0);
+
+    ssize_t send(size_t dest, const void* buf, size_t len);
+    size_t flush(void);
+    int next_timeout(void) const;
+
+    pacer_stats stats(size_t dest) const;
+    pacer_stats stats(void) const;
+
+   private:
+    struct destination {
+        struct sockaddr_storage addr;
+        socklen_t addrlen;  ///< 0 for the peer of a connected socket
+
+        double rate;    ///< Bytes per second; 0 for unlimited
+        double burst;   ///< Bucket size in bytes
+        double tokens;  ///< May become negative (with `pace_txtime`)
+        uint64_t updated;
+
+        std::vector<string> queue;  ///< Ring buffer of `queue_limit` entries
+        size_t head;
+        size_t queued;
+        size_t queued_bytes;
+        bool scheduled;  ///< Has a timer in the wheel
+
+        unsigned long long datagrams;
+        unsigned long long bytes;
+        uint64_t first;
+    };
+
+    socket& sock;
+    mode how;
+    size_t limit;
+    clockid_t clock;  ///< Clock of `SO_TXTIME` departure times
+    std::vector<destination> dests;
+    timer_wheel wheel;
+
+    destination& get(size_t dest, const char* function);
+    void refill(destination& d, uint64_t now);
+    bool may_send(const destination& d, size_t len) const;
+    ssize_t transmit(destination& d, const void* buf, size_t len,
+                     uint64_t departure, int flags);
+    void drain(destination& d, size_t index, uint64_t now, size_t* sent);
+    void wake(destination& d, size_t index, uint64_t now);
+    void set_socket_rate(void);
+};
+
+/**
+ * @}
+ */
+}  // namespace libsocket
+#endif
@@ -78,6 +78,7 @@ class epollset {
     ~epollset(void);
 
     void add_fd(SocketT& sock, int method);
+    void mod_fd(SocketT& sock, int method);
     void del_fd(const SocketT& sock);
     ready_socks wait(int timeout = -1);
 
@@ -152,6 +153,30 @@ void epollset<SocketT>::add_fd(SocketT& sock, int method) {
                                string("epoll_ctl failed: ") + strerror(errno));
 }
 
+/**
+ * @brief Change the events a socket in an `epollset` is watched for.
+ *
+ * @param sock A socket previously added with `add_fd()`.
+ * @param method Any combination of `LIBSOCKET_READ` and `LIBSOCKET_WRITE`, or 0
+ * to only be notified of errors and hangups.
+ */
+template <typename SocketT>
+void epollset<SocketT>::mod_fd(SocketT& sock, int method) {
+    struct epoll_event new_event;
+
+    new_event.data.ptr = 0;
+    new_event.events = 0;
+
+    if (method & LIBSOCKET_READ) new_event.events |= EPOLLIN;
+    if (method & LIBSOCKET_WRITE) new_event.events |= EPOLLOUT;
+
+    new_event.data.ptr = &sock;
+
+    if (0 > epoll_ctl(epollfd, EPOLL_CTL_MOD, sock.getfd(), &new_event))
+        throw socket_exception(__FILE__, __LINE__,
+                               string("epoll_ctl failed: ") + strerror(errno));
+}
+
 /**
  * @brief Remove a file descriptor from an epoll set.
  *
@@ -180,6 +205,9 @@ void epollset<SocketT>::del_fd(const SocketT& sock) {
  * from socket pointers to some identification code. Using that mapping, you
  * will be able to identify the sockets.
  *
+ * Sockets with a pending error or hangup are returned as ready for reading, so
+ * that the following read reports it.
+ *
  * *Hint 2*: It never does any harm to check the length of the returned
  * `vector`s; with the included example `http_epoll.cpp`, spurious
  * empty-returning epoll calls could be observed. However, it is not clear if
@@ -195,9 +223,9 @@ typename epollset<SocketT>::ready_socks epollset<SocketT>::wait(int timeout) {
                                string("epoll_wait failed: ") + strerror(errno));
 
     for (int i = 0; i < nfds; i++) {
-        if (events[i].events == EPOLLIN)
+        if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
             ready.first.push_back(static_cast<SocketT*>(events[i].data.ptr));
-        if (events[i].events == EPOLLOUT)
+        if (events[i].events & EPOLLOUT)
             ready.second.push_back(static_cast<SocketT*>(events[i].data.ptr));
     }
 
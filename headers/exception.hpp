@@ -2,6 +2,7 @@
 #define LIBSOCKET_EXCEPTION_H_07F57E018FF44ADBB169FA2F685EA87E
 
 #include <string>
+#include <system_error>
 
 /**
  * @file exception.hpp
@@ -62,6 +63,24 @@ struct socket_exception {
     socket_exception(const string& file, int line, const string& message,
                      bool show_errno = true);
 };
+
+/**
+ * @brief Error category for `getaddrinfo(3)` errors (`EAI_*`).
+ *
+ * Building a `socket_exception` costs a string for every error, which adds up
+ * when errors are expected (peer resets, refused health checks). Therefore the
+ * I/O functions `snd()`, `rcv()`, `sndto()`, `rcvfrom()`, `accept()` and
+ * `connect()` have overloads taking a `std::error_code&` after their required
+ * arguments. These never throw `socket_exception`; on failure they set the
+ * error code (`errno` values in `std::system_category()`, failed name lookups
+ * in this category) and return -1, `nullptr` or nothing. A non-blocking socket
+ * without data or buffer space fails with `std::errc::operation_would_block`.
+ * On success the error code is cleared.
+ *
+ * Messages are only built when calling `message()` on the error code.
+ */
+const std::error_category& addrinfo_category(void);
+std::error_code addrinfo_error(int gai_error);
 /**
  * @}
  */
@@ -2,6 +2,7 @@
 #define LIBSOCKET_INETBASE_H_6EDE111E3CDD4B07A94ECF4BD4E353C1
 
 #include <string>
+#include "bytespan.hpp"
 #include "libinetsocket.h"
 #include "socket.hpp"
 /**
@@ -58,9 +59,14 @@ class inet_socket : public virtual socket {
     /// Which internet protocol version we're using
     int proto;
 
-    /// ip and port of the client itself
-    string hostClient;
-    string portClient;
+    /// ip and port of the client itself; looked up by gethostClient() or
+    /// getportClient() on first use
+    mutable string hostClient;
+    mutable string portClient;
+    /// Whether hostClient/portClient are valid for the current connection
+    mutable bool clientKnown;
+
+    void forget_client(void);
 
    public:
     inet_socket();
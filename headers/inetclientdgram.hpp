@@ -3,6 +3,8 @@
 
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <stdint.h>
+#include <functional>
 #include <string>
 
 #include "dgramclient.hpp"
@@ -66,9 +68,28 @@ class inet_dgram_client : public inet_dgram, public dgram_client_socket {
     // connect/reconnect
     void connect(const char* dsthost, const char* dstport);
     void connect(const string& dsthost, const string& dstport);
+    void connect(const char* dsthost, const char* dstport,
+                 std::error_code& ec);
+    void connect(const string& dsthost, const string& dstport,
+                 std::error_code& ec);
+#if LIBSOCKET_HAVE_STRING_VIEW
+    inet_dgram_client(std::string_view dsthost, std::string_view dstport,
+                      int proto_osi3, int flags = 0);
+    void connect(std::string_view dsthost, std::string_view dstport);
+    void connect(std::string_view dsthost, std::string_view dstport,
+                 std::error_code& ec);
+#endif
 
     void deconnect(void);
 
+    // Path MTU [Linux]
+    enum pmtu_mode { pmtu_dont, pmtu_do, pmtu_probe };
+
+    void set_pmtu_discovery(pmtu_mode mode = pmtu_do);
+    int path_mtu(void) const;
+    size_t max_payload(void) const;
+    size_t reap_pmtu(const std::function<void(uint32_t)>& callback);
+
    private:
     void setup(int proto_osi3, int flags = 0);
     void setup(const char* dsthost, const char* dstport, int proto_osi3,
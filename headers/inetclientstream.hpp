@@ -60,14 +60,36 @@ class inet_stream : public inet_socket, public stream_client_socket {
                 int flags = 0);
 
     void connect(const char* dsthost, const char* dstport, int proto_osi3,
-                 int flags = 0);  // flags: socket()
+                 int flags = 0, int attempt_delay = 250);  // flags: socket()
     void connect(const string& dsthost, const string& dstport, int proto_osi3,
-                 int flags = 0);
+                 int flags = 0, int attempt_delay = 250);
+    void connect(const char* dsthost, const char* dstport, int proto_osi3,
+                 std::error_code& ec, int flags = 0, int attempt_delay = 250);
+    void connect(const string& dsthost, const string& dstport, int proto_osi3,
+                 std::error_code& ec, int flags = 0, int attempt_delay = 250);
+#if LIBSOCKET_HAVE_STRING_VIEW
+    inet_stream(std::string_view dsthost, std::string_view dstport,
+                int proto_osi3, int flags = 0);
+    void connect(std::string_view dsthost, std::string_view dstport,
+                 int proto_osi3, int flags = 0, int attempt_delay = 250);
+    void connect(std::string_view dsthost, std::string_view dstport,
+                 int proto_osi3, std::error_code& ec, int flags = 0,
+                 int attempt_delay = 250);
+#endif
+
+    ssize_t connect_fastopen(const char* dsthost, const char* dstport,
+                             int proto_osi3, const void* buf, size_t len,
+                             int flags = 0);
+    ssize_t connect_fastopen(const string& dsthost, const string& dstport,
+                             int proto_osi3, const void* buf, size_t len,
+                             int flags = 0);
+    bool fastopen_accepted(void) const;
 
     friend class inet_stream_server;  ///< `inet_stream_server` is our friend so
                                       ///< he may manipulate private members as
                                       ///< `sfd` when returning an instance
                                       ///< (e.g. at `accept()`)
+    friend class inet_stream_connector;  ///< Sets up the sockets it connects
 };
 /**
  * @}
@@ -4,6 +4,7 @@
 #include <string.h>
 #include <iostream>
 #include <string>
+#include <system_error>
 
 #include "inetbase.hpp"
 
@@ -45,6 +46,8 @@
 
 namespace libsocket {
 using std::string;
+class dgram_batch;
+class pooled_buffer;
 
 /**
  * @addtogroup libsocketplusplus
@@ -68,6 +71,16 @@ class inet_dgram : public inet_socket {
 
     ssize_t sndto(const string& buf, const string& dsthost,
                   const string& dstport, int sndto_flags = 0);
+#if LIBSOCKET_HAVE_STRING_VIEW
+    ssize_t sndto(const void* buf, size_t len, std::string_view dsthost,
+                  std::string_view dstport, int sndto_flags = 0);
+    ssize_t sndto(byte_span buf, std::string_view dsthost,
+                  std::string_view dstport, int sndto_flags = 0);
+#endif
+
+    ssize_t sndto_zerocopy(const void* buf, size_t len, const string& dsthost,
+                           const string& dstport, uint32_t* id,
+                           int sndto_flags = 0);
 
     // I
     ssize_t rcvfrom(void* buf, size_t len, char* srchost, size_t hostlen,
@@ -78,6 +91,58 @@ class inet_dgram : public inet_socket {
 
     ssize_t rcvfrom(string& buf, string& srchost, string& srcport,
                     int rcvfrom_flags = 0, bool numeric = false);
+
+    ssize_t rcvfrom(void* buf, size_t len, string& srchost, string& srcport,
+                    struct timespec* stamp, int rcvfrom_flags = 0,
+                    bool numeric = false);
+
+    ssize_t rcvfrom(pooled_buffer& buf, string& srchost, string& srcport,
+                    int rcvfrom_flags = 0, bool numeric = false);
+
+    // Non-throwing
+    ssize_t sndto(const void* buf, size_t len, const char* dsthost,
+                  const char* dstport, std::error_code& ec,
+                  int sndto_flags = 0);
+    ssize_t sndto(const void* buf, size_t len, const string& dsthost,
+                  const string& dstport, std::error_code& ec,
+                  int sndto_flags = 0);
+#if LIBSOCKET_HAVE_STRING_VIEW
+    ssize_t sndto(const void* buf, size_t len, std::string_view dsthost,
+                  std::string_view dstport, std::error_code& ec,
+                  int sndto_flags = 0);
+#endif
+    ssize_t rcvfrom(void* buf, size_t len, char* srchost, size_t hostlen,
+                    char* srcport, size_t portlen, std::error_code& ec,
+                    int rcvfrom_flags = 0, bool numeric = false);
+    ssize_t rcvfrom(void* buf, size_t len, string& srchost, string& srcport,
+                    std::error_code& ec, int rcvfrom_flags = 0,
+                    bool numeric = false);
+
+    // Segmentation offload [Linux]
+    ssize_t sndto_segmented(const void* buf, size_t len, size_t segment_size,
+                            const string& dsthost, const string& dstport,
+                            int sndto_flags = 0);
+    ssize_t snd_segmented(const void* buf, size_t len, size_t segment_size,
+                          int snd_flags = 0);
+
+    void set_gro(bool enable = true);
+    ssize_t rcvfrom_coalesced(void* buf, size_t len, size_t* segment_size,
+                              string& srchost, string& srcport,
+                              int rcvfrom_flags = 0, bool numeric = false);
+    ssize_t rcv_coalesced(void* buf, size_t len, size_t* segment_size,
+                          int rcv_flags = 0);
+
+    // Batches [Linux]
+    int rcvmmsg(dgram_batch& batch, int flags = 0);
+    int sndmmsg(dgram_batch& batch, int flags = 0);
+
+   private:
+    ssize_t send_segmented(const void* buf, size_t len, size_t segment_size,
+                           const struct sockaddr* dst, socklen_t dstlen,
+                           int flags);
+    ssize_t recv_message(void* buf, size_t len, struct sockaddr_storage* src,
+                         socklen_t* srclen, int flags, size_t* segment_size,
+                         struct timespec* stamp);
 };
 /**
  * @}
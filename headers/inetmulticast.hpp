@@ -0,0 +1,120 @@
+#ifndef LIBSOCKET_INETMULTICAST_H_A1C130FC5D8F4A11ADB27396B4E16DCE
+#define LIBSOCKET_INETMULTICAST_H_A1C130FC5D8F4A11ADB27396B4E16DCE
+
+#include <sys/socket.h>
+#include <string>
+#include <vector>
+
+#include "inetserverdgram.hpp"
+
+/**
+ * @file inetmulticast.hpp
+ * @brief [LINUX-only] UDP socket receiving from many multicast groups.
+ */
+/*
+   The committers of the libsocket project, all rights reserved
+   (c) 2012, dermesser <lbo@spheniscida.de>
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS” AND ANY
+   EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+   DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+namespace libsocket {
+using std::string;
+
+/**
+ * @addtogroup libsocketplusplus
+ * @{
+ */
+
+/**
+ * @brief A UDP socket that is a member of any number of multicast groups.
+ *
+ * The socket is bound to the wildcard address and the given port (with
+ * `SO_REUSEADDR`, so several processes can receive the same groups). Groups
+ * are joined with `join()`, or for source-specific multicast with
+ * `join_source()`; both use the protocol-independent `MCAST_JOIN_GROUP`
+ * options and may be called for as many groups as needed. Datagrams of all
+ * joined groups arrive on this socket and can be received with the usual
+ * functions, or in batches with `rcvmmsg()`.
+ *
+ * A socket bound to the wildcard address normally also receives datagrams for
+ * groups that *other* sockets on the host have joined on the same port. The
+ * constructor turns that off (`IP_MULTICAST_ALL`), so only the groups joined
+ * here are delivered; use `set_multicast_all()` to turn it back on.
+ *
+ * To find out which group a datagram was sent to, call
+ * `set_destination_info()` and create the batch with (at least)
+ * `dgram_batch::destination_control_size`; `dgram_batch::destination()` then
+ * returns the group address.
+ *
+ * Note that Linux limits the number of groups per socket
+ * (`net.ipv4.igmp_max_memberships`, 20 by default) and the number of sources
+ * per group (`net.ipv4.igmp_max_msf`, 10 by default); `join()` throws when the
+ * limit is reached. IPv6 has no such limits.
+ *
+ * For sending, `set_interface()`, `set_hops()` and `set_loop()` configure the
+ * outgoing multicast datagrams; any socket of this class may send to a group
+ * using `sndto()` or `sndmmsg()`, whether or not it is a member.
+ */
+class inet_multicast : public inet_dgram_server {
+   public:
+    inet_multicast(const string& port, int proto_osi3 = LIBSOCKET_IPv4,
+                   int flags = 0);
+
+    void join(const string& group, const string& interface = "");
+    void leave(const string& group, const string& interface = "");
+    void join_source(const string& group, const string& source,
+                     const string& interface = "");
+    void leave_source(const string& group, const string& source,
+                      const string& interface = "");
+
+    /// Number of groups (and group/source pairs) currently joined.
+    size_t memberships(void) const { return members.size(); }
+
+    void set_multicast_all(bool enable);
+    void set_destination_info(bool enable = true);
+
+    void set_interface(const string& interface);
+    void set_hops(int hops);
+    void set_loop(bool enable);
+
+   private:
+    struct membership {
+        struct sockaddr_storage group;
+        struct sockaddr_storage source;  ///< `ss_family` 0 for any source
+        unsigned int interface;
+    };
+
+    int family;  ///< `AF_INET` or `AF_INET6`
+    std::vector<membership> members;
+
+    void resolve(const string& addr, struct sockaddr_storage* ss) const;
+    unsigned int interface_index(const string& interface) const;
+    std::vector<membership>::iterator find(const membership& m);
+    void change(const membership& m, int option, const char* function);
+};
+
+/**
+ * @}
+ */
+}  // namespace libsocket
+#endif
@@ -60,6 +60,10 @@ namespace libsocket {
                           const OptionalDgram& anOptional = {});
         inet_dgram_server(const string& host, const string& port, int proto_osi3,
                           const OptionalDgram& anOptional = {});
+#if LIBSOCKET_HAVE_STRING_VIEW
+        inet_dgram_server(std::string_view host, std::string_view port,
+                          int proto_osi3, const OptionalDgram& anOptional = {});
+#endif
 
     private:
         void setup(const char* host, const char* port, int proto_osi3,
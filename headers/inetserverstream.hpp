@@ -5,6 +5,7 @@
 #include "inetclientstream.hpp"
 
 #include <memory>
+#include <system_error>
 
 /**
  * @file inetserverstream.hpp
@@ -44,6 +45,7 @@ using std::unique_ptr;
 struct OptionalStream{
     int flags = 0;                  ///< Флаги для accept
     std::vector<int> sockOptFlags;  ///< Флаги, которые будут выставлены на сокет после его создания, но до bind
+    int fastOpenQueue = 0;          ///< Длина очереди TCP Fast Open (0 - выключено), только Linux
 };
 
 /**
@@ -73,10 +75,22 @@ public:
                const OptionalStream& anOptional = {});
     void setup(const string& bindhost, const string& bindport, int proto_osi3,
                const OptionalStream& anOptional = {});
+#if LIBSOCKET_HAVE_STRING_VIEW
+    inet_stream_server(std::string_view bindhost, std::string_view bindport,
+                       int proto_osi3, const OptionalStream& anOptional = {});
+    void setup(std::string_view bindhost, std::string_view bindport,
+               int proto_osi3, const OptionalStream& anOptional = {});
+#endif
 
     inet_stream* accept(int numeric = 0, int accept_flags = 0);
     unique_ptr<inet_stream> accept2(int numeric = 0, int accept_flags = 0);
 
+    // Non-throwing
+    inet_stream* accept(std::error_code& ec, int numeric = 0,
+                        int accept_flags = 0);
+    unique_ptr<inet_stream> accept2(std::error_code& ec, int numeric = 0,
+                                    int accept_flags = 0);
+
     const string& getbindhost(void);
     const string& getbindport(void);
 };
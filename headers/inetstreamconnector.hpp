@@ -0,0 +1,190 @@
+#ifndef LIBSOCKET_INETSTREAMCONNECTOR_H_5D13B55BDBA34DCA8426A343612DCA60
+#define LIBSOCKET_INETSTREAMCONNECTOR_H_5D13B55BDBA34DCA8426A343612DCA60
+
+#include <netdb.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "inetclientstream.hpp"
+
+/**
+ * @file inetstreamconnector.hpp
+ * @brief Connecting to all addresses of a host at once ("Happy Eyeballs").
+ */
+/*
+   The committers of the libsocket project, all rights reserved
+   (c) 2012, dermesser <lbo@spheniscida.de>
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS” AND ANY
+   EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+   DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+namespace libsocket {
+using std::string;
+
+/**
+ * @addtogroup libsocketplusplus
+ * @{
+ */
+
+/**
+ * @brief Connects a TCP socket to the first reachable address of a host,
+ * following RFC 8305 ("Happy Eyeballs v2").
+ *
+ * The addresses returned by `getaddrinfo(3)` are reordered so IPv6 and IPv4
+ * addresses alternate, starting with the family the resolver preferred. The
+ * connector starts a non-blocking connect to the first one; if it has not
+ * succeeded after `attempt_delay` milliseconds (or as soon as it fails), the
+ * next one is started while the first keeps trying, and so on. The first
+ * attempt to succeed wins and the others are closed. An unreachable address
+ * family therefore costs `attempt_delay` instead of the kernel's connect
+ * timeout.
+ *
+ * `inet_stream::connect()` uses a connector and waits for it. To connect
+ * without blocking, drive the connector from an `epollset` (or `poll(2)`):
+ *
+ *     epollset<libsocket::socket> set;
+ *     inet_stream_connector conn("example.com", "443");
+ *
+ *     conn.watch(set);
+ *
+ *     while (...) {
+ *         auto ready = set.wait(conn.timeout());
+ *         // Sockets of the connector may be among the ready ones; they are
+ *         // not meant for you. Then:
+ *         if (conn.update(set)) {
+ *             std::unique_ptr<inet_stream> sock = conn.result();  // may throw
+ *             ...
+ *         }
+ *     }
+ *
+ * `update()` adds new attempts to the set and removes finished ones, so at
+ * the end none of the connector's sockets is left in it. The set's socket
+ * type has to be a base class of `inet_stream` (e.g. `socket`).
+ *
+ * THIS CLASS IS NOT THREADSAFE.
+ */
+class inet_stream_connector {
+   public:
+    inet_stream_connector(const string& host, const string& port,
+                          int proto_osi3 = LIBSOCKET_BOTH, int flags = 0,
+                          int attempt_delay = 250);
+    inet_stream_connector(const struct addrinfo* addresses, int flags = 0,
+                          int attempt_delay = 250);
+    inet_stream_connector(const inet_stream_connector&) = delete;
+
+    bool step(int wait = 0);
+    /// Whether a connection has been established, or all attempts failed.
+    bool done(void) const { return succeeded || failed; }
+    int timeout(void) const;
+
+    std::unique_ptr<inet_stream> result(void);
+    std::unique_ptr<inet_stream> result(std::error_code& ec);
+
+    template <typename SetT>
+    void watch(SetT& set);
+    template <typename SetT>
+    bool update(SetT& set);
+
+   private:
+    struct address {
+        struct sockaddr_storage addr;
+        socklen_t len;
+    };
+    struct attempt {
+        std::unique_ptr<inet_stream> sock;
+        bool watched;  ///< Is in the caller's set
+    };
+
+    std::vector<address> addresses;
+    size_t next;  ///< First address not tried yet
+    std::vector<attempt> running;
+    std::vector<std::unique_ptr<inet_stream>> finished;  ///< To be unwatched
+
+    std::unique_ptr<inet_stream> winner;
+    bool winner_watched;
+    bool succeeded;
+    bool failed;
+    int error;  ///< errno of the last failed attempt
+
+    int flags;
+    int delay;
+    uint64_t last_start;  ///< Milliseconds, CLOCK_MONOTONIC
+    bool start_now;       ///< An attempt failed; don't wait for `delay`
+
+    string host;
+    string port;
+    int proto;
+
+    void set_addresses(const struct addrinfo* list);
+    void start(uint64_t now);
+    void complete(size_t i);
+    void fail(size_t i, int err);
+};
+
+/**
+ * @brief Add the running attempts to an `epollset`.
+ */
+template <typename SetT>
+void inet_stream_connector::watch(SetT& set) {
+    for (size_t i = 0; i < running.size(); i++) {
+        if (running[i].watched) continue;
+
+        set.add_fd(*running[i].sock, LIBSOCKET_WRITE);
+        running[i].watched = true;
+    }
+}
+
+/**
+ * @brief Advance the connector and bring `set` up to date.
+ *
+ * Call this whenever `set` reports one of the connector's sockets, and when
+ * `timeout()` has expired.
+ *
+ * @returns `done()`; the connector's sockets have been removed from `set` then.
+ */
+template <typename SetT>
+bool inet_stream_connector::update(SetT& set) {
+    step(0);
+
+    for (size_t i = 0; i < finished.size(); i++) set.del_fd(*finished[i]);
+    finished.clear();
+
+    if (done()) {
+        if (winner && winner_watched) set.del_fd(*winner);
+        winner_watched = false;
+        return true;
+    }
+
+    watch(set);
+
+    return false;
+}
+
+/**
+ * @}
+ */
+}  // namespace libsocket
+#endif
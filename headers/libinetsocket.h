@@ -82,6 +82,8 @@ extern int accept_inet_stream_socket(int sfd, char* src_host,
 extern int get_address_family(const char* hostname);
 
 #ifdef __linux__
+extern ssize_t sendfile_inet_stream_socket(int sfd, int fd, off_t* offset,
+                                           size_t count);
 extern int create_multicast_socket(const char* group, const char* port,
                                    const char* local);
 #endif
@@ -61,6 +61,11 @@ extern ssize_t recvfrom_unix_dgram_socket(int sfd, void* buf, size_t size,
 extern ssize_t sendto_unix_dgram_socket(int sfd, const void* buf, size_t size,
                                         const char* path, int sendto_flags);
 
+#ifdef __linux__
+extern ssize_t sendfile_unix_stream_socket(int sfd, int fd, off_t* offset,
+                                           size_t count);
+#endif
+
 #ifdef __cplusplus
 #ifdef MIXED
 }
@@ -0,0 +1,90 @@
+#ifndef LIBSOCKET_MAPPEDSPAN_H_6B475D972FE24674873C7AA89BEF89BF
+#define LIBSOCKET_MAPPEDSPAN_H_6B475D972FE24674873C7AA89BEF89BF
+
+#include <stddef.h>
+#include <memory>
+
+/**
+ * @file mappedspan.hpp
+ *
+ * Contains the mapped_span class, which holds data received by
+ * `stream_client_socket::rcv_mapped()`.
+ */
+/*
+   The committers of the libsocket project, all rights reserved
+   (c) 2012, dermesser <lbo@spheniscida.de>
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS” AND ANY
+   EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+   DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+namespace libsocket {
+
+/**
+ * @addtogroup libsocketplusplus
+ * @{
+ */
+
+/**
+ * @brief Read-only data received from a stream socket, either mapped from the
+ * kernel's receive queue or copied into a buffer owned by the span.
+ *
+ * A mapped_span is filled by `stream_client_socket::rcv_mapped()`. If the data
+ * is mapped (`mapped()` is true), the pages are unmapped when the span is
+ * destroyed, reused or `release()`d; until then they also count against the
+ * socket's receive buffer, so spans should not be kept for long.
+ *
+ * Spans can be moved, but not copied.
+ */
+class mapped_span {
+   public:
+    mapped_span(void);
+    mapped_span(mapped_span&& other);
+    mapped_span(const mapped_span&) = delete;
+    ~mapped_span(void);
+
+    mapped_span& operator=(mapped_span&& other);
+
+    /// First byte of the data.
+    const char* data(void) const { return begin; }
+    /// Number of bytes.
+    size_t size(void) const { return length; }
+    /// If the data was mapped instead of copied.
+    bool mapped(void) const { return map_address != NULL; }
+
+    void release(void);
+
+   private:
+    friend class stream_client_socket;
+
+    const char* begin;
+    size_t length;
+
+    void* map_address;             ///< Start of the mapped region, or NULL
+    size_t map_length;             ///< Size of the mapped region
+    std::unique_ptr<char[]> copy;  ///< Holds the data if it was copied
+};
+
+/**
+ * @}
+ */
+}  // namespace libsocket
+#endif
@@ -0,0 +1,461 @@
+#ifndef LIBSOCKET_POLICYSOCKET_H_9841E5B270BA4E5CB6425CF660E69CF2
+#define LIBSOCKET_POLICYSOCKET_H_9841E5B270BA4E5CB6425CF660E69CF2
+
+/*
+   The committers of the libsocket project, all rights reserved
+   (c) 2012, dermesser <lbo@spheniscida.de>
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS” AND ANY
+   EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+   DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+/**
+ * @file policysocket.hpp
+ * @brief Sockets configured at compile time.
+ *
+ * This template file contains policy_socket, a socket whose behaviour
+ * (stream/datagram, blocking, error reporting, argument checks) is chosen by
+ * template parameters instead of run-time flags.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <memory>
+#include <system_error>
+
+#include "exception.hpp"
+#include "socket.hpp"
+#include "streamhandle.hpp"
+
+namespace libsocket {
+/**
+ * @addtogroup libsocketplusplus
+ * @{
+ */
+
+/**
+ * @brief Policies for `policy_socket`.
+ */
+namespace policy {
+/// Connected stream socket (TCP, UNIX stream)
+struct stream {
+    static const int type = SOCK_STREAM;
+};
+/// Datagram socket (UDP, UNIX datagram); adds `sndto()` and `rcvfrom()`
+struct datagram {
+    static const int type = SOCK_DGRAM;
+};
+
+/// Calls block unless the descriptor is non-blocking.
+struct blocking {
+    static const bool dontwait = false;
+    static const int msg_flags = 0;
+};
+/// Every call uses `MSG_DONTWAIT`, whatever the mode of the descriptor.
+/// Returns -1 instead of failing with `EWOULDBLOCK`.
+struct nonblocking {
+    static const bool dontwait = true;
+    static const int msg_flags = MSG_DONTWAIT;
+};
+
+/// Errors throw `socket_exception`.
+struct exceptions {
+    static const bool throws = true;
+};
+/// Errors return -1 with `errno` set, like the system calls.
+struct error_codes {
+    static const bool throws = false;
+};
+
+/// The descriptor and buffer are checked before each call.
+struct checked {
+    static const bool enabled = true;
+};
+/// No checks; the kernel reports a closed descriptor as `EBADF`.
+struct unchecked {
+    static const bool enabled = false;
+};
+}  // namespace policy
+
+/**
+ * @brief A socket whose options are template parameters.
+ *
+ * The classes of libsocket++ decide at run time whether a socket is shut down,
+ * closed or non-blocking, and whether an error is thrown. A `policy_socket`
+ * takes these decisions at compile time, so that its I/O functions compile
+ * down to the system call and one test of the result:
+ *
+ * - `Kind`: `policy::stream` or `policy::datagram`
+ * - `Blocking`: `policy::blocking` or `policy::nonblocking`
+ * - `Errors`: `policy::exceptions` or `policy::error_codes`; concerns the
+ *   plain I/O functions. The overloads taking a `std::error_code&` work with
+ *   both policies.
+ * - `Checks`: `policy::checked` or `policy::unchecked`
+ *
+ * For example, an event loop might use
+ *
+ *     typedef policy_socket<policy::stream, policy::nonblocking,
+ *                           policy::error_codes, policy::unchecked> conn;
+ *
+ * A `policy_socket` owns a file descriptor and nothing else; it is move-only
+ * and closes the descriptor when destroyed. It takes over the descriptor of
+ * an existing socket object (e.g. an `inet_stream` after connecting, or an
+ * `inet_dgram_client`), a `stream_handle` or a raw descriptor, and can be used
+ * with `epollset`. Shutdown state is not tracked; the kernel reports I/O after
+ * `shutdown(2)`. Constructors throw `socket_exception` whatever the `Errors`
+ * policy is.
+ */
+template <typename Kind, typename Blocking = policy::blocking,
+          typename Errors = policy::exceptions,
+          typename Checks = policy::checked>
+class policy_socket {
+   public:
+    policy_socket(void) : fd(-1) {}
+    explicit policy_socket(int descriptor);
+    explicit policy_socket(std::unique_ptr<socket> sock);
+    explicit policy_socket(stream_handle&& handle);
+    policy_socket(const policy_socket&) = delete;
+    policy_socket(policy_socket&& other) : fd(other.fd) { other.fd = -1; }
+    ~policy_socket(void) { destroy(); }
+
+    policy_socket& operator=(const policy_socket&) = delete;
+    policy_socket& operator=(policy_socket&& other);
+
+    int getfd(void) const { return fd; }
+    explicit operator bool(void) const { return fd >= 0; }
+
+    int release(void);
+    int destroy(void);
+
+    ssize_t snd(const void* buf, size_t len, int flags = 0);
+    ssize_t rcv(void* buf, size_t len, int flags = 0);
+    ssize_t snd(const void* buf, size_t len, std::error_code& ec,
+                int flags = 0);
+    ssize_t rcv(void* buf, size_t len, std::error_code& ec, int flags = 0);
+
+    // Datagram only
+    ssize_t sndto(const void* buf, size_t len, const struct sockaddr* dst,
+                  socklen_t dstlen, int flags = 0);
+    ssize_t rcvfrom(void* buf, size_t len, struct sockaddr_storage* src,
+                    socklen_t* srclen, int flags = 0);
+    ssize_t sndto(const void* buf, size_t len, const struct sockaddr* dst,
+                  socklen_t dstlen, std::error_code& ec, int flags = 0);
+    ssize_t rcvfrom(void* buf, size_t len, struct sockaddr_storage* src,
+                    socklen_t* srclen, std::error_code& ec, int flags = 0);
+
+   private:
+    int fd;
+
+    static void check_type(int descriptor);
+    int bad_arguments(const void* buf, size_t len) const;
+    ssize_t result(ssize_t ret, const char* message) const;
+    ssize_t result(ssize_t ret, std::error_code& ec) const;
+};
+
+/**
+ * @brief Take ownership of a descriptor.
+ *
+ * With `policy::checked`, throws if it is not a socket of the right type; the
+ * descriptor is not closed then.
+ */
+template <typename K, typename B, typename E, typename C>
+policy_socket<K, B, E, C>::policy_socket(int descriptor) : fd(-1) {
+    check_type(descriptor);
+
+    fd = descriptor;
+}
+
+/**
+ * @brief Take over the descriptor of a socket object.
+ *
+ * `sock` is destroyed without closing the descriptor. With `policy::checked`,
+ * throws if it is not a socket of the right type; `sock` is destroyed as
+ * usual then.
+ */
+template <typename K, typename B, typename E, typename C>
+policy_socket<K, B, E, C>::policy_socket(std::unique_ptr<socket> sock)
+    : fd(-1) {
+    if (!sock) return;
+
+    check_type(sock->sfd);
+
+    fd = sock->sfd;
+    sock->sfd = -1;
+}
+
+/**
+ * @brief Take over the descriptor of a `stream_handle`.
+ */
+template <typename K, typename B, typename E, typename C>
+policy_socket<K, B, E, C>::policy_socket(stream_handle&& handle)
+    : fd(handle.release()) {
+    static_assert(K::type == SOCK_STREAM,
+                  "policy_socket: stream_handle needs policy::stream");
+}
+
+template <typename K, typename B, typename E, typename C>
+policy_socket<K, B, E, C>& policy_socket<K, B, E, C>::operator=(
+    policy_socket&& other) {
+    if (this != &other) {
+        destroy();
+
+        fd = other.fd;
+        other.fd = -1;
+    }
+
+    return *this;
+}
+
+/**
+ * @brief Give up ownership of the descriptor.
+ *
+ * @returns The descriptor, which the caller has to close.
+ */
+template <typename K, typename B, typename E, typename C>
+int policy_socket<K, B, E, C>::release(void) {
+    int ret = fd;
+
+    fd = -1;
+
+    return ret;
+}
+
+/**
+ * @brief Close the socket.
+ *
+ * @retval 0 Closed, or there was no descriptor.
+ * @retval -1 `close(2)` failed.
+ */
+template <typename K, typename B, typename E, typename C>
+int policy_socket<K, B, E, C>::destroy(void) {
+    if (fd < 0) return 0;
+
+    int ret = close(fd);
+
+    fd = -1;
+
+    return ret < 0 ? -1 : 0;
+}
+
+/**
+ * @brief Send data (to the connected peer).
+ *
+ * @returns The number of bytes sent. -1 if no data was sent because of
+ * `policy::nonblocking`, or on errors with `policy::error_codes`.
+ */
+template <typename K, typename B, typename E, typename C>
+ssize_t policy_socket<K, B, E, C>::snd(const void* buf, size_t len,
+                                       int flags) {
+    if (C::enabled && bad_arguments(buf, len))
+        return result(-1, "policy_socket::snd() - Bad arguments!");
+
+    return result(::send(fd, buf, len, flags | B::msg_flags),
+                  "policy_socket::snd() - Error while sending!");
+}
+
+/**
+ * @brief Receive data.
+ *
+ * @returns The number of bytes received; 0 on EOF (stream). -1 if there was no
+ * data with `policy::nonblocking`, or on errors with `policy::error_codes`.
+ */
+template <typename K, typename B, typename E, typename C>
+ssize_t policy_socket<K, B, E, C>::rcv(void* buf, size_t len, int flags) {
+    if (C::enabled && bad_arguments(buf, len))
+        return result(-1, "policy_socket::rcv() - Bad arguments!");
+
+    return result(::recv(fd, buf, len, flags | B::msg_flags),
+                  "policy_socket::rcv() - Error while reading!");
+}
+
+/**
+ * @brief Send data, reporting errors in `ec`.
+ *
+ * @returns The number of bytes sent, or -1.
+ */
+template <typename K, typename B, typename E, typename C>
+ssize_t policy_socket<K, B, E, C>::snd(const void* buf, size_t len,
+                                       std::error_code& ec, int flags) {
+    if (C::enabled && bad_arguments(buf, len)) return result(-1, ec);
+
+    return result(::send(fd, buf, len, flags | B::msg_flags), ec);
+}
+
+/**
+ * @brief Receive data, reporting errors in `ec`.
+ *
+ * @returns The number of bytes received, or -1.
+ */
+template <typename K, typename B, typename E, typename C>
+ssize_t policy_socket<K, B, E, C>::rcv(void* buf, size_t len,
+                                       std::error_code& ec, int flags) {
+    if (C::enabled && bad_arguments(buf, len)) return result(-1, ec);
+
+    return result(::recv(fd, buf, len, flags | B::msg_flags), ec);
+}
+
+/**
+ * @brief Send a datagram to `dst`.
+ *
+ * Addresses are passed as they are to the kernel; resolve host names once,
+ * e.g. with `resolver::lookup()`.
+ */
+template <typename K, typename B, typename E, typename C>
+ssize_t policy_socket<K, B, E, C>::sndto(const void* buf, size_t len,
+                                         const struct sockaddr* dst,
+                                         socklen_t dstlen, int flags) {
+    static_assert(K::type == SOCK_DGRAM,
+                  "policy_socket::sndto() needs policy::datagram");
+
+    if (C::enabled && (bad_arguments(buf, len) || (errno = EINVAL, !dst)))
+        return result(-1, "policy_socket::sndto() - Bad arguments!");
+
+    return result(::sendto(fd, buf, len, flags | B::msg_flags, dst, dstlen),
+                  "policy_socket::sndto() - Error while sending!");
+}
+
+/**
+ * @brief Receive a datagram and its sender's address.
+ *
+ * @param src Set to the sender's address; may be NULL
+ * @param srclen The size of `*src`; set to the length of the address
+ */
+template <typename K, typename B, typename E, typename C>
+ssize_t policy_socket<K, B, E, C>::rcvfrom(void* buf, size_t len,
+                                           struct sockaddr_storage* src,
+                                           socklen_t* srclen, int flags) {
+    static_assert(K::type == SOCK_DGRAM,
+                  "policy_socket::rcvfrom() needs policy::datagram");
+
+    if (C::enabled && bad_arguments(buf, len))
+        return result(-1, "policy_socket::rcvfrom() - Bad arguments!");
+
+    return result(::recvfrom(fd, buf, len, flags | B::msg_flags,
+                             reinterpret_cast<struct sockaddr*>(src), srclen),
+                  "policy_socket::rcvfrom() - Error while reading!");
+}
+
+/**
+ * @brief Send a datagram to `dst`, reporting errors in `ec`.
+ */
+template <typename K, typename B, typename E, typename C>
+ssize_t policy_socket<K, B, E, C>::sndto(const void* buf, size_t len,
+                                         const struct sockaddr* dst,
+                                         socklen_t dstlen, std::error_code& ec,
+                                         int flags) {
+    static_assert(K::type == SOCK_DGRAM,
+                  "policy_socket::sndto() needs policy::datagram");
+
+    if (C::enabled && (bad_arguments(buf, len) || (errno = EINVAL, !dst)))
+        return result(-1, ec);
+
+    return result(::sendto(fd, buf, len, flags | B::msg_flags, dst, dstlen),
+                  ec);
+}
+
+/**
+ * @brief Receive a datagram and its sender's address, reporting errors in
+ * `ec`.
+ */
+template <typename K, typename B, typename E, typename C>
+ssize_t policy_socket<K, B, E, C>::rcvfrom(void* buf, size_t len,
+                                           struct sockaddr_storage* src,
+                                           socklen_t* srclen,
+                                           std::error_code& ec, int flags) {
+    static_assert(K::type == SOCK_DGRAM,
+                  "policy_socket::rcvfrom() needs policy::datagram");
+
+    if (C::enabled && bad_arguments(buf, len)) return result(-1, ec);
+
+    return result(::recvfrom(fd, buf, len, flags | B::msg_flags,
+                             reinterpret_cast<struct sockaddr*>(src), srclen),
+                  ec);
+}
+
+/*
+ * With policy::checked: throws unless descriptor is a socket of type K::type.
+ */
+template <typename K, typename B, typename E, typename C>
+void policy_socket<K, B, E, C>::check_type(int descriptor) {
+    if (!C::enabled || descriptor < 0) return;
+
+    int type;
+    socklen_t len = sizeof(type);
+
+    if (0 > getsockopt(descriptor, SOL_SOCKET, SO_TYPE, &type, &len))
+        throw socket_exception(__FILE__, __LINE__,
+                               "policy_socket::policy_socket() - Not a "
+                               "socket!");
+    if (type != K::type)
+        throw socket_exception(__FILE__, __LINE__,
+                               "policy_socket::policy_socket() - Wrong socket "
+                               "type!",
+                               false);
+}
+
+/*
+ * Sets errno and returns nonzero if the descriptor or buffer is unusable.
+ */
+template <typename K, typename B, typename E, typename C>
+int policy_socket<K, B, E, C>::bad_arguments(const void* buf,
+                                             size_t len) const {
+    if (fd < 0)
+        errno = EBADF;
+    else if (buf == NULL && len > 0)
+        errno = EINVAL;
+    else
+        return 0;
+
+    return 1;
+}
+
+/*
+ * Applies the error policy to the return value of a system call.
+ */
+template <typename K, typename B, typename E, typename C>
+ssize_t policy_socket<K, B, E, C>::result(ssize_t ret,
+                                          const char* message) const {
+    if (E::throws && ret < 0 &&
+        !(B::dontwait && (errno == EAGAIN || errno == EWOULDBLOCK)))
+        throw socket_exception(__FILE__, __LINE__, message);
+
+    return ret;
+}
+
+template <typename K, typename B, typename E, typename C>
+ssize_t policy_socket<K, B, E, C>::result(ssize_t ret,
+                                          std::error_code& ec) const {
+    if (ret < 0)
+        ec.assign(errno, std::system_category());
+    else
+        ec.clear();
+
+    return ret;
+}
+
+/**
+ * @}
+ */
+}  // namespace libsocket
+#endif
@@ -0,0 +1,183 @@
+#ifndef LIBSOCKET_RESOLVER_H_0D09A863FBBF4CA4B2B920FB06EDF13C
+#define LIBSOCKET_RESOLVER_H_0D09A863FBBF4CA4B2B920FB06EDF13C
+
+#include <netdb.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "libinetsocket.h"
+#include "socket.hpp"
+
+/**
+ * @file resolver.hpp
+ * @brief Cached and asynchronous name resolution.
+ */
+/*
+   The committers of the libsocket project, all rights reserved
+   (c) 2012, dermesser <lbo@spheniscida.de>
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS” AND ANY
+   EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+   DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+namespace libsocket {
+using std::string;
+
+/**
+ * @addtogroup libsocketplusplus
+ * @{
+ */
+
+/**
+ * @brief The addresses a host/port pair resolved to, or the reason it did not.
+ *
+ * Immutable once created, so it can be shared between threads and cache
+ * users.
+ */
+class resolved_addresses {
+   public:
+    resolved_addresses(int error, const struct addrinfo* list);
+    resolved_addresses(const resolved_addresses&) = delete;
+
+    /// 0, or the `EAI_*` code returned by `getaddrinfo(3)`.
+    int error(void) const { return err; }
+    /// The addresses as a `getaddrinfo(3)`-style list; NULL if there are none.
+    /// Do not pass it to `freeaddrinfo(3)`.
+    const struct addrinfo* list(void) const {
+        return entries.empty() ? NULL : &entries[0];
+    }
+    /// Number of addresses.
+    size_t size(void) const { return entries.size(); }
+
+   private:
+    int err;
+    std::vector<struct addrinfo> entries;
+    std::vector<struct sockaddr_storage> addrs;
+};
+
+/**
+ * @brief Resolves host names with `getaddrinfo(3)`, remembering the answers
+ * for a while.
+ *
+ * All lookups of the library's string-based functions
+ * (`inet_stream::connect()`, `inet_dgram_client::connect()`,
+ * `inet_dgram::sndto()`, ...) go through `lookup()`, which can consult a
+ * cache shared by the whole process first. The cache is off by default;
+ * `set_cache_ttl()` enables it. Successful lookups are then kept for the
+ * positive TTL, failed ones ("no such host") for the negative TTL.
+ * `getaddrinfo(3)` does not report the TTL of the DNS records, so these are
+ * fixed upper bounds. Setting both to 0 disables the cache again.
+ *
+ * A resolver object additionally resolves names in the background: `resolve()`
+ * queues a lookup for one of its worker threads and returns at once. Finished
+ * lookups are collected with `next()`. The resolver is a `socket` whose file
+ * descriptor becomes readable when results are waiting, so it can be added to
+ * an `epollset<socket>` (or a `selectset<socket>`):
+ *
+ *     resolver res;
+ *     epollset<libsocket::socket> set;
+ *
+ *     set.add_fd(res, LIBSOCKET_READ);
+ *     uint64_t id = res.resolve("example.com", "443");
+ *
+ *     while (...) {
+ *         auto ready = set.wait();
+ *
+ *         for (socket* s : ready.first) {
+ *             if (s == &res) {
+ *                 resolver::completion done;
+ *
+ *                 while (res.next(&done))
+ *                     ... done.addresses->list() ...
+ *             }
+ *         }
+ *     }
+ *
+ * Answers found in the cache are delivered the same way, without involving a
+ * thread.
+ *
+ * The static functions are threadsafe; a resolver object may only be used
+ * from one thread at a time.
+ */
+class resolver : public socket {
+   public:
+    /// A finished background lookup.
+    struct completion {
+        uint64_t id;  ///< As returned by `resolve()`
+        string host;
+        string port;
+        std::shared_ptr<const resolved_addresses> addresses;
+    };
+
+    explicit resolver(size_t threads = 2);
+    resolver(const resolver&) = delete;
+    resolver(resolver&&) = delete;
+    ~resolver(void);
+
+    uint64_t resolve(const string& host, const string& port,
+                     int proto_osi3 = LIBSOCKET_BOTH,
+                     int socktype = SOCK_STREAM);
+    bool next(completion* result);
+    /// Number of lookups that have been queued but not collected yet.
+    size_t pending(void) const { return outstanding; }
+
+    static std::shared_ptr<const resolved_addresses> lookup(
+        const char* host, const char* port, int family, int socktype);
+    static void set_cache_ttl(unsigned int positive_ms,
+                              unsigned int negative_ms);
+    static void flush_cache(void);
+
+   private:
+    struct request {
+        uint64_t id;
+        string host;
+        string port;
+        int family;
+        int socktype;
+    };
+
+    std::vector<std::thread> threads;
+    std::mutex lock;  ///< Protects the queues and `stopping`
+    std::condition_variable wakeup;
+    std::deque<request> requests;
+    std::deque<completion> completions;
+    bool stopping;
+
+    uint64_t next_id;
+    size_t outstanding;
+    int notify_fd;  ///< Written to signal completions; may equal `sfd`
+
+    void run(void);
+    void deliver(completion&& c);
+};
+
+/**
+ * @}
+ */
+}  // namespace libsocket
+#endif
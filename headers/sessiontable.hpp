@@ -0,0 +1,433 @@
+#ifndef LIBSOCKET_SESSIONTABLE_H_47C670EE94E74CBD93A95466C8BD3CFF
+#define LIBSOCKET_SESSIONTABLE_H_47C670EE94E74CBD93A95466C8BD3CFF
+
+#include <stdint.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <deque>
+#include <vector>
+
+#include "dgrambatch.hpp"
+#include "timerwheel.hpp"
+
+/**
+ * @file sessiontable.hpp
+ * @brief [LINUX-only] Per-peer state for datagram servers, keyed by the
+ * binary peer address.
+ */
+/*
+   The committers of the libsocket project, all rights reserved
+   (c) 2012, dermesser <lbo@spheniscida.de>
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS” AND ANY
+   EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+   DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+namespace libsocket {
+
+/**
+ * @addtogroup libsocketplusplus
+ * @{
+ */
+
+/**
+ * @brief IPv4 or IPv6 address and port in a fixed-size form that can be
+ * compared with `memcmp()` and hashed cheaply.
+ *
+ * IPv4 addresses are stored as IPv4-mapped IPv6 addresses.
+ */
+struct session_key {
+    uint8_t addr[16];
+    uint16_t port;    ///< Network byte order
+    uint16_t family;  ///< `AF_INET` or `AF_INET6`
+    uint32_t scope;   ///< IPv6 scope id
+
+    bool set(const struct sockaddr* sa);
+    socklen_t get(struct sockaddr_storage* ss) const;
+    uint32_t hash(void) const;
+
+    bool operator==(const session_key& other) const {
+        return 0 == memcmp(this, &other, sizeof(*this));
+    }
+};
+
+/**
+ * @brief Hash table of per-peer state for UDP servers, with eviction of idle
+ * peers.
+ *
+ * The table maps a peer's `sockaddr_in`/`sockaddr_in6` -- as returned by
+ * `rcvmmsg()` in a `dgram_batch` or by `recvfrom(2)` -- to a `SessionT`
+ * object, without ever converting the address to a string. `dispatch()` looks
+ * up the session of every datagram in a batch (creating it if necessary) and
+ * calls a handler with it:
+ *
+ *     struct peer { unsigned long packets = 0; };
+ *     dgram_session_table<peer> sessions(30 * 1000000);  // 30 s idle timeout
+ *
+ *     while (...) {
+ *         server.rcvmmsg(batch);
+ *         sessions.dispatch(batch, [](peer& p, dgram_batch& b, size_t i) {
+ *             p.packets++;  // b.data(i), b.length(i)...
+ *         });
+ *         sessions.expire(timer_wheel::now());
+ *     }
+ *
+ * New sessions are value-initialized `SessionT` objects, so a handler can
+ * recognize them by their state. Sessions that have not received a datagram
+ * for `idle_timeout` microseconds are removed by `expire()`; its callback
+ * sees each evicted session before it is destroyed. `next_timeout()` tells an
+ * event loop when `expire()` has to be called next.
+ *
+ * Lookups use open addressing with linear probing over a table of (hash,
+ * index) pairs, which grows when it is half full; deletion shifts entries back
+ * instead of leaving tombstones. The sessions themselves are not moved, so
+ * pointers to them stay valid until they are evicted or erased.
+ *
+ * THIS CLASS IS NOT THREADSAFE. Use one table per thread, e.g. one per shard
+ * of an `inet_dgram_sharded_server`.
+ */
+template <typename SessionT>
+class dgram_session_table {
+   public:
+    explicit dgram_session_table(uint64_t idle_timeout,
+                                 size_t expected_sessions = 1024);
+    dgram_session_table(const dgram_session_table&) = delete;
+
+    SessionT* find(const struct sockaddr* addr);
+    SessionT* get(const struct sockaddr* addr, uint64_t now,
+                  bool* created = NULL);
+    bool erase(const struct sockaddr* addr);
+
+    template <typename Handler>
+    size_t dispatch(dgram_batch& batch, Handler handler);
+
+    template <typename Evict>
+    size_t expire(uint64_t now, Evict evict);
+    size_t expire(uint64_t now);
+
+    /// Milliseconds until `expire()` has to be called; -1 if there are no
+    /// sessions.
+    int next_timeout(uint64_t now) const { return wheel.timeout_ms(now); }
+
+    /// Number of sessions.
+    size_t size(void) const { return count; }
+
+   private:
+    static const uint32_t empty = 0xffffffff;
+
+    struct node {
+        session_key key;
+        uint32_t hash;
+        uint32_t generation;  ///< Incremented whenever the node is freed
+        bool used;
+        uint64_t last_active;
+        SessionT state;
+    };
+
+    struct bucket {
+        uint32_t hash;
+        uint32_t node;  ///< Index into `nodes`, or `empty`
+    };
+
+    std::deque<node> nodes;
+    std::vector<uint32_t> free_nodes;
+    std::vector<bucket> buckets;
+    size_t mask;
+    size_t count;
+
+    uint64_t timeout;
+    timer_wheel wheel;
+
+    // Wheel resolution: a 256th of the timeout, but at least a millisecond.
+    static uint64_t resolution(uint64_t t) { return t / 256 > 1000 ? t / 256 : 1000; }
+
+    size_t lookup(const session_key& key, uint32_t hash) const;
+    void grow(void);
+    void remove(size_t pos);
+};
+
+/**
+ * @brief Constructor.
+ *
+ * @param idle_timeout Microseconds after which a session without datagrams is
+ * evicted.
+ * @param expected_sessions Initial capacity; the table grows beyond it if
+ * necessary.
+ */
+template <typename SessionT>
+dgram_session_table<SessionT>::dgram_session_table(uint64_t idle_timeout,
+                                                   size_t expected_sessions)
+    : count(0),
+      timeout(idle_timeout),
+      wheel(512, resolution(idle_timeout)) {
+    size_t size = 16;
+
+    while (size < 2 * expected_sessions) size *= 2;
+
+    bucket none = {0, empty};
+
+    buckets.assign(size, none);
+    mask = size - 1;
+}
+
+/**
+ * @brief Look up the session of a peer.
+ *
+ * @returns NULL if there is none.
+ */
+template <typename SessionT>
+SessionT* dgram_session_table<SessionT>::find(const struct sockaddr* addr) {
+    session_key key;
+
+    if (!key.set(addr)) return NULL;
+
+    size_t pos = lookup(key, key.hash());
+
+    return buckets[pos].node == empty ? NULL : &nodes[buckets[pos].node].state;
+}
+
+/**
+ * @brief Look up the session of a peer, creating it if there is none, and
+ * mark it as active at `now` (see `timer_wheel::now()`).
+ *
+ * @param created Set to whether the session is new.
+ *
+ * @returns NULL if `addr` is neither an IPv4 nor an IPv6 address.
+ */
+template <typename SessionT>
+SessionT* dgram_session_table<SessionT>::get(const struct sockaddr* addr,
+                                             uint64_t now, bool* created) {
+    session_key key;
+
+    if (!key.set(addr)) return NULL;
+
+    uint32_t hash = key.hash();
+    size_t pos = lookup(key, hash);
+
+    if (buckets[pos].node != empty) {
+        node& n = nodes[buckets[pos].node];
+
+        n.last_active = now;
+        if (created) *created = false;
+
+        return &n.state;
+    }
+
+    if (2 * (count + 1) > buckets.size()) {
+        grow();
+        pos = lookup(key, hash);
+    }
+
+    uint32_t index;
+
+    if (free_nodes.empty()) {
+        index = nodes.size();
+        nodes.push_back(node());
+        nodes.back().generation = 0;
+    } else {
+        index = free_nodes.back();
+        free_nodes.pop_back();
+    }
+
+    node& n = nodes[index];
+
+    n.key = key;
+    n.hash = hash;
+    n.used = true;
+    n.last_active = now;
+
+    buckets[pos].hash = hash;
+    buckets[pos].node = index;
+    count++;
+
+    wheel.schedule(uint64_t(n.generation) << 32 | index, now + timeout);
+
+    if (created) *created = true;
+
+    return &n.state;
+}
+
+/**
+ * @brief Remove the session of a peer at once.
+ *
+ * @returns false if there was none.
+ */
+template <typename SessionT>
+bool dgram_session_table<SessionT>::erase(const struct sockaddr* addr) {
+    session_key key;
+
+    if (!key.set(addr)) return false;
+
+    size_t pos = lookup(key, key.hash());
+
+    if (buckets[pos].node == empty) return false;
+
+    remove(pos);
+
+    return true;
+}
+
+/**
+ * @brief Call `handler(SessionT&, dgram_batch&, size_t)` for every datagram
+ * of a received batch, with the session of its sender.
+ *
+ * Datagrams from other than IPv4/IPv6 peers are skipped.
+ *
+ * @returns The number of datagrams passed to the handler.
+ */
+template <typename SessionT>
+template <typename Handler>
+size_t dgram_session_table<SessionT>::dispatch(dgram_batch& batch,
+                                               Handler handler) {
+    uint64_t now = timer_wheel::now();
+    size_t handled = 0;
+
+    for (size_t i = 0; i < batch.size(); i++) {
+        SessionT* session = get(batch.address(i), now);
+
+        if (session == NULL) continue;
+
+        handler(*session, batch, i);
+        handled++;
+    }
+
+    return handled;
+}
+
+/**
+ * @brief Evict sessions that have been idle for the timeout.
+ *
+ * `evict(SessionT&, const session_key&)` is called for each of them before
+ * it is removed.
+ *
+ * @returns The number of evicted sessions.
+ */
+template <typename SessionT>
+template <typename Evict>
+size_t dgram_session_table<SessionT>::expire(uint64_t now, Evict evict) {
+    size_t evicted = 0;
+
+    wheel.expire(now, [this, now, &evict, &evicted](uint64_t timer) {
+        uint32_t index = timer & 0xffffffff;
+        node& n = nodes[index];
+
+        // The session has already been removed.
+        if (!n.used || n.generation != timer >> 32) return;
+
+        // Not `now - last_active`: get() and dispatch() may have seen a
+        // later time than `now`.
+        if (n.last_active + timeout > now) {
+            wheel.schedule(timer, n.last_active + timeout);
+            return;
+        }
+
+        evict(n.state, n.key);
+        remove(lookup(n.key, n.hash));
+        evicted++;
+    });
+
+    return evicted;
+}
+
+/**
+ * @brief Evict sessions that have been idle for the timeout.
+ */
+template <typename SessionT>
+size_t dgram_session_table<SessionT>::expire(uint64_t now) {
+    return expire(now, [](SessionT&, const session_key&) {});
+}
+
+// Position of the key's bucket, or of the empty bucket where it belongs.
+template <typename SessionT>
+size_t dgram_session_table<SessionT>::lookup(const session_key& key,
+                                             uint32_t hash) const {
+    size_t pos = hash & mask;
+
+    while (buckets[pos].node != empty) {
+        if (buckets[pos].hash == hash && nodes[buckets[pos].node].key == key)
+            break;
+
+        pos = (pos + 1) & mask;
+    }
+
+    return pos;
+}
+
+template <typename SessionT>
+void dgram_session_table<SessionT>::grow(void) {
+    std::vector<bucket> old;
+    bucket none = {0, empty};
+
+    old.swap(buckets);
+    buckets.assign(2 * old.size(), none);
+    mask = buckets.size() - 1;
+
+    for (size_t i = 0; i < old.size(); i++) {
+        if (old[i].node == empty) continue;
+
+        size_t pos = old[i].hash & mask;
+
+        while (buckets[pos].node != empty) pos = (pos + 1) & mask;
+
+        buckets[pos] = old[i];
+    }
+}
+
+// Frees the session in bucket `pos` and closes the gap by moving later
+// entries of the probe sequence back.
+template <typename SessionT>
+void dgram_session_table<SessionT>::remove(size_t pos) {
+    node& n = nodes[buckets[pos].node];
+
+    n.used = false;
+    n.generation++;
+    n.state = SessionT();
+    free_nodes.push_back(buckets[pos].node);
+    count--;
+
+    size_t next = pos;
+
+    while (true) {
+        buckets[pos].node = empty;
+
+        while (true) {
+            next = (next + 1) & mask;
+
+            if (buckets[next].node == empty) return;
+
+            size_t home = buckets[next].hash & mask;
+
+            // Move the entry unless its home lies cyclically in (pos, next].
+            if (pos <= next ? (home <= pos || home > next)
+                            : (home <= pos && home > next))
+                break;
+        }
+
+        buckets[pos] = buckets[next];
+        pos = next;
+    }
+}
+
+/**
+ * @}
+ */
+}  // namespace libsocket
+#endif
@@ -0,0 +1,120 @@
+#ifndef LIBSOCKET_SHARDEDSERVERDGRAM_H_75026AE39BFF4DBEAC6EFD712D81477A
+#define LIBSOCKET_SHARDEDSERVERDGRAM_H_75026AE39BFF4DBEAC6EFD712D81477A
+
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dgrambatch.hpp"
+#include "inetserverdgram.hpp"
+
+/**
+ * @file shardedserverdgram.hpp
+ * @brief [LINUX-only] UDP server using one socket and thread per shard.
+ */
+/*
+   The committers of the libsocket project, all rights reserved
+   (c) 2012, dermesser <lbo@spheniscida.de>
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS” AND ANY
+   EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+   DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+namespace libsocket {
+using std::string;
+
+/**
+ * @addtogroup libsocketplusplus
+ * @{
+ */
+
+/**
+ * @brief A UDP server that spreads its load over several threads.
+ *
+ * The server binds `shards` sockets to the same address using `SO_REUSEPORT`,
+ * so the kernel keeps one receive queue per socket and distributes incoming
+ * datagrams between them. `start()` runs one thread per socket, which
+ * receives datagrams in batches with `recvmmsg(2)` and passes them to a
+ * handler.
+ *
+ * By default, the kernel picks the socket by hashing source and destination
+ * address, so all datagrams of one flow go to the same thread. Optionally, a
+ * small classic BPF program chooses the socket instead:
+ *
+ * - `steer_cpu`: by the CPU that processed the packet (`SKF_AD_CPU`), modulo
+ *   the number of shards. Shard i's thread is pinned to the CPUs c with
+ *   c % shards == i, so a packet is handled on the CPU that received it if the
+ *   NIC's RSS spreads flows over the CPUs.
+ * - `steer_hash`: by the receive hash computed by the NIC (`SKF_AD_RXHASH`),
+ *   modulo the number of shards. Falls back to shard 0 for packets without
+ *   such a hash (e.g. on loopback).
+ *
+ * The handler is called from the shard threads, i.e. concurrently for
+ * different shards. It may use the shard's socket to answer, e.g. by calling
+ * `sndmmsg()` with the batch it got. Exceptions thrown by the handler stop
+ * the shard's thread and are rethrown by `stop()`.
+ */
+class inet_dgram_sharded_server {
+   public:
+    enum steering { steer_kernel, steer_cpu, steer_hash };
+
+    /// Called with the shard number, the shard's socket and the received
+    /// datagrams.
+    typedef std::function<void(size_t, inet_dgram_server&, dgram_batch&)>
+        handler;
+
+    inet_dgram_sharded_server(const string& host, const string& port,
+                              int proto_osi3, size_t shards,
+                              steering steer = steer_kernel,
+                              size_t batch_size = 64,
+                              size_t dgram_size = 2048);
+    inet_dgram_sharded_server(const inet_dgram_sharded_server&) = delete;
+    ~inet_dgram_sharded_server(void);
+
+    /// Number of shards.
+    size_t size(void) const { return sockets.size(); }
+    inet_dgram_server& shard(size_t i);
+
+    void start(const handler& h);
+    void stop(void);
+
+   private:
+    std::vector<std::unique_ptr<inet_dgram_server>> sockets;
+    std::vector<std::thread> threads;
+    std::vector<std::exception_ptr> errors;
+    steering steer;
+    size_t batch_size;
+    size_t dgram_size;
+
+    int stop_pipe[2];  ///< Becomes readable when the threads should exit
+
+    void attach_filter(void);
+    void run(size_t i, handler h);
+};
+
+/**
+ * @}
+ */
+}  // namespace libsocket
+#endif
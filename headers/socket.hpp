@@ -5,6 +5,10 @@
 #include <sys/types.h>
 
 #include <errno.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <functional>
 
 #include "exception.hpp"
 
@@ -62,6 +66,25 @@ namespace libsocket {
  * @addtogroup libsocketplusplus
  * @{
  */
+/**
+ * @brief Completion notification for zero-copy sends; see
+ * `socket::reap_zerocopy()`.
+ *
+ * The buffers passed to the sends with ids `first` through `last` (inclusive;
+ * ids wrap around at 2^32) are no longer used by the kernel and may be
+ * modified or freed.
+ */
+struct zerocopy_completion {
+    uint32_t first;  ///< Id of the first completed send
+    uint32_t last;   ///< Id of the last completed send
+    /// The kernel copied the data after all (e.g. on loopback), so zero-copy
+    /// mode did not help for these sends.
+    bool copied;
+};
+
+template <typename Kind, typename Blocking, typename Errors, typename Checks>
+class policy_socket;
+
 /**
  * @brief socket is the base class of every other libsocket++ object.
  *
@@ -76,6 +99,14 @@ class socket {
     /// Default is true; if set to false, the file descriptor is not closed when
     /// the destructor is called.
     bool close_on_destructor;
+    /// If `SO_ZEROCOPY` has been enabled using `set_zerocopy()`
+    bool zerocopy;
+    /// Id the kernel will assign to the next successful zero-copy send
+    uint32_t zerocopy_next;
+
+    template <typename Kind, typename Blocking, typename Errors,
+              typename Checks>
+    friend class policy_socket;
 
    public:
     socket(void);
@@ -93,7 +124,15 @@ class socket {
     /// `close_on_destructor` is true by default. If set to false, do not call
     /// `close(2)` on the underlying socket in the destructor.
     void set_close_on_destructor(bool cod) { close_on_destructor = cod; }
+
+    void set_zerocopy(bool enable = true);
+    size_t reap_zerocopy(
+        const std::function<void(const zerocopy_completion&)>& callback);
+
+    void set_timestamps(bool enable = true);
 };
+
+bool receive_timestamp(const struct msghdr* msg, struct timespec* stamp);
 /**
  * @}
  */
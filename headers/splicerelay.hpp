@@ -0,0 +1,161 @@
+#ifndef LIBSOCKET_SPLICERELAY_H_C493B39EDE0F4D77B11AD72CA3CACC65
+#define LIBSOCKET_SPLICERELAY_H_C493B39EDE0F4D77B11AD72CA3CACC65
+
+#include "epoll.hpp"
+#include "streamclient.hpp"
+
+/**
+ * @file splicerelay.hpp
+ * @brief [LINUX-only] Relay data between two stream sockets inside the kernel.
+ */
+/*
+   The committers of the libsocket project, all rights reserved
+   (c) 2012, dermesser <lbo@spheniscida.de>
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS” AND ANY
+   EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+   DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+namespace libsocket {
+/**
+ * @addtogroup libsocketplusplus
+ * @{
+ */
+
+/**
+ * @brief Copies everything received on one stream socket to another one and
+ * vice versa, without the data ever entering user space.
+ *
+ * Each direction owns a pipe; data is moved from the source socket into the
+ * pipe and from the pipe to the destination socket with `splice(2)`. When one
+ * side sends EOF, the other side is shut down for writing once everything
+ * received before has been passed on, so half-closed connections work as
+ * expected. The relay is done when both directions have seen EOF.
+ *
+ * Both sockets are switched to non-blocking mode; `pump()` moves as much data
+ * as possible without blocking and then returns. Use it with an `epollset`:
+ *
+ *     epollset<stream_client_socket> set;
+ *     splice_relay relay(client, upstream);
+ *     relay.watch(set);
+ *
+ *     while (...) {
+ *         auto ready = set.wait();
+ *         // Find the relay belonging to each ready socket (e.g. using a map
+ *         // from socket pointers to relays), then:
+ *         if (!relay.update(set)) { ... destroy relay and sockets ... }
+ *     }
+ *
+ * `update()` re-arms each socket only for the events the relay is waiting
+ * for, so a relay whose destination is congested does not spin on its source.
+ *
+ * The relay does not own the sockets; they must outlive it.
+ *
+ * THIS CLASS IS NOT THREADSAFE.
+ */
+class splice_relay {
+   public:
+    splice_relay(stream_client_socket& a, stream_client_socket& b,
+                 size_t pipe_size = 0);
+    splice_relay(const splice_relay&) = delete;
+    ~splice_relay(void);
+
+    bool pump(void);
+    bool done(void) const;
+
+    int interest(const stream_client_socket& sock) const;
+
+    template <typename SocketT>
+    void watch(epollset<SocketT>& set);
+    template <typename SocketT>
+    bool update(epollset<SocketT>& set);
+
+    /// Bytes relayed from `a` to `b`.
+    unsigned long long bytes_forward(void) const { return dirs[0].total; }
+    /// Bytes relayed from `b` to `a`.
+    unsigned long long bytes_backward(void) const { return dirs[1].total; }
+
+   private:
+    struct direction {
+        stream_client_socket* from;
+        stream_client_socket* to;
+        int pipefd[2];
+        size_t in_pipe;  ///< Bytes in the pipe, not yet written to `to`
+        bool eof;        ///< `from` has sent EOF
+        bool closed;     ///< `to` has been shut down for writing
+        bool congested;  ///< The last write to `to` returned EAGAIN
+        unsigned long long total;
+    };
+
+    stream_client_socket& a;
+    stream_client_socket& b;
+    direction dirs[2];
+    size_t chunk;    ///< Capacity of each pipe
+    int watched[2];  ///< Events `a` and `b` are currently registered for
+
+    void pump(direction& dir);
+    bool drain(direction& dir);
+};
+
+/**
+ * @brief Add both sockets to an epollset.
+ */
+template <typename SocketT>
+void splice_relay::watch(epollset<SocketT>& set) {
+    watched[0] = interest(a);
+    watched[1] = interest(b);
+
+    set.add_fd(a, watched[0]);
+    set.add_fd(b, watched[1]);
+}
+
+/**
+ * @brief Relay what can be relayed and re-arm the sockets in `set`.
+ *
+ * Call this whenever `set` reports one of the relay's sockets as ready.
+ *
+ * @returns `false` if the relay is done; the sockets have been removed from
+ * `set` then.
+ */
+template <typename SocketT>
+bool splice_relay::update(epollset<SocketT>& set) {
+    if (!pump()) {
+        set.del_fd(a);
+        set.del_fd(b);
+        return false;
+    }
+
+    int now[2] = {interest(a), interest(b)};
+
+    if (now[0] != watched[0]) set.mod_fd(a, now[0]);
+    if (now[1] != watched[1]) set.mod_fd(b, now[1]);
+
+    watched[0] = now[0];
+    watched[1] = now[1];
+
+    return true;
+}
+
+/**
+ * @}
+ */
+}  // namespace libsocket
+#endif
@@ -2,6 +2,9 @@
 #define LIBSOCKET_STREAMCLIENT_H_4EF38CC5CAD740E6B7A55BCF4C48CCFA
 
 #include <string>
+#include <system_error>
+#include "bytespan.hpp"
+#include "mappedspan.hpp"
 #include "socket.hpp"
 
 /**
@@ -39,6 +42,11 @@
 namespace libsocket {
 using std::string;
 class dgram_over_stream;
+class stream_reader;
+class splice_relay;
+class connection_pool;
+class stream_handle;
+class pooled_buffer;
 
 /** @addtogroup libsocketplusplus
  * @{
@@ -64,14 +72,40 @@ class stream_client_socket : public virtual socket {
 
     ssize_t snd(const void* buf, size_t len, int flags = 0);  // flags: send()
     ssize_t rcv(void* buf, size_t len, int flags = 0);        // flags: recv()
+    ssize_t rcv(void* buf, size_t len, struct timespec* stamp, int flags = 0);
+    ssize_t rcv(pooled_buffer& buf, int flags = 0);
+
+    // Non-throwing
+    ssize_t snd(const void* buf, size_t len, std::error_code& ec,
+                int flags = 0);
+    ssize_t rcv(void* buf, size_t len, std::error_code& ec, int flags = 0);
+
+    ssize_t snd(byte_span data, int flags = 0);
+    ssize_t snd(byte_span data, std::error_code& ec, int flags = 0);
+
+    ssize_t send_file(int fd, off_t offset, size_t count);
+
+    ssize_t snd_zerocopy(const void* buf, size_t len, uint32_t* id,
+                         int flags = 0);
+    ssize_t rcv_mapped(mapped_span* span, size_t len);
+
+    void set_notsent_lowat(unsigned int bytes);
 
     friend stream_client_socket& operator<<(stream_client_socket& sock,
                                             const char* str);
     friend stream_client_socket& operator<<(stream_client_socket& sock,
                                             const string& str);
+#if LIBSOCKET_HAVE_STRING_VIEW
+    friend stream_client_socket& operator<<(stream_client_socket& sock,
+                                            std::string_view str);
+#endif
     friend stream_client_socket& operator>>(stream_client_socket& sock,
                                             string& dest);
     friend class dgram_over_stream;
+    friend class stream_reader;
+    friend class splice_relay;
+    friend class connection_pool;
+    friend class stream_handle;
 
     void shutdown(int method = LIBSOCKET_WRITE);
 };
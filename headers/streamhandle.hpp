@@ -0,0 +1,137 @@
+#ifndef LIBSOCKET_STREAMHANDLE_H_AB3935D57E8A416EAB46FE3F15E3F1B6
+#define LIBSOCKET_STREAMHANDLE_H_AB3935D57E8A416EAB46FE3F15E3F1B6
+
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <memory>
+#include <string>
+#include <system_error>
+
+#include "streamclient.hpp"
+
+/**
+ * @file streamhandle.hpp
+ * @brief A compact handle for connected stream sockets.
+ */
+/*
+   The committers of the libsocket project, all rights reserved
+   (c) 2012, dermesser <lbo@spheniscida.de>
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS” AND ANY
+   EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+   DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+namespace libsocket {
+using std::string;
+
+/**
+ * @addtogroup libsocketplusplus
+ * @{
+ */
+
+/**
+ * @brief A connected stream socket (TCP or UNIX) in 8 bytes.
+ *
+ * An `inet_stream` has virtual bases, a vtable pointer and four strings, so it
+ * takes about 200 bytes plus heap memory for the addresses. That matters for
+ * servers keeping hundreds of thousands of mostly idle connections. A
+ * `stream_handle` is only the file descriptor and a few state bits; it is not
+ * virtual and stores no addresses. `getpeer()` and `getlocal()` ask the kernel
+ * when the addresses are actually needed.
+ *
+ * Handles are move-only and close the socket when destroyed. They are made by
+ * `accept()` from any listening socket, by taking over the descriptor of a
+ * `stream_client_socket` (e.g. an `inet_stream` after connecting), or from a
+ * raw descriptor.
+ *
+ * The I/O functions behave like those of `stream_client_socket`, including the
+ * non-throwing overloads. `sndmsg()`/`rcvmsg()` exchange frames in the format
+ * of `dgram_over_stream` on blocking handles.
+ *
+ * Handles can be used with `epollset<stream_handle>`. The set stores pointers
+ * to the handles, so keep them at stable addresses while they are in a set
+ * (e.g. in a `std::deque` or a preallocated array, not in a growing
+ * `std::vector`).
+ *
+ * THIS CLASS IS NOT THREADSAFE.
+ */
+class stream_handle {
+   public:
+    stream_handle(void) : fd(-1), state(0) {}
+    explicit stream_handle(int fd);
+    explicit stream_handle(std::unique_ptr<stream_client_socket> sock);
+    stream_handle(const stream_handle&) = delete;
+    stream_handle(stream_handle&& other);
+    ~stream_handle(void);
+
+    stream_handle& operator=(const stream_handle&) = delete;
+    stream_handle& operator=(stream_handle&& other);
+
+    static stream_handle accept(const socket& server, int flags = 0);
+    static stream_handle accept(const socket& server, std::error_code& ec,
+                                int flags = 0);
+
+    int getfd(void) const { return fd; }
+    explicit operator bool(void) const { return fd >= 0; }
+    bool nonblocking(void) const { return state & nonblocking_bit; }
+
+    int release(void);
+    int destroy(void);
+
+    ssize_t snd(const void* buf, size_t len, int flags = 0);
+    ssize_t rcv(void* buf, size_t len, int flags = 0);
+    ssize_t snd(const void* buf, size_t len, std::error_code& ec,
+                int flags = 0);
+    ssize_t rcv(void* buf, size_t len, std::error_code& ec, int flags = 0);
+    ssize_t snd(byte_span data, int flags = 0);
+    ssize_t snd(byte_span data, std::error_code& ec, int flags = 0);
+    ssize_t rcv(pooled_buffer& buf, int flags = 0);
+
+    ssize_t sndmsg(const void* buf, size_t len);
+    ssize_t rcvmsg(void* dst, size_t len);
+    ssize_t sndmsg(const void* buf, size_t len, std::error_code& ec);
+    ssize_t rcvmsg(void* dst, size_t len, std::error_code& ec);
+    ssize_t sndmsg(byte_span msg);
+    ssize_t sndmsg(byte_span msg, std::error_code& ec);
+    ssize_t rcvmsg(pooled_buffer& dst);
+
+    void shutdown(int method = LIBSOCKET_WRITE);
+
+    void getpeer(string& host, string& port, bool numeric = true) const;
+    void getlocal(string& host, string& port, bool numeric = true) const;
+
+   private:
+    static const uint8_t nonblocking_bit = 1;
+    static const uint8_t shut_rd_bit = 2;
+    static const uint8_t shut_wr_bit = 4;
+
+    int fd;
+    uint8_t state;
+
+    bool recv_all(void* buf, size_t len, std::error_code& ec);
+};
+
+/**
+ * @}
+ */
+}  // namespace libsocket
+#endif
@@ -0,0 +1,122 @@
+#ifndef LIBSOCKET_STREAMREADER_H_8E534414010B459BBCA5CEED65837108
+#define LIBSOCKET_STREAMREADER_H_8E534414010B459BBCA5CEED65837108
+
+#include <memory>
+#include <string>
+
+#include "streamclient.hpp"
+
+/**
+ * @file streamreader.hpp
+ *
+ * Contains the stream_reader class, a buffered reader for line- and
+ * token-oriented protocols on top of stream sockets.
+ */
+/*
+   The committers of the libsocket project, all rights reserved
+   (c) 2012, dermesser <lbo@spheniscida.de>
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS” AND ANY
+   EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+   DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+namespace libsocket {
+using std::string;
+
+/**
+ * @addtogroup libsocketplusplus
+ * @{
+ */
+
+/**
+ * @brief A read-only view into memory owned by someone else.
+ *
+ * Returned by `stream_reader`; the view is only valid until the next call on
+ * the reader that produced it.
+ */
+struct buffer_view {
+    const char* data;  ///< First byte of the view
+    size_t size;       ///< Number of bytes in the view
+
+    /// Copies the viewed bytes into a new string.
+    string str(void) const { return string(data, size); }
+};
+
+/**
+ * @brief Buffered reader for delimiter-based protocols (HTTP headers, RESP,
+ * SMTP...).
+ *
+ * A stream_reader reads from a `stream_client_socket` into an internal buffer
+ * and hands out `buffer_view`s pointing into that buffer, so a line is never
+ * copied on its way to the caller. The buffer is allocated on the first read
+ * and only grows if a single token does not fit into it; consumed bytes are
+ * discarded by moving the unread rest to the front of the buffer when more
+ * space is needed.
+ *
+ * The delimiter search uses SSE2 or AVX2 if the library was compiled with
+ * support for them and `memchr(3)`/`memcmp(3)` otherwise.
+ *
+ * The reader does not own the socket; it is not permitted to use a
+ * stream_reader after the socket has been destroyed. Bytes buffered by the
+ * reader are not seen by `stream_client_socket::rcv()`, so once you have
+ * started to use a reader you should do all reads through it (`read()` gives
+ * you unbuffered access to the rest of the stream).
+ *
+ * THIS CLASS IS NOT THREADSAFE.
+ */
+class stream_reader {
+   public:
+    stream_reader(stream_client_socket& sock, size_t initial_size = 4096,
+                  size_t max_size = 1 << 20);
+    stream_reader(const stream_reader&) = delete;
+
+    ssize_t read_until(const char* delim, size_t delim_len,
+                       buffer_view* token);
+    ssize_t read_until(const string& delim, buffer_view* token);
+    ssize_t read_line(buffer_view* line);
+
+    ssize_t read(void* dst, size_t len);
+
+    /// Number of bytes received from the socket but not yet consumed.
+    size_t buffered(void) const { return end - begin; }
+
+   private:
+    stream_client_socket& sock;
+
+    std::unique_ptr<char[]> buffer;
+    size_t capacity;
+    size_t max_capacity;
+    size_t begin;  ///< First unconsumed byte
+    size_t end;    ///< One past the last received byte
+
+    // Bytes at the beginning of the unconsumed data that have already been
+    // searched for `last_delim` without success.
+    size_t scanned;
+    string last_delim;
+
+    ssize_t fill(void);
+};
+
+/**
+ * @}
+ */
+}  // namespace libsocket
+#endif
@@ -0,0 +1,103 @@
+#ifndef LIBSOCKET_TIMERWHEEL_H_AD988141CF6B49FAB4667F7B96FB28FF
+#define LIBSOCKET_TIMERWHEEL_H_AD988141CF6B49FAB4667F7B96FB28FF
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <vector>
+
+/**
+ * @file timerwheel.hpp
+ * @brief Hashed timer wheel for many cheap, coarse timers.
+ */
+/*
+   The committers of the libsocket project, all rights reserved
+   (c) 2012, dermesser <lbo@spheniscida.de>
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS” AND ANY
+   EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+   DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+namespace libsocket {
+
+/**
+ * @addtogroup libsocketplusplus
+ * @{
+ */
+
+/**
+ * @brief A hashed timer wheel: schedules keys to fire at a deadline, in O(1)
+ * per timer.
+ *
+ * Time is measured in microseconds of `CLOCK_MONOTONIC` (see `now()`) and
+ * divided into ticks of `resolution` microseconds; the wheel has one slot per
+ * tick and wraps around after `slots` ticks. Timers further in the future
+ * than one turn simply stay in their slot until they are due.
+ *
+ * Timers cannot be cancelled. Instead, the owner checks when a key fires
+ * whether it is still relevant (e.g. whether a session really has been idle
+ * long enough) and schedules it again if necessary. This keeps scheduling a
+ * `push_back()` and makes the wheel suitable for timers that are touched on
+ * every packet.
+ *
+ * A typical loop driven by an `epollset`:
+ *
+ *     auto ready = set.wait(wheel.timeout_ms(timer_wheel::now()));
+ *     ...
+ *     wheel.expire(timer_wheel::now(), [&](uint64_t key) { ... });
+ *
+ * THIS CLASS IS NOT THREADSAFE.
+ */
+class timer_wheel {
+   public:
+    explicit timer_wheel(size_t slots = 512, uint64_t resolution = 1000);
+
+    void schedule(uint64_t key, uint64_t deadline);
+    size_t expire(uint64_t now, const std::function<void(uint64_t)>& fire);
+
+    bool next_deadline(uint64_t* deadline) const;
+    int timeout_ms(uint64_t now) const;
+
+    /// Number of scheduled timers.
+    size_t size(void) const { return pending; }
+    /// Length of one tick in microseconds.
+    uint64_t resolution(void) const { return tick; }
+
+    static uint64_t now(void);
+
+   private:
+    struct entry {
+        uint64_t key;
+        uint64_t deadline;
+    };
+
+    std::vector<std::vector<entry>> slots;
+    uint64_t tick;
+    uint64_t current;  ///< First tick not completely processed yet
+    size_t pending;
+    std::vector<entry> due;  ///< Scratch space for `expire()`
+};
+
+/**
+ * @}
+ */
+}  // namespace libsocket
+#endif
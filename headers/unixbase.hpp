@@ -2,6 +2,7 @@
 #define LIBSOCKET_UNIXBASE_H_0B648A3E27324425A6B7B9F7B262E7D1
 #include <string>
 
+#include "bytespan.hpp"
 #include "socket.hpp"
 
 #include "libunixsocket.h"
@@ -56,6 +56,13 @@ class unix_dgram_client : public unix_dgram, public dgram_client_socket {
 
     void connect(const char* path);
     void connect(const string& path);
+    void connect(const char* path, std::error_code& ec);
+    void connect(const string& path, std::error_code& ec);
+#if LIBSOCKET_HAVE_STRING_VIEW
+    unix_dgram_client(std::string_view path, int flags = 0);
+    void connect(std::string_view path);
+    void connect(std::string_view path, std::error_code& ec);
+#endif
 
     void deconnect(void);
 };
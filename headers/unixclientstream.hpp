@@ -55,6 +55,17 @@ class unix_stream_client : public unix_socket, public stream_client_socket {
     void connect(const char* path, int socket_flags = 0);
     void connect(const string& path, int socket_flags = 0);
 
+    // Non-throwing
+    void connect(const char* path, std::error_code& ec, int socket_flags = 0);
+    void connect(const string& path, std::error_code& ec,
+                 int socket_flags = 0);
+#if LIBSOCKET_HAVE_STRING_VIEW
+    unix_stream_client(std::string_view path, int socket_flags = 0);
+    void connect(std::string_view path, int socket_flags = 0);
+    void connect(std::string_view path, std::error_code& ec,
+                 int socket_flags = 0);
+#endif
+
     friend class unix_stream_server;  ///< unix_stream_server returns pointer to
                                       ///< unix_stream_client objects when
                                       ///< accepting connections.
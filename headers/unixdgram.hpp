@@ -1,6 +1,8 @@
 #ifndef LIBSOCKET_UNIXDGRAM_H_B1DCD9EE9E7E4B379FD5FCA79EF4B63F
 #define LIBSOCKET_UNIXDGRAM_H_B1DCD9EE9E7E4B379FD5FCA79EF4B63F
 
+#include <system_error>
+
 #include "unixbase.hpp"
 
 /**
@@ -35,6 +37,7 @@
 */
 
 namespace libsocket {
+class pooled_buffer;
 /** @addtogroup libsocketplusplus
  * @{
  */
@@ -50,6 +53,11 @@ class unix_dgram : public unix_socket {
                   int sendto_flags = 0);
 
     ssize_t sndto(const string& buf, const string& path, int sendto_flags = 0);
+#if LIBSOCKET_HAVE_STRING_VIEW
+    ssize_t sndto(const void* buf, size_t length, std::string_view path,
+                  int sendto_flags = 0);
+    ssize_t sndto(byte_span buf, std::string_view path, int sendto_flags = 0);
+#endif
 
     ssize_t rcvfrom(void* buf, size_t length, char* source, size_t source_len,
                     int recvfrom_flags = 0);
@@ -57,6 +65,22 @@ class unix_dgram : public unix_socket {
                     int recvfrom_flags = 0);
 
     ssize_t rcvfrom(string& buf, string& source, int recvfrom_flags = 0);
+    ssize_t rcvfrom(pooled_buffer& buf, string& source,
+                    int recvfrom_flags = 0);
+
+    // Non-throwing
+    ssize_t sndto(const void* buf, size_t length, const char* path,
+                  std::error_code& ec, int sendto_flags = 0);
+    ssize_t sndto(const void* buf, size_t length, const string& path,
+                  std::error_code& ec, int sendto_flags = 0);
+#if LIBSOCKET_HAVE_STRING_VIEW
+    ssize_t sndto(const void* buf, size_t length, std::string_view path,
+                  std::error_code& ec, int sendto_flags = 0);
+#endif
+    ssize_t rcvfrom(void* buf, size_t length, char* source, size_t source_len,
+                    std::error_code& ec, int recvfrom_flags = 0);
+    ssize_t rcvfrom(void* buf, size_t length, string& source,
+                    std::error_code& ec, int recvfrom_flags = 0);
 };
 /**
  * @}
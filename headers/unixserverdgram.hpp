@@ -59,6 +59,10 @@ class unix_dgram_server : public unix_dgram {
 
     void setup(const char* bindpath, int socket_flags = 0);
     void setup(const string& bindpath, int socket_flags = 0);
+#if LIBSOCKET_HAVE_STRING_VIEW
+    unix_dgram_server(std::string_view bindpath, int socket_flags = 0);
+    void setup(std::string_view bindpath, int socket_flags = 0);
+#endif
 };
 /**
  * @}
@@ -3,6 +3,7 @@
 
 #include <memory>
 #include <string>
+#include <system_error>
 
 #include "unixbase.hpp"
 #include "unixclientstream.hpp"
@@ -56,9 +57,17 @@ class unix_stream_server : public unix_socket {
 
     void setup(const char* path, int flags = 0);
     void setup(const string& path, int flags = 0);
+#if LIBSOCKET_HAVE_STRING_VIEW
+    unix_stream_server(std::string_view path, int flags = 0);
+    void setup(std::string_view path, int flags = 0);
+#endif
 
     unix_stream_client* accept(int flags = 0);
     unique_ptr<unix_stream_client> accept2(int flags = 0);
+
+    // Non-throwing
+    unix_stream_client* accept(std::error_code& ec, int flags = 0);
+    unique_ptr<unix_stream_client> accept2(std::error_code& ec, int flags = 0);
 };
 /**
  * @}
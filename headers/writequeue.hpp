@@ -0,0 +1,194 @@
+#ifndef LIBSOCKET_WRITEQUEUE_H_DCBD0401E5054FDABB4C3E322A22BC22
+#define LIBSOCKET_WRITEQUEUE_H_DCBD0401E5054FDABB4C3E322A22BC22
+
+#include <stddef.h>
+#include <atomic>
+#include <functional>
+#include <string>
+
+#include "bytespan.hpp"
+#include "streamclient.hpp"
+
+/**
+ * @file writequeue.hpp
+ * @brief A queue of outgoing data for a stream socket written by many threads.
+ */
+/*
+   The committers of the libsocket project, all rights reserved
+   (c) 2012, dermesser <lbo@spheniscida.de>
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS “AS IS” AND ANY
+   EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+   DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+namespace libsocket {
+using std::string;
+
+/**
+ * @addtogroup libsocketplusplus
+ * @{
+ */
+
+class pooled_buffer;
+struct write_queue_node;
+
+/**
+ * @brief Lets many threads send on one stream socket without a lock around
+ * the system call.
+ *
+ * `write()` appends a buffer to a lock-free list and returns; it does not wait
+ * for other writers. Whichever thread finds no flush running becomes the
+ * flusher: it takes everything queued so far and sends it with as few
+ * `writev(2)` calls as possible, in the order the `write()` calls completed.
+ * Buffers queued while it is busy are picked up by the same flusher before it
+ * stops, so every buffer is sent by exactly one thread and writes from
+ * different threads are never interleaved. A `write()` that finds the queue
+ * empty and idle sends its data right away, without queueing or copying it.
+ *
+ * With a blocking socket, the flusher blocks until its data has been sent
+ * while the other writers go on. With a non-blocking socket, a full send
+ * buffer (`EAGAIN`) ends the flush; when the queue has been passed to
+ * `watch()`, the socket is armed for `EPOLLOUT` and the thread running the
+ * `epollset` calls `flush()` when it is reported as writable:
+ *
+ *     epollset<libsocket::socket> set;
+ *     write_queue queue(*conn);  // conn is a non-blocking inet_stream
+ *
+ *     queue.watch(set);  // instead of set.add_fd(*conn, LIBSOCKET_READ)
+ *
+ *     // Worker threads: queue.write(response);
+ *
+ *     // Event loop:
+ *     auto ready = set.wait();
+ *     for (libsocket::socket* s : ready.second)
+ *         if (s == conn.get()) queue.flush();
+ *
+ * The socket is disarmed again once everything has been sent. Without
+ * `watch()`, the data stays queued after `EAGAIN` until `flush()` is called.
+ *
+ * When sending fails, the queued data is dropped and `write()` and `flush()`
+ * throw from then on.
+ *
+ * A peer that stops reading lets the queue grow without bound. With
+ * `set_watermarks()`, `write()` returns `false` once more than `high` bytes
+ * are queued, telling the producer to pause, and the resume callback runs once
+ * the queue has drained to `low` bytes. The kernel would otherwise take
+ * megabytes into the socket buffer before the queue grows at all, so
+ * `TCP_NOTSENT_LOWAT` can be set at the same time to keep unsent data in the
+ * queue, where it is counted (see `stream_client_socket::set_notsent_lowat()`):
+ *
+ *     queue.set_watermarks(1 << 20, 256 << 10, 16384);
+ *     queue.on_resume([&] { ... wake up the producers ... });
+ *
+ *     // Producer:
+ *     if (!queue.write(std::move(msg))) ... stop producing until resumed ...
+ *
+ * `write()` and `flush()` may be called from any thread. `watch()`, the
+ * constructor and the destructor may not run concurrently with them; the
+ * socket must outlive the queue. Destroying a queue drops what has not been
+ * sent yet.
+ */
+class write_queue {
+   public:
+    explicit write_queue(stream_client_socket& sock);
+    write_queue(const write_queue&) = delete;
+    ~write_queue(void);
+
+    bool write(byte_span data);
+    bool write(string&& data);
+    bool write(const pooled_buffer& buf);
+
+    void flush(void);
+
+    void set_watermarks(size_t high, size_t low, unsigned int kernel_unsent = 0);
+    void on_resume(const std::function<void(void)>& callback);
+    /// Whether the high watermark has been crossed and the queue has not
+    /// drained to the low watermark since.
+    bool paused(void) const { return full.load(); }
+
+    /// Bytes queued and not sent yet.
+    size_t queued(void) const { return bytes.load(std::memory_order_relaxed); }
+    /// Whether sending has failed; `write()` throws then.
+    bool failed(void) const { return error.load() != 0; }
+
+    template <typename SetT>
+    void watch(SetT& set, int events = LIBSOCKET_READ);
+
+   private:
+    stream_client_socket& sock;
+
+    std::atomic<write_queue_node*> incoming;  ///< LIFO, pushed by writers
+    std::atomic<bool> flushing;  ///< A thread is the flusher
+    std::atomic<bool> blocked;   ///< The last flush ended with EAGAIN
+    std::atomic<int> error;      ///< errno of the failed send, or 0
+    std::atomic<size_t> bytes;
+    std::atomic<bool> full;  ///< See `paused()`
+
+    size_t high_mark;  ///< 0: no watermarks
+    size_t low_mark;
+    std::function<void(void)> resume;
+
+    // Only used by the flusher.
+    write_queue_node* head;  ///< FIFO of buffers taken from `incoming`
+    write_queue_node* tail;
+    bool armed;  ///< The socket is registered for writing
+    std::function<void(bool)> arm;
+
+    void push(write_queue_node* node);
+    bool send_direct(const void* data, size_t len, size_t& sent);
+    void finish_direct(write_queue_node* rest);
+    void check_error(void);
+    void added(size_t n);
+    void removed(size_t n);
+    void resumed(void);
+    void kick(void);
+    void drain(void);
+    void take_incoming(void);
+    void consume(size_t n);
+    void drop_all(void);
+    void set_armed(bool on);
+};
+
+/**
+ * @brief Add the socket to an `epollset` so the queue can be flushed from its
+ * event loop.
+ *
+ * The socket is added for `events`; while data is waiting for room in the send
+ * buffer, it is also watched for writing. Do not change its events in `set`
+ * yourself while the queue is used.
+ */
+template <typename SetT>
+void write_queue::watch(SetT& set, int events) {
+    SetT* s = &set;
+    stream_client_socket* so = &sock;
+
+    set.add_fd(sock, events);
+
+    arm = [s, so, events](bool out) {
+        s->mod_fd(*so, out ? events | LIBSOCKET_WRITE : events);
+    };
+}
+
+/**
+ * @}
+ */
+}  // namespace libsocket
+#endif